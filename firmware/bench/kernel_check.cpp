@@ -0,0 +1,271 @@
+// ============================================================================
+// Control Kernel Checks (host build)
+// ============================================================================
+// Runs the header-only kernels of the motor task through known cases: PID,
+// slew limiter, setpoint profile, velocity observer, cam table and DDS
+// oscillator. Each case prints one line; the exit status is non-zero if any
+// fails. Build and run with scripts/check_kernels.sh.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../motor_controller/core/pid_controller.h"
+#include "../motor_controller/core/slew_limiter.h"
+#include "../motor_controller/core/setpoint_profile.h"
+#include "../motor_controller/core/velocity_observer.h"
+#include "../motor_controller/core/cam_table.h"
+#include "../motor_controller/core/dds_oscillator.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name, double got, double want) {
+  printf("  %-4s %-52s got %.4f, want %.4f\n", ok ? "ok" : "FAIL", name, got, want);
+  if (!ok) failures++;
+}
+
+static void checkNear(const char* name, double got, double want, double tolerance) {
+  check(fabs(got - want) <= tolerance, name, got, want);
+}
+
+// ============================================================================
+// PID
+// ============================================================================
+
+static void checkPid() {
+  printf("PID\n");
+  PidState s = {};
+
+  // 16-bit DC PWM: the integrator must hold a full-scale duty
+  PidController::setGains(s, 0.0f, 0.0f, 0.0f, 0.0f, 0.001f);
+  PidController::reset(s, 65535, 60000);
+  checkNear("reset to 60000 of 65535", PidController::integralOutput(s), 60000.0, 1.0);
+  checkNear("output holds 60000", PidController::update(s, 0, 0), 60000.0, 0.0);
+
+  PidController::setGains(s, 0.0f, 500.0f, 0.0f, 0.0f, 0.001f);
+  PidController::reset(s, 65535);
+  int32_t out = 0;
+  for (int i = 0; i < 2000; i++) out = PidController::update(s, 1000, 0);
+  checkNear("integrator saturates at +limit", out, 65535.0, 0.0);
+  for (int i = 0; i < 4000; i++) out = PidController::update(s, -1000, 0);
+  checkNear("and at -limit", out, -65535.0, 0.0);
+
+  // First-order plant: speed follows duty with a 50 ms time constant
+  PidController::setGains(s, 2.0f, 40.0f, 0.0f, 0.5f, 0.001f);
+  PidController::reset(s, 65535);
+  float speed = 0.0f;
+  for (int i = 0; i < 3000; i++) {
+    out = PidController::update(s, 20000, (int32_t)speed);
+    speed += (out - speed) * 0.02f;
+  }
+  checkNear("closed loop settles on 20000", speed, 20000.0, 20.0);
+}
+
+// ============================================================================
+// Slew Limiter
+// ============================================================================
+
+// Seconds to reach `target` from zero stepping every dt
+static double slewTime(SlewLimiter s, float target, float dt, float* peak) {
+  SlewRateLimiter::reset(s, 0.0f);
+  double t = 0.0;
+  *peak = 0.0f;
+  while (s.value != target && t < 100.0) {
+    SlewRateLimiter::step(s, target, dt);
+    if (s.value > *peak) *peak = s.value;
+    t += dt;
+  }
+  return t;
+}
+
+static void checkSlew() {
+  printf("Slew limiter\n");
+  SlewLimiter s = {0.0f, 0.0f, 50.0f, 200.0f, 0.0f};
+  float peak;
+
+  checkNear("0 to 100 at 50/s, 1 ms steps", slewTime(s, 100.0f, 0.001f, &peak), 2.0, 0.002);
+  checkNear("same ramp, 10 ms steps", slewTime(s, 100.0f, 0.01f, &peak), 2.0, 0.02);
+  check(peak <= 100.0f, "no overshoot", peak, 100.0);
+
+  SlewRateLimiter::reset(s, 100.0f);
+  double t = 0.0;
+  while (s.value != 0.0f && t < 100.0) {
+    SlewRateLimiter::step(s, 0.0f, 0.001f);
+    t += 0.001;
+  }
+  checkNear("100 to 0 at the deceleration, 200/s", t, 0.5, 0.002);
+
+  // Jerk-limited: longer than the plain ramp by about acceleration / jerk
+  s.jerk = 100.0f;
+  checkNear("S-curve 0 to 100, jerk 100/s^2", slewTime(s, 100.0f, 0.001f, &peak), 2.5, 0.05);
+  check(peak <= 100.0f, "S-curve no overshoot", peak, 100.0);
+}
+
+// ============================================================================
+// Setpoint Profile
+// ============================================================================
+
+static void checkProfile() {
+  printf("Setpoint profile\n");
+  SetpointProfile p = {};
+  p.maxSpeed = 200.0f;
+  p.acceleration = 400.0f;
+  SetpointGenerator::start(p, 0.0f, 0.0f);
+  SetpointGenerator::setTarget(p, 1000.0f);
+
+  double t = 0.0;
+  float peakSpeed = 0.0f;
+  float peakPosition = 0.0f;
+  while (!p.done && t < 100.0) {
+    SetpointGenerator::step(p, 0.001f);
+    if (fabsf(p.velocity) > peakSpeed) peakSpeed = fabsf(p.velocity);
+    if (p.position > peakPosition) peakPosition = p.position;
+    t += 0.001;
+  }
+
+  // 1000 / 200 + 200 / 400 for a trapezoid that reaches full speed
+  checkNear("1000 counts at 200/s, 400/s^2", t, 5.5, 0.02);
+  check(peakSpeed <= 200.0f * 1.0001f, "speed stays under maxSpeed", peakSpeed, 200.0);
+  // The braking curve is sampled, so the last samples may pass the target by
+  // a fraction of a count before it settles; never by a whole count
+  check(peakPosition < 1000.5f, "overshoot under half a count", peakPosition, 1000.0);
+  checkNear("ends on the target", p.position, 1000.0, 0.0);
+
+  // Reversal mid-move stays continuous and settles on the new target
+  SetpointGenerator::start(p, 0.0f, 0.0f);
+  SetpointGenerator::setTarget(p, 1000.0f);
+  for (int i = 0; i < 1000; i++) SetpointGenerator::step(p, 0.001f);
+  float before = p.position;
+  SetpointGenerator::setTarget(p, -500.0f);
+  SetpointGenerator::step(p, 0.001f);
+  checkNear("reversal keeps position continuous", p.position - before, 0.2, 0.01);
+  for (int i = 0; i < 20000 && !p.done; i++) SetpointGenerator::step(p, 0.001f);
+  checkNear("settles on the reversed target", p.position, -500.0, 0.0);
+}
+
+// ============================================================================
+// Velocity Observer
+// ============================================================================
+
+// Feeds `speed` counts/s sampled every 1 ms for `seconds`; returns the output
+static float observe(VelocityObserverState& s, const VelocityObserverConfig& c,
+                     double& position, uint32_t& nowUs, double speed, double seconds) {
+  float out = 0.0f;
+  for (int i = 0; i < (int)(seconds * 1000); i++) {
+    position += speed * 0.001;
+    nowUs += 1000;
+    out = VelocityObserver::update(s, c, (int32_t)(int64_t)floor(position), nowUs);
+  }
+  return out;
+}
+
+static void checkObserver() {
+  printf("Velocity observer\n");
+  const VelocityObserverConfig c = {50.0f, 200.0f, 20000, 500000, 100000};
+  VelocityObserverState s;
+
+  double position = 0.0;
+  uint32_t nowUs = 0;
+  VelocityObserver::reset(s, 0, nowUs);
+  checkNear("5000 counts/s", observe(s, c, position, nowUs, 5000.0, 0.5), 5000.0, 50.0);
+
+  // Counts arrive every 50 ms: the period measurement takes over
+  checkNear("20 counts/s", observe(s, c, position, nowUs, 20.0, 2.0), 20.0, 2.0);
+  checkNear("stopped reads zero", observe(s, c, position, nowUs, 0.0, 1.0), 0.0, 0.0);
+
+  // Across the int32 wrap of the count
+  position = 2147483647.0 - 500.0;
+  nowUs = 0xFFFFFFFFu - 100000;  // And of the microsecond clock
+  VelocityObserver::reset(s, (int32_t)(int64_t)floor(position), nowUs);
+  checkNear("5000 counts/s across both wraps", observe(s, c, position, nowUs, 5000.0, 0.5), 5000.0, 50.0);
+}
+
+// ============================================================================
+// Cam Table
+// ============================================================================
+
+static CamTable makeCam(CamInterpolation interpolation, bool periodic, const int32_t* points, uint16_t count) {
+  CamTable cam = {};
+  memcpy(cam.header.magic, "CAM1", 4);
+  cam.header.version = 1;
+  cam.header.interpolation = (uint8_t)interpolation;
+  cam.header.periodic = periodic ? 1 : 0;
+  cam.header.pointCount = count;
+  cam.header.masterStep = 100;
+  memcpy(cam.points, points, count * sizeof(int32_t));
+  return cam;
+}
+
+static void checkCam() {
+  printf("Cam table\n");
+  const int32_t ramp[] = {0, 1000, 3000, 4000};
+  CamTable cam = makeCam(CamInterpolation::LINEAR, false, ramp, 4);
+
+  check(cam.isValid(), "valid header", cam.isValid(), 1);
+  checkNear("linear halfway between points", (double)cam.evaluate(150), 2000.0, 0.0);
+  checkNear("holds the first point before the table", (double)cam.evaluate(-50), 0.0, 0.0);
+  checkNear("holds the last point after the table", (double)cam.evaluate(1000), 4000.0, 0.0);
+
+  // Rotary cam: one cycle is 300 master counts and 4000 slave counts
+  cam.header.periodic = 1;
+  checkNear("periodic, second cycle", (double)cam.evaluate(450), 6000.0, 0.0);
+  checkNear("periodic, negative master", (double)cam.evaluate(-150), -2000.0, 0.0);
+  checkNear("periodic, far from zero", (double)cam.evaluate(300LL * 1000000 + 150),
+            4000.0 * 1000000 + 2000.0, 0.0);
+
+  // Cubic passes through the points and stays smooth across the wrap
+  cam.header.interpolation = (uint8_t)CamInterpolation::CUBIC;
+  checkNear("cubic on a point", (double)cam.evaluate(200), 3000.0, 0.0);
+  int64_t left = cam.evaluate(299) - cam.evaluate(298);
+  int64_t right = cam.evaluate(301) - cam.evaluate(300);
+  checkNear("cubic slope continuous across the cycle", (double)(right - left), 0.0, 1.0);
+}
+
+// ============================================================================
+// DDS Oscillator
+// ============================================================================
+
+static void checkDds() {
+  printf("DDS oscillator\n");
+  double worst = 0.0;
+  for (uint32_t k = 0; k < 4096; k++) {
+    uint32_t p = k << 20;
+    double want = sin(2.0 * M_PI * k / 4096.0) * 32767.0;
+    double err = fabs(DdsOscillator::wave(WaveShape::SINE, p) - want);
+    if (err > worst) worst = err;
+  }
+  // Linear interpolation over 256 entries: (2 pi / 256)^2 / 8 of full scale
+  // (2.5 counts) plus rounding of the table and the step
+  checkNear("sine error, Q15 counts", worst, 0.0, 4.0);
+  checkNear("triangle peak at a quarter cycle", DdsOscillator::wave(WaveShape::TRIANGLE, 0x40000000u), 32767.0, 1.0);
+  checkNear("square second half", DdsOscillator::wave(WaveShape::SQUARE, 0xC0000000u), -32767.0, 0.0);
+
+  uint32_t inc = DdsOscillator::incrementFor(1.5f, 1000.0f);
+  checkNear("1.5 Hz at 1 kHz round trip", DdsOscillator::frequencyOf(inc, 1000.0f), 1.5, 1e-6);
+
+  // Two outputs a quarter cycle apart stay locked after many cycles
+  DdsOscillator a, b;
+  a.increment = b.increment = inc;
+  a.amplitude = b.amplitude = 10000;
+  b.phaseOffset = DdsOscillator::phaseFromDegrees(90.0f);
+  int32_t sa = 0, sb = 0;
+  for (int i = 0; i < 1000000; i++) {
+    sa = a.sample();
+    sb = b.sample();
+  }
+  // sin^2 + cos^2: off by the amplitude if the outputs drift out of quadrature
+  checkNear("quarter cycle apart after 1.5M ticks", hypot(sa, sb), 10000.0, 5.0);
+}
+
+int main() {
+  checkPid();
+  checkSlew();
+  checkProfile();
+  checkObserver();
+  checkCam();
+  checkDds();
+
+  printf("\n%s: %d failed\n", failures ? "FAIL" : "ok", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+// ============================================================================
+// Motion Planner Benchmark (host build)
+// ============================================================================
+// Compares the per-step cost of MotionPlanner::next() with the AccelStepper
+// 1.64 step path it replaces, and checks that both produce the same moves.
+// Build and run with scripts/bench_planner.sh.
+//
+// AccelStepperRef below reproduces the arithmetic of AccelStepper's
+// computeNewSpeed() as run once per step, including its double-precision
+// literals. On the ESP32 those doubles are software-emulated, so the gap on
+// the target is larger than the host numbers show.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../motor_controller/core/motion_planner.h"
+
+// Per-step math of AccelStepper::computeNewSpeed(), times in microseconds
+struct AccelStepperRef {
+  long currentPos = 0;
+  long targetPos = 0;
+  float speed = 0.0f;
+  float maxSpeed = 1.0f;
+  float acceleration = 1.0f;
+  float stepInterval = 0.0f;
+  long n = 0;
+  float c0 = 0.0f;
+  float cn = 0.0f;
+  float cmin = 1.0f;
+  bool directionCw = true;
+
+  void setMaxSpeed(float s) {
+    maxSpeed = s;
+    cmin = 1000000.0f / s;
+  }
+
+  void setAcceleration(float a) {
+    acceleration = a;
+    c0 = 0.676 * sqrt(2.0 / a) * 1000000.0;  // Equation 15
+  }
+
+  void moveTo(long target) {
+    targetPos = target;
+    computeNewSpeed();
+  }
+
+  void computeNewSpeed() {
+    long distanceTo = targetPos - currentPos;
+    long stepsToStop = (long)((speed * speed) / (2.0 * acceleration));
+
+    if (distanceTo == 0 && stepsToStop <= 1) {
+      stepInterval = 0;
+      speed = 0.0;
+      n = 0;
+      return;
+    }
+
+    if (distanceTo > 0) {
+      if (n > 0) {
+        if ((stepsToStop >= distanceTo) || !directionCw) n = -stepsToStop;
+      } else if (n < 0) {
+        if ((stepsToStop < distanceTo) && directionCw) n = -n;
+      }
+    } else if (distanceTo < 0) {
+      if (n > 0) {
+        if ((stepsToStop >= -distanceTo) || directionCw) n = -stepsToStop;
+      } else if (n < 0) {
+        if ((stepsToStop < -distanceTo) && !directionCw) n = -n;
+      }
+    }
+
+    if (n == 0) {
+      cn = c0;
+      directionCw = distanceTo > 0;
+    } else {
+      cn = cn - ((2.0 * cn) / ((4.0 * n) + 1));
+      cn = cn > cmin ? cn : cmin;
+    }
+    n++;
+    stepInterval = cn;
+    speed = 1000000.0 / cn;
+    if (!directionCw) speed = -speed;
+  }
+
+  // One step as run() takes it, minus the pin write and micros() poll
+  bool step() {
+    if (stepInterval == 0) return false;
+    currentPos += directionCw ? 1 : -1;
+    computeNewSpeed();
+    return true;
+  }
+};
+
+struct MoveResult {
+  long steps;
+  double seconds;   // Sum of the step intervals
+  double nsPerStep; // Best of the timed runs
+};
+
+static double nowNs() {
+  using namespace std::chrono;
+  return (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static MoveResult runReference(long distance, float maxSpeed, float accel, int repeats) {
+  MoveResult result = {0, 0.0, 1e30};
+  for (int r = 0; r < repeats; r++) {
+    AccelStepperRef s;
+    s.setMaxSpeed(maxSpeed);
+    s.setAcceleration(accel);
+
+    double start = nowNs();
+    s.moveTo(distance);
+    long steps = 0;
+    double total = 0.0;
+    while (true) {
+      float interval = s.stepInterval;
+      if (!s.step()) break;
+      total += interval;
+      steps++;
+    }
+    double ns = (nowNs() - start) / (steps > 0 ? steps : 1);
+
+    if (ns < result.nsPerStep) result.nsPerStep = ns;
+    result.steps = steps;
+    result.seconds = total * 1e-6;
+  }
+  return result;
+}
+
+// tickHz is the time base of the output: 10 MHz for the step engine, 1 MHz
+// for the task-polled 28BYJ-48
+static MoveResult runPlanner(long distance, float maxSpeed, float accel, float tickHz, int repeats) {
+  MoveResult result = {0, 0.0, 1e30};
+  for (int r = 0; r < repeats; r++) {
+    MotionRamp ramp;
+    MotionPlanner::init(ramp, tickHz, maxSpeed, accel);
+
+    double start = nowNs();
+    int32_t position = 0;
+    int8_t direction = 1;
+    long steps = 0;
+    uint64_t totalQ8 = 0;
+    bool running = MotionPlanner::next(ramp, (int32_t)distance - position, direction, direction);
+    while (running) {
+      totalQ8 += ramp.cnQ8;
+      position += direction;
+      steps++;
+      running = MotionPlanner::next(ramp, (int32_t)distance - position, direction, direction);
+    }
+    double ns = (nowNs() - start) / (steps > 0 ? steps : 1);
+
+    if (ns < result.nsPerStep) result.nsPerStep = ns;
+    result.steps = steps;
+    result.seconds = (double)totalQ8 / 256.0 / tickHz;
+  }
+  return result;
+}
+
+// Ideal trapezoid (or triangle) duration for comparison
+static double idealSeconds(long distance, double vmax, double accel) {
+  double rampSteps = vmax * vmax / (2.0 * accel);
+  if (2.0 * rampSteps >= distance) return 2.0 * sqrt((double)distance / accel);
+  return 2.0 * vmax / accel + (distance - 2.0 * rampSteps) / vmax;
+}
+
+int main(int argc, char** argv) {
+  int repeats = argc > 1 ? atoi(argv[1]) : 20;
+
+  struct Case { long distance; float maxSpeed; float accel; float tickHz; };
+  const Case cases[] = {
+    {200, 1000, 500, 10e6},        // Defaults, short move
+    {10000, 1000, 500, 10e6},      // Defaults, long cruise
+    {20000, 20000, 50000, 10e6},   // Fast NEMA17 move
+    {100000, 40000, 20000, 10e6},  // Max speed, long ramps
+    {2048, 568, 500, 1e6},         // 28BYJ-48, one revolution at 15 RPM
+  };
+
+  printf("%-8s %-8s %-8s | %-22s | %-22s | %-8s | %s\n",
+         "steps", "vmax", "accel", "AccelStepper ns/step", "MotionPlanner ns/step",
+         "speedup", "move time ref / planner / ideal (s)");
+
+  bool ok = true;
+  for (const Case& c : cases) {
+    MoveResult ref = runReference(c.distance, c.maxSpeed, c.accel, repeats);
+    MoveResult plan = runPlanner(c.distance, c.maxSpeed, c.accel, c.tickHz, repeats);
+    double ideal = idealSeconds(c.distance, c.maxSpeed, c.accel);
+
+    printf("%-8ld %-8.0f %-8.0f | %22.2f | %22.2f | %7.2fx | %.4f / %.4f / %.4f\n",
+           c.distance, c.maxSpeed, c.accel, ref.nsPerStep, plan.nsPerStep,
+           ref.nsPerStep / plan.nsPerStep, ref.seconds, plan.seconds, ideal);
+
+    // AccelStepper can overshoot by a step or two and come back; the
+    // planner must land exactly and stay within 1% of the ideal move time
+    if (ref.steps != c.distance) {
+      printf("  AccelStepper took %ld steps (overshoot and return)\n", ref.steps);
+    }
+    if (plan.steps != c.distance || fabs(plan.seconds - ideal) > 0.01 * ideal) {
+      printf("  FAIL: planner took %ld steps in %.4f s\n", plan.steps, plan.seconds);
+      ok = false;
+    }
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "api_cams.h"
+#include "api_server.h"
+#include "../core/cam_manager.h"
+
+namespace {
+  WebServer* _camsServer = nullptr;
+
+  String getCamNameFromUri() {
+    String uri = _camsServer->uri();
+    int start = uri.indexOf("/api/cams/");
+    if (start < 0) return "";
+
+    start += 10;
+    int end = uri.indexOf("/", start);
+    if (end < 0) end = uri.length();
+
+    return uri.substring(start, end);
+  }
+}
+
+void ApiCams::registerRoutes(WebServer& server) {
+  _camsServer = &server;
+
+  server.on("/api/cams", HTTP_GET, handleListCams);
+  server.on("/api/cams", HTTP_POST, handleCreateCam);
+
+  Serial.println("[API] Cam routes registered");
+}
+
+void ApiCams::handleListCams() {
+  JsonDocument doc;
+  JsonObject obj = doc.to<JsonObject>();
+  CamManager::toJson(obj);
+  ApiServer::sendJson(200, doc);
+}
+
+void ApiCams::handleGetCam() {
+  String name = getCamNameFromUri();
+  if (!CamManager::isValidName(name.c_str())) {
+    ApiServer::sendError(400, "Invalid cam name");
+    return;
+  }
+
+  if (!CamManager::camExists(name.c_str())) {
+    ApiServer::sendError(404, "Cam not found");
+    return;
+  }
+
+  JsonDocument doc;
+  JsonObject obj = doc.to<JsonObject>();
+  if (CamManager::camToJson(name.c_str(), obj)) {
+    ApiServer::sendJson(200, doc);
+  } else {
+    ApiServer::sendError(500, "Failed to load cam");
+  }
+}
+
+void ApiCams::handleCreateCam() {
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  const char* name = doc["name"] | "";
+  if (!CamManager::isValidName(name)) {
+    ApiServer::sendError(400, "Invalid cam name");
+    return;
+  }
+
+  static CamTable table;  // Loop task only; too large for its stack
+  if (!CamManager::camFromJson(doc.as<JsonObject>(), table)) {
+    ApiServer::sendError(400, "Invalid cam table");
+    return;
+  }
+
+  if (CamManager::saveCam(name, table)) {
+    JsonDocument response;
+    response["success"] = true;
+    response["message"] = "Cam created";
+    response["name"] = name;
+    response["bytes"] = table.storedSize();
+    ApiServer::sendJson(201, response);
+  } else {
+    ApiServer::sendError(500, "Failed to save cam");
+  }
+}
+
+void ApiCams::handleDeleteCam() {
+  String name = getCamNameFromUri();
+  if (!CamManager::isValidName(name.c_str())) {
+    ApiServer::sendError(400, "Invalid cam name");
+    return;
+  }
+
+  if (CamManager::deleteCam(name.c_str())) {
+    ApiServer::sendSuccess("Cam deleted");
+  } else {
+    ApiServer::sendError(404, "Cam not found");
+  }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// ============================================================================
+// Cam Tables API Endpoints
+// ============================================================================
+
+namespace ApiCams {
+  void registerRoutes(WebServer& server);
+
+  // GET /api/cams - List stored cam tables
+  void handleListCams();
+
+  // GET /api/cams/{name} - Get a cam table
+  void handleGetCam();
+
+  // POST /api/cams - Upload a cam table (stored as binary)
+  void handleCreateCam();
+
+  // DELETE /api/cams/{name} - Delete a cam table
+  void handleDeleteCam();
+}
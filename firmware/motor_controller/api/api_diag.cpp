@@ -0,0 +1,100 @@
+#include "api_diag.h"
+#include "api_server.h"
+#include "../core/loop_timing.h"
+#include "../core/encoder_capture.h"
+#include "../core/ledc_allocator.h"
+#include "../core/gpio_batch.h"
+
+void ApiDiag::registerRoutes(WebServer& server) {
+  server.on("/api/diag/timing", HTTP_GET, handleGetTiming);
+  server.on("/api/diag/timing/reset", HTTP_POST, handleResetTiming);
+  server.on("/api/diag/capture", HTTP_POST, handleArmCapture);
+  server.on("/api/diag/capture", HTTP_GET, handleGetCapture);
+  server.on("/api/diag/capture/stop", HTTP_POST, handleStopCapture);
+  server.on("/api/diag/capture/data", HTTP_GET, handleCaptureData);
+  server.on("/api/diag/pwm", HTTP_GET, handleGetPwm);
+
+  Serial.println("[API] Diagnostics routes registered");
+}
+
+void ApiDiag::handleGetTiming() {
+  JsonDocument doc;
+  JsonObject timing = doc.to<JsonObject>();
+  LoopTiming::toJson(timing);
+  JsonObject gpio = timing.createNestedObject("gpio");
+  GpioBatch::toJson(gpio);
+  ApiServer::sendJson(200, doc);
+}
+
+void ApiDiag::handleResetTiming() {
+  // Applied by the motor task at its next tick
+  LoopTiming::requestReset();
+  ApiServer::sendSuccess("Timing counters reset");
+}
+
+void ApiDiag::handleArmCapture() {
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  uint8_t encoder = doc["encoder"] | 0;
+  uint32_t rateHz = doc["rateHz"] | ENCODER_CAPTURE_MAX_HZ;
+  uint16_t samples = doc["samples"] | ENCODER_CAPTURE_DEPTH;
+  uint16_t preTrigger = doc["preTrigger"] | 0;
+  String trigger = doc["trigger"] | "now";
+  int32_t threshold = doc["threshold"] | 1;
+
+  CaptureTrigger mode;
+  if (trigger == "now") mode = CaptureTrigger::NOW;
+  else if (trigger == "move") mode = CaptureTrigger::MOVE;
+  else {
+    ApiServer::sendError(400, "Unknown trigger");
+    return;
+  }
+
+  if (!EncoderCapture::arm(encoder, rateHz, samples, preTrigger, mode, threshold)) {
+    ApiServer::sendError(400, "Encoder not enabled or capture settings out of range");
+    return;
+  }
+  handleGetCapture();
+}
+
+void ApiDiag::handleGetCapture() {
+  JsonDocument doc;
+  JsonObject capture = doc.to<JsonObject>();
+  EncoderCapture::toJson(capture);
+  ApiServer::sendJson(200, doc);
+}
+
+void ApiDiag::handleStopCapture() {
+  EncoderCapture::stop();
+  ApiServer::sendSuccess("Capture stopped");
+}
+
+void ApiDiag::handleCaptureData() {
+  uint32_t size = EncoderCapture::getDataSize();
+  if (size == 0) {
+    ApiServer::sendError(409, "No finished capture");
+    return;
+  }
+
+  WebServer& server = ApiServer::getServer();
+  ApiServer::beginStream(200, "application/octet-stream", size);
+
+  uint8_t buffer[512];
+  for (uint32_t offset = 0; offset < size;) {
+    size_t n = EncoderCapture::readData(offset, buffer, sizeof(buffer));
+    if (n == 0) break;
+    server.sendContent(reinterpret_cast<const char*>(buffer), n);
+    offset += n;
+  }
+}
+
+void ApiDiag::handleGetPwm() {
+  JsonDocument doc;
+  JsonObject pwm = doc.to<JsonObject>();
+  LedcAllocator::toJson(pwm);
+  ApiServer::sendJson(200, doc);
+}
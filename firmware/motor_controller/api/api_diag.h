@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// ============================================================================
+// Diagnostics API Endpoints
+// ============================================================================
+
+namespace ApiDiag {
+  void registerRoutes(WebServer& server);
+
+  // GET /api/diag/timing - Motor task wake latency and execution histograms
+  void handleGetTiming();
+
+  // POST /api/diag/timing/reset - Clear timing counters
+  void handleResetTiming();
+
+  // POST /api/diag/capture - Arm a high-rate encoder capture
+  // Body: { "encoder": 0, "rateHz": 10000, "samples": 4000, "preTrigger": 200,
+  //         "trigger": "move", "threshold": 2 }
+  void handleArmCapture();
+
+  // GET /api/diag/capture - Capture state
+  void handleGetCapture();
+
+  // POST /api/diag/capture/stop - Abort a running capture
+  void handleStopCapture();
+
+  // GET /api/diag/capture/data - Finished capture as a binary stream
+  void handleCaptureData();
+
+  // GET /api/diag/pwm - LEDC channels in use, with owner slot and timing
+  void handleGetPwm();
+}
@@ -0,0 +1,112 @@
+#include "api_gcode.h"
+#include "api_server.h"
+#include "../core/gcode_interpreter.h"
+#include "../core/safety_manager.h"
+
+namespace {
+  WebServer* _gcodeServer = nullptr;
+}
+
+void ApiGcode::registerRoutes(WebServer& server) {
+  _gcodeServer = &server;
+
+  server.on("/api/gcode", HTTP_POST, handleSubmit);
+  server.on("/api/gcode", HTTP_GET, handleGetStatus);
+  server.on("/api/gcode/cancel", HTTP_POST, handleCancel);
+  server.on("/api/gcode/override", HTTP_POST, handleOverride);
+
+  Serial.println("[API] G-code routes registered");
+}
+
+// Lines are taken in order until one does not fit. The response says how
+// many were accepted; the client sends the rest again once blocks finish.
+void ApiGcode::handleSubmit() {
+  if (SafetyManager::isEstopActive()) {
+    ApiServer::sendError(403, "E-stop active");
+    return;
+  }
+  if (!_gcodeServer->hasArg("plain")) {
+    ApiServer::sendError(400, "Missing G-code body");
+    return;
+  }
+
+  const String& body = _gcodeServer->arg("plain");
+  char line[GCODE_LINE_MAX + 1];
+  uint16_t accepted = 0;
+  int start = 0;
+  bool full = false;
+
+  while (start < (int)body.length()) {
+    int end = body.indexOf('\n', start);
+    if (end < 0) end = body.length();
+
+    int length = end - start;
+    if (length > 0 && body.charAt(end - 1) == '\r') length--;
+    if (length > GCODE_LINE_MAX) {
+      JsonDocument doc;
+      doc["success"] = false;
+      doc["error"] = "Line too long";
+      doc["line"] = accepted + 1;
+      doc["accepted"] = accepted;
+      ApiServer::sendJson(400, doc);
+      return;
+    }
+    memcpy(line, body.c_str() + start, length);
+    line[length] = '\0';
+
+    GcodeResult result = GcodeInterpreter::submitLine(line);
+    if (result == GcodeResult::QUEUE_FULL) {
+      full = true;
+      break;
+    }
+    if (result == GcodeResult::ERROR) {
+      JsonDocument doc;
+      doc["success"] = false;
+      doc["error"] = GcodeInterpreter::getLastError();
+      doc["line"] = accepted + 1;
+      doc["accepted"] = accepted;
+      ApiServer::sendJson(400, doc);
+      return;
+    }
+
+    accepted++;
+    start = end + 1;
+  }
+
+  JsonDocument doc;
+  doc["success"] = true;
+  doc["accepted"] = accepted;
+  doc["full"] = full;
+  doc["queued"] = GcodeInterpreter::queued();
+  doc["available"] = GcodeInterpreter::available();
+  ApiServer::sendJson(200, doc);
+}
+
+void ApiGcode::handleGetStatus() {
+  JsonDocument doc;
+  JsonObject obj = doc.to<JsonObject>();
+  GcodeInterpreter::toJson(obj);
+  ApiServer::sendJson(200, doc);
+}
+
+void ApiGcode::handleCancel() {
+  // Applied by the motor task at its next tick
+  GcodeInterpreter::cancel();
+  ApiServer::sendSuccess("G-code stream cancelled");
+}
+
+void ApiGcode::handleOverride() {
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  int percent = doc["percent"] | 100;
+  GcodeInterpreter::setFeedOverride(percent < 0 ? 0 : percent);
+
+  JsonDocument response;
+  JsonObject obj = response.to<JsonObject>();
+  GcodeInterpreter::toJson(obj);
+  ApiServer::sendJson(200, response);
+}
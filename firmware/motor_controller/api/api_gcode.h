@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+#include <ArduinoJson.h>
+
+// ============================================================================
+// G-code API Endpoints
+// ============================================================================
+
+namespace ApiGcode {
+  void registerRoutes(WebServer& server);
+
+  // POST /api/gcode - Queue G-code lines (text body), as many as fit
+  void handleSubmit();
+
+  // GET /api/gcode - Queue and interpreter state
+  void handleGetStatus();
+
+  // POST /api/gcode/cancel - Drop queued blocks and stop the running one
+  void handleCancel();
+
+  // POST /api/gcode/override - Set the feed override in percent
+  void handleOverride();
+}
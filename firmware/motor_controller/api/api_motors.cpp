@@ -3,6 +3,7 @@
 #include "../core/motor_manager.h"
 #include "../core/safety_manager.h"
 #include "../core/encoder_manager.h"
+#include "../core/cam_manager.h"
 
 namespace {
   WebServer* _motorsServer = nullptr;
@@ -18,6 +19,18 @@ namespace {
     }
     return -1;
   }
+
+  int getEncoderFromUri() {
+    String uri = _motorsServer->uri();
+    int idStart = uri.indexOf("/api/encoders/") + 14;
+    if (idStart < 14) return -1;
+
+    char idChar = uri.charAt(idStart);
+    if (idChar >= '0' && idChar < '0' + MAX_ENCODERS) {
+      return idChar - '0';
+    }
+    return -1;
+  }
 }
 
 void ApiMotors::registerRoutes(WebServer& server) {
@@ -27,6 +40,7 @@ void ApiMotors::registerRoutes(WebServer& server) {
   server.on("/api/status", HTTP_GET, handleGetStatus);
   server.on("/api/motors/stop-all", HTTP_POST, handleStopAll);
   server.on("/api/motors/save-config", HTTP_POST, handleSaveConfig);
+  server.on("/api/motors/move-group", HTTP_POST, handleMoveGroup);
 
   // Routes with slot parameter
   server.on("/api/motors/0", HTTP_GET, handleGetMotor);
@@ -49,6 +63,33 @@ void ApiMotors::registerRoutes(WebServer& server) {
   server.on("/api/motors/2/remove", HTTP_POST, handleRemoveMotor);
   server.on("/api/motors/3/remove", HTTP_POST, handleRemoveMotor);
 
+  server.on("/api/motors/0/pid", HTTP_POST, handleSetPid);
+  server.on("/api/motors/1/pid", HTTP_POST, handleSetPid);
+  server.on("/api/motors/2/pid", HTTP_POST, handleSetPid);
+  server.on("/api/motors/3/pid", HTTP_POST, handleSetPid);
+
+  server.on("/api/motors/0/ramp", HTTP_POST, handleSetRamp);
+  server.on("/api/motors/1/ramp", HTTP_POST, handleSetRamp);
+  server.on("/api/motors/2/ramp", HTTP_POST, handleSetRamp);
+  server.on("/api/motors/3/ramp", HTTP_POST, handleSetRamp);
+
+  server.on("/api/motors/0/step-monitor", HTTP_POST, handleStepMonitor);
+  server.on("/api/motors/1/step-monitor", HTTP_POST, handleStepMonitor);
+  server.on("/api/motors/2/step-monitor", HTTP_POST, handleStepMonitor);
+  server.on("/api/motors/3/step-monitor", HTTP_POST, handleStepMonitor);
+
+  server.on("/api/motors/0/follow", HTTP_POST, handleFollow);
+  server.on("/api/motors/1/follow", HTTP_POST, handleFollow);
+  server.on("/api/motors/2/follow", HTTP_POST, handleFollow);
+  server.on("/api/motors/3/follow", HTTP_POST, handleFollow);
+  server.on("/api/motors/0/waveform", HTTP_POST, handleWaveform);
+  server.on("/api/motors/1/waveform", HTTP_POST, handleWaveform);
+  server.on("/api/motors/2/waveform", HTTP_POST, handleWaveform);
+  server.on("/api/motors/3/waveform", HTTP_POST, handleWaveform);
+
+  server.on("/api/encoders/0/configure", HTTP_POST, handleConfigureEncoder);
+  server.on("/api/encoders/1/configure", HTTP_POST, handleConfigureEncoder);
+
   Serial.println("[API] Motor routes registered");
 }
 
@@ -93,8 +134,9 @@ void ApiMotors::handleConfigureMotor() {
   }
 
   JsonObject pinsObj = doc["pins"];
+  JsonObject optionsObj = doc["options"];
 
-  if (MotorManager::configureSlot(slot, type, pinsObj)) {
+  if (MotorManager::configureSlot(slot, type, pinsObj, optionsObj)) {
     JsonDocument response;
     response["success"] = true;
     response["message"] = "Motor configured";
@@ -138,6 +180,7 @@ void ApiMotors::handleControlMotor() {
   if (cmdStr == "stop") cmd = CommandType::STOP;
   else if (cmdStr == "speed") cmd = CommandType::SET_SPEED;
   else if (cmdStr == "position") cmd = CommandType::SET_POSITION;
+  else if (cmdStr == "queue") cmd = CommandType::QUEUE_POSITION;
   else if (cmdStr == "angle") cmd = CommandType::SET_ANGLE;
   else if (cmdStr == "relative") cmd = CommandType::MOVE_RELATIVE;
   else if (cmdStr == "brake") cmd = CommandType::BRAKE;
@@ -145,18 +188,259 @@ void ApiMotors::handleControlMotor() {
   else if (cmdStr == "enable") cmd = CommandType::ENABLE;
   else if (cmdStr == "disable") cmd = CommandType::DISABLE;
   else if (cmdStr == "home") cmd = CommandType::HOME;
+  else if (cmdStr == "rpm") cmd = CommandType::SET_RPM;
+  else if (cmdStr == "run") cmd = CommandType::RUN;
   else {
     ApiServer::sendError(400, "Invalid command");
     return;
   }
 
+  // Slot was checked above, so a failure means the command queue is full
   if (MotorManager::sendCommand(slot, cmd, value, duration)) {
     ApiServer::sendSuccess("Command sent");
   } else {
-    ApiServer::sendError(500, "Command failed");
+    ApiServer::sendError(503, "Command queue full");
+  }
+}
+
+void ApiMotors::handleSetPid() {
+  int slot = getSlotFromUri();
+  if (slot < 0 || slot >= MAX_MOTORS) {
+    ApiServer::sendError(400, "Invalid slot");
+    return;
+  }
+
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  float kp = doc["kp"] | DC_PID_DEFAULT_KP;
+  float ki = doc["ki"] | DC_PID_DEFAULT_KI;
+  float kd = doc["kd"] | DC_PID_DEFAULT_KD;
+  float kff = doc["kff"] | DC_PID_DEFAULT_KFF;
+
+  float kpPos = doc["kpPos"] | DC_POSITION_DEFAULT_KP;
+  float maxSpeed = doc["maxSpeed"] | DC_POSITION_DEFAULT_SPEED;
+  float acceleration = doc["acceleration"] | DC_POSITION_DEFAULT_ACCEL;
+
+  if (MotorManager::setPidGains(slot, kp, ki, kd, kff) &&
+      MotorManager::setPositionLoop(slot, kpPos, maxSpeed, acceleration)) {
+    ApiServer::sendSuccess("PID gains set");
+  } else {
+    ApiServer::sendError(400, "Slot is not a DC motor");
   }
 }
 
+void ApiMotors::handleSetRamp() {
+  int slot = getSlotFromUri();
+  if (slot < 0 || slot >= MAX_MOTORS) {
+    ApiServer::sendError(400, "Invalid slot");
+    return;
+  }
+
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  float acceleration = doc["acceleration"] | DC_DEFAULT_ACCELERATION;
+  float deceleration = doc["deceleration"] | acceleration;
+  float jerk = doc["jerk"] | DC_DEFAULT_JERK;
+
+  float rpmAcceleration = doc["rpmAcceleration"] | DC_DEFAULT_RPM_ACCELERATION;
+  float rpmDeceleration = doc["rpmDeceleration"] | rpmAcceleration;
+  float rpmJerk = doc["rpmJerk"] | DC_DEFAULT_RPM_JERK;
+
+  if (acceleration < 0 || deceleration < 0 || jerk < 0 ||
+      rpmAcceleration < 0 || rpmDeceleration < 0 || rpmJerk < 0) {
+    ApiServer::sendError(400, "Ramp limits must not be negative");
+    return;
+  }
+
+  if (MotorManager::setRampLimits(slot, acceleration, deceleration, jerk) &&
+      MotorManager::setRpmRampLimits(slot, rpmAcceleration, rpmDeceleration, rpmJerk)) {
+    ApiServer::sendSuccess("Ramp limits set");
+  } else {
+    ApiServer::sendError(400, "Slot is not a DC motor");
+  }
+}
+
+void ApiMotors::handleStepMonitor() {
+  int slot = getSlotFromUri();
+  if (slot < 0 || slot >= MAX_MOTORS) {
+    ApiServer::sendError(400, "Invalid slot");
+    return;
+  }
+
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  StepMonitorConfig config;
+  config.enabled = doc["enabled"] | true;
+  config.stepsPerCount = doc["stepsPerCount"] | 1.0;
+  config.threshold = doc["threshold"] | STEP_MONITOR_DEFAULT_THRESHOLD;
+  config.resync = doc["resync"] | false;
+
+  if (MotorManager::configureStepMonitor(slot, config)) {
+    ApiServer::sendSuccess(config.enabled ? "Step monitor enabled" : "Step monitor disabled");
+  } else {
+    ApiServer::sendError(400, "Slot is not a stepper or settings are invalid");
+  }
+}
+
+void ApiMotors::handleFollow() {
+  int slot = getSlotFromUri();
+  if (slot < 0 || slot >= MAX_MOTORS) {
+    ApiServer::sendError(400, "Invalid slot");
+    return;
+  }
+
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  bool enable = doc["enabled"] | true;
+  if (!enable) {
+    MotorManager::disengageFollow(slot);
+    ApiServer::sendSuccess("Follow disengaged");
+    return;
+  }
+
+  if (SafetyManager::isEstopActive()) {
+    ApiServer::sendError(403, "E-stop active");
+    return;
+  }
+
+  uint8_t encoder = doc["encoder"] | 0;
+  const char* mode = doc["mode"] | "gear";
+
+  if (strcmp(mode, "cam") == 0) {
+    const char* name = doc["cam"] | "";
+    static CamTable table;  // Loop task only; too large for its stack
+    if (!CamManager::loadCam(name, table)) {
+      ApiServer::sendError(404, "Cam not found");
+      return;
+    }
+    if (MotorManager::engageCam(slot, encoder, table, name)) {
+      ApiServer::sendSuccess("Follow engaged");
+    } else {
+      ApiServer::sendError(400, "Slot cannot follow this encoder");
+    }
+    return;
+  }
+  if (strcmp(mode, "gear") != 0) {
+    ApiServer::sendError(400, "Unknown follow mode");
+    return;
+  }
+
+  int32_t numerator = doc["numerator"] | 1;
+  int32_t denominator = doc["denominator"] | 1;
+
+  if (MotorManager::engageGear(slot, encoder, numerator, denominator)) {
+    ApiServer::sendSuccess("Follow engaged");
+  } else {
+    ApiServer::sendError(400, "Slot cannot follow this encoder or the ratio is out of range");
+  }
+}
+
+void ApiMotors::handleWaveform() {
+  int slot = getSlotFromUri();
+  if (slot < 0 || slot >= MAX_MOTORS) {
+    ApiServer::sendError(400, "Invalid slot");
+    return;
+  }
+
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  bool enable = doc["enabled"] | true;
+  if (!enable) {
+    MotorManager::stopWaveform(slot);
+    ApiServer::sendSuccess("Waveform stopped");
+    return;
+  }
+
+  if (SafetyManager::isEstopActive()) {
+    ApiServer::sendError(403, "E-stop active");
+    return;
+  }
+
+  WaveformConfig config;
+  const char* shape = doc["shape"] | "sine";
+  if (strcmp(shape, "sine") == 0) {
+    config.shape = WaveShape::SINE;
+  } else if (strcmp(shape, "triangle") == 0) {
+    config.shape = WaveShape::TRIANGLE;
+  } else if (strcmp(shape, "square") == 0) {
+    config.shape = WaveShape::SQUARE;
+  } else {
+    ApiServer::sendError(400, "Unknown shape");
+    return;
+  }
+  config.frequency = doc["frequency"] | 1.0f;
+  config.amplitude = doc["amplitude"] | 0.0f;
+  config.offset = doc["offset"] | NAN;
+  config.phase = doc["phase"] | 0.0f;
+
+  if (MotorManager::startWaveform(slot, config)) {
+    ApiServer::sendSuccess("Waveform started");
+  } else {
+    ApiServer::sendError(400, "Slot cannot run a waveform or the parameters are out of range");
+  }
+}
+
+void ApiMotors::handleConfigureEncoder() {
+  int id = getEncoderFromUri();
+  if (id < 0) {
+    ApiServer::sendError(400, "Invalid encoder");
+    return;
+  }
+
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  bool enable = doc["enabled"] | true;
+  if (!enable) {
+    EncoderManager::unlinkFromMotor(id);
+    EncoderManager::disableEncoder(id);
+    ApiServer::sendSuccess("Encoder disabled");
+    return;
+  }
+
+  uint8_t pinA = doc["pinA"] | (id == 0 ? ENC0_PIN_A : ENC1_PIN_A);
+  uint8_t pinB = doc["pinB"] | (id == 0 ? ENC0_PIN_B : ENC1_PIN_B);
+  EncoderManager::setPulsesPerRevolution(id, doc["ppr"] | EncoderManager::getPulsesPerRevolution(id));
+  EncoderManager::setReversed(id, doc["reversed"] | false);
+  EncoderManager::configureEncoder(id, pinA, pinB);
+
+  int motorSlot = doc["motorSlot"] | -1;
+  if (motorSlot >= 0 && motorSlot < MAX_MOTORS) {
+    EncoderManager::linkToMotor(id, motorSlot);
+    StepMonitor::requestAlign(motorSlot);  // The count may have restarted
+  } else {
+    EncoderManager::unlinkFromMotor(id);
+  }
+
+  JsonDocument response;
+  JsonObject obj = response.to<JsonObject>();
+  EncoderManager::encoderToJson(id, obj);
+  ApiServer::sendJson(200, response);
+}
+
 void ApiMotors::handleRemoveMotor() {
   int slot = getSlotFromUri();
   if (slot < 0 || slot >= MAX_MOTORS) {
@@ -176,6 +460,50 @@ void ApiMotors::handleStopAll() {
   ApiServer::sendSuccess("All motors stopped");
 }
 
+void ApiMotors::handleMoveGroup() {
+  if (SafetyManager::isEstopActive()) {
+    ApiServer::sendError(403, "E-stop active");
+    return;
+  }
+
+  JsonDocument doc;
+  if (!ApiServer::parseJson(doc)) {
+    ApiServer::sendError(400, "Invalid JSON");
+    return;
+  }
+
+  JsonArray axes = doc["axes"];
+  if (axes.isNull() || axes.size() == 0 || axes.size() > MAX_MOTORS) {
+    ApiServer::sendError(400, "Expected 1-4 axes");
+    return;
+  }
+
+  uint8_t slots[MAX_MOTORS];
+  int32_t targets[MAX_MOTORS];
+  uint8_t count = 0;
+
+  for (JsonObject axis : axes) {
+    if (!axis.containsKey("slot") || !axis.containsKey("target")) {
+      ApiServer::sendError(400, "Each axis needs slot and target");
+      return;
+    }
+    slots[count] = axis["slot"];
+    targets[count] = axis["target"];
+    count++;
+  }
+
+  int8_t group = MotorManager::moveAxes(slots, targets, count);
+  if (group < 0) {
+    ApiServer::sendError(409, "Axes must be idle timer-output steppers");
+    return;
+  }
+
+  JsonDocument response;
+  response["success"] = true;
+  response["group"] = group;
+  ApiServer::sendJson(200, response);
+}
+
 void ApiMotors::handleSaveConfig() {
   MotorManager::saveConfig();
   ApiServer::sendSuccess("Configuration saved");
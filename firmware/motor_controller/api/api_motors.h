@@ -25,12 +25,42 @@ namespace ApiMotors {
   // Body: { "command": "speed", "value": 128, "duration": 0 }
   void handleControlMotor();
 
+  // POST /api/motors/{slot}/pid - DC closed-loop gains and position profile
+  // Body: { "kp": 0.05, "ki": 0.5, "kd": 0, "kff": 0.1, "kpPos": 10, "maxSpeed": 2000, "acceleration": 8000 }
+  void handleSetPid();
+
+  // POST /api/motors/{slot}/ramp - DC speed slew limits, duty/s open loop and RPM/s closed loop
+  // Body: { "acceleration": 500, "deceleration": 1000, "jerk": 5000, "rpmAcceleration": 600 }
+  void handleSetRamp();
+
+  // POST /api/motors/{slot}/step-monitor - Step loss detection against the linked encoder
+  // Body: { "enabled": true, "stepsPerCount": 1.0, "threshold": 32, "resync": false }
+  void handleStepMonitor();
+
+  // POST /api/motors/{slot}/follow - Electronic gearing or cam to a master encoder
+  // Body: { "encoder": 0, "numerator": 16, "denominator": 5 },
+  //       { "mode": "cam", "encoder": 0, "cam": "name" }, or { "enabled": false }
+  void handleFollow();
+
+  // POST /api/motors/{slot}/waveform - Oscillate the slot's position or angle
+  // Body: { "shape": "sine", "frequency": 0.5, "amplitude": 400, "offset": 0, "phase": 90 },
+  //       or { "enabled": false }
+  void handleWaveform();
+
+  // POST /api/encoders/{id}/configure - Attach an encoder and link it to a slot
+  // Body: { "pinA": 34, "pinB": 35, "ppr": 400, "reversed": false, "motorSlot": 0 }
+  void handleConfigureEncoder();
+
   // POST /api/motors/{slot}/remove - Remove motor from slot
   void handleRemoveMotor();
 
   // POST /api/motors/stop-all - Emergency stop all motors
   void handleStopAll();
 
+  // POST /api/motors/move-group - Coordinated straight-line move
+  // Body: { "axes": [ { "slot": 0, "target": 4000 }, { "slot": 1, "target": -1500 } ] }
+  void handleMoveGroup();
+
   // POST /api/motors/save-config - Save motor configuration
   void handleSaveConfig();
 
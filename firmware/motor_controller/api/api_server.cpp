@@ -1,7 +1,10 @@
 #include "api_server.h"
 #include "api_motors.h"
 #include "api_presets.h"
+#include "api_cams.h"
 #include "api_system.h"
+#include "api_diag.h"
+#include "api_gcode.h"
 #include "../web/web_pages.h"
 
 WebServer ApiServer::server(WEB_SERVER_PORT);
@@ -28,9 +31,18 @@ void ApiServer::setupRoutes() {
   // === Presets API ===
   ApiPresets::registerRoutes(server);
 
+  // === Cam Tables API ===
+  ApiCams::registerRoutes(server);
+
   // === System API ===
   ApiSystem::registerRoutes(server);
 
+  // === Diagnostics API ===
+  ApiDiag::registerRoutes(server);
+
+  // === G-code API ===
+  ApiGcode::registerRoutes(server);
+
   // === 404 Handler ===
   server.onNotFound(handleNotFound);
 
@@ -84,6 +96,12 @@ void ApiServer::sendSuccess(const char* message) {
   server.send(200, "application/json", output);
 }
 
+void ApiServer::beginStream(int code, const char* contentType, size_t length) {
+  addCorsHeaders();
+  server.setContentLength(length);
+  server.send(code, contentType, "");
+}
+
 void ApiServer::sendError(int code, const char* message) {
   addCorsHeaders();
   JsonDocument doc;
@@ -27,6 +27,8 @@ public:
   static void sendSuccess(const char* message = "OK");
   static void sendError(int code, const char* message);
   static bool parseJson(JsonDocument& doc);
+  // Sends the headers of a response whose body follows through sendContent()
+  static void beginStream(int code, const char* contentType, size_t length);
 
   // === Server Access ===
   static WebServer& getServer() { return server; }
@@ -18,23 +18,20 @@ constexpr uint16_t MAX_SEQUENCE_STEPS = 64;
 
 // === Task Timing ===
 constexpr uint32_t MOTOR_TASK_INTERVAL_MS = 1;     // 1kHz motor update
-constexpr uint32_t ENCODER_TASK_INTERVAL_MS = 10;  // 100Hz encoder read
 constexpr uint32_t API_POLL_INTERVAL_MS = 50;      // 20Hz API handling
 constexpr uint32_t SAFETY_CHECK_INTERVAL_MS = 10;  // 100Hz safety checks
+constexpr uint8_t LOOP_TIMING_BUCKETS = 14;        // log2 us histogram, last bucket >= 4.1ms
 
 // === Task Stack Sizes ===
 constexpr uint32_t MOTOR_TASK_STACK = 4096;
-constexpr uint32_t ENCODER_TASK_STACK = 2048;
 constexpr uint32_t PLAYBACK_TASK_STACK = 4096;
 
 // === Task Priorities ===
 constexpr uint8_t MOTOR_TASK_PRIORITY = 3;    // Highest - time critical
-constexpr uint8_t ENCODER_TASK_PRIORITY = 2;
 constexpr uint8_t PLAYBACK_TASK_PRIORITY = 1;
 
 // === Core Assignments ===
 constexpr uint8_t MOTOR_TASK_CORE = 0;    // Dedicated core for motor control
-constexpr uint8_t ENCODER_TASK_CORE = 1;
 constexpr uint8_t PLAYBACK_TASK_CORE = 1;
 
 // ============================================================================
@@ -79,6 +76,9 @@ constexpr uint8_t ENC1_PIN_B = 39;  // Input only (VN)
 constexpr uint8_t ESTOP_PIN = 0;      // Boot button - active LOW
 constexpr uint8_t STATUS_LED_PIN = 2; // Onboard LED
 
+// === GPIO ===
+constexpr uint8_t GPIO_BATCH_PIN_COUNT = 40;  // GPIO 0-39 in two output banks (34-39 input only)
+
 // ============================================================================
 // Motor Type Enumeration
 // ============================================================================
@@ -136,7 +136,7 @@ inline const char* getSafetyStateName(SafetyState state) {
 
 enum class CommandType : uint8_t {
   STOP = 0,
-  SET_SPEED = 1,      // DC motors: -255 to +255
+  SET_SPEED = 1,      // DC motors: +-maxDuty (255 at the default 8-bit PWM)
   SET_POSITION = 2,   // Steppers: absolute position
   SET_ANGLE = 3,      // Servos: 0-180 degrees
   MOVE_RELATIVE = 4,  // Steppers: relative steps
@@ -144,35 +144,66 @@ enum class CommandType : uint8_t {
   COAST = 6,          // DC motors: free spin
   ENABLE = 7,         // Steppers: enable driver
   DISABLE = 8,        // Steppers: disable driver
-  HOME = 9            // Move to home position
+  HOME = 9,           // Move to home position
+  QUEUE_POSITION = 10,// Steppers: absolute position after the queued moves, no stop between
+  SET_RPM = 11,       // DC motors with a linked encoder: closed-loop speed in RPM
+  RUN = 12            // Step/dir steppers: constant signed speed in steps/s, ramped
 };
 
-// ============================================================================
-// Slot Configuration Structure
-// ============================================================================
-
-struct SlotPins {
-  uint8_t pinA;
-  uint8_t pinB;
-  uint8_t pinEn;
-  uint8_t pinEx;  // Extra pin for ULN2003
+struct MotorCommand {
+  uint8_t slot;
+  CommandType command;
+  int32_t value;
+  uint16_t duration;  // ms, 0 = instant
+};
 
-  SlotPins() : pinA(255), pinB(255), pinEn(255), pinEx(255) {}
-  SlotPins(uint8_t a, uint8_t b, uint8_t en, uint8_t ex = 255)
-    : pinA(a), pinB(b), pinEn(en), pinEx(ex) {}
+// Producers of motor commands; each one gets its own queue into the motor task
+enum class CommandSource : uint8_t {
+  API = 0,       // HTTP handlers (loop task)
+  PLAYBACK = 1,  // Preset playback task
+  GCODE = 2,     // G-code block executor (motor task)
+  COUNT
 };
 
-// Default pin configurations for each slot
-inline SlotPins getDefaultSlotPins(uint8_t slot) {
-  switch (slot) {
-    case 0: return SlotPins(SLOT0_PIN_A, SLOT0_PIN_B, SLOT0_PIN_EN, SLOT0_PIN_EX);
-    case 1: return SlotPins(SLOT1_PIN_A, SLOT1_PIN_B, SLOT1_PIN_EN, SLOT1_PIN_EX);
-    case 2: return SlotPins(SLOT2_PIN_A, SLOT2_PIN_B, SLOT2_PIN_EN, SLOT2_PIN_EX);
-    case 3: return SlotPins(SLOT3_PIN_A, SLOT3_PIN_B, SLOT3_PIN_EN, SLOT3_PIN_EX);
-    default: return SlotPins();
+constexpr uint8_t COMMAND_SOURCE_COUNT = static_cast<uint8_t>(CommandSource::COUNT);
+constexpr uint16_t COMMAND_QUEUE_DEPTH = 16;  // Per source, power of two
+
+inline const char* getCommandSourceName(CommandSource source) {
+  switch (source) {
+    case CommandSource::API: return "api";
+    case CommandSource::PLAYBACK: return "playback";
+    case CommandSource::GCODE: return "gcode";
+    default: return "unknown";
   }
 }
 
+// Status snapshot reads retried while racing a motor task publish
+constexpr uint8_t MOTOR_STATUS_READ_RETRIES = 8;
+
+// === G-code ===
+// Axis letters in slot order: X drives slot 0, Y slot 1, ... Units are the
+// slot's own (steps for steppers, degrees for servos).
+constexpr char GCODE_AXIS_LETTERS[MAX_MOTORS + 1] = "XYZA";
+constexpr uint16_t GCODE_QUEUE_DEPTH = 32;         // Parsed blocks, power of two
+constexpr uint8_t GCODE_LINE_MAX = 96;             // Longest accepted line
+constexpr float GCODE_DEFAULT_FEED = 6000.0f;      // Units/min until the first F word
+constexpr uint16_t GCODE_OVERRIDE_MIN = 10;        // Feed override, percent
+constexpr uint16_t GCODE_OVERRIDE_MAX = 200;
+
+// ============================================================================
+// PWM Configuration
+// ============================================================================
+
+constexpr uint32_t PWM_FREQUENCY = 1000;     // DC default, per slot via options.pwmFrequency
+constexpr uint8_t PWM_RESOLUTION = 8;        // DC default (0-255), per slot via options.pwmResolution
+constexpr uint32_t SERVO_FREQUENCY = 50;     // 50Hz for servos
+constexpr uint8_t SERVO_RESOLUTION = 16;     // 0.3us pulse steps at 50Hz
+constexpr uint16_t SERVO_MIN_PULSE = 500;    // microseconds
+constexpr uint16_t SERVO_MAX_PULSE = 2400;   // microseconds
+constexpr uint8_t LEDC_CHANNEL_COUNT = 16;            // 2 groups of 8, channel pairs share a timer
+constexpr uint8_t LEDC_MAX_RESOLUTION = 16;           // Bits; duty fits an int32 speed
+constexpr uint32_t LEDC_SOURCE_CLOCK_HZ = 80000000;   // APB clock, bounds frequency * 2^bits
+
 // ============================================================================
 // Network Configuration
 // ============================================================================
@@ -188,14 +219,43 @@ constexpr uint8_t AP_MAX_CONNECTIONS = 4;
 #define DEFAULT_HOSTNAME "motor-ctrl"
 
 // ============================================================================
-// PWM Configuration
+// Encoder and DC Closed-Loop Configuration
 // ============================================================================
 
-constexpr uint32_t PWM_FREQUENCY = 1000;     // 1kHz for DC motors
-constexpr uint8_t PWM_RESOLUTION = 8;        // 8-bit (0-255)
-constexpr uint32_t SERVO_FREQUENCY = 50;     // 50Hz for servos
-constexpr uint16_t SERVO_MIN_PULSE = 500;    // microseconds
-constexpr uint16_t SERVO_MAX_PULSE = 2400;   // microseconds
+// Encoder speed estimation, sampled by the motor task every tick
+constexpr float ENCODER_OBSERVER_BANDWIDTH_HZ = 30.0f;  // Alpha-beta observer, lag vs noise
+constexpr float ENCODER_PERIOD_SPEED = 200.0f;          // Counts/s below which count periods are timed
+constexpr uint32_t ENCODER_PERIOD_WINDOW_US = 10000;    // Shortest span of one period measurement
+constexpr uint32_t ENCODER_STOP_US = 100000;            // No count for this long reads as stopped
+constexpr uint32_t ENCODER_MAX_GAP_US = 20000;          // Longer gaps between samples restart the estimate
+
+// Encoder capture (gptimer sampled trace for loop tuning)
+constexpr uint32_t ENCODER_CAPTURE_TIMER_HZ = 1000000;  // 1us alarm resolution
+constexpr uint32_t ENCODER_CAPTURE_MIN_HZ = 100;        // Keeps sample spacing within a uint16 of us
+constexpr uint32_t ENCODER_CAPTURE_MAX_HZ = 10000;
+constexpr uint16_t ENCODER_CAPTURE_DEPTH = 4096;        // Samples, 8 bytes each
+
+// DC speed slew limits, 0 = unlimited. Open loop in 8-bit duty, closed-loop speed in RPM
+constexpr float DC_DEFAULT_ACCELERATION = 10000.0f;  // duty/s, full speed in about 25 ms
+constexpr float DC_DEFAULT_DECELERATION = 10000.0f;  // duty/s
+constexpr float DC_DEFAULT_JERK = 0.0f;              // duty/s^2
+constexpr float DC_DEFAULT_RPM_ACCELERATION = 0.0f;  // RPM/s
+constexpr float DC_DEFAULT_RPM_DECELERATION = 0.0f;  // RPM/s
+constexpr float DC_DEFAULT_RPM_JERK = 0.0f;          // RPM/s^2
+constexpr uint32_t DC_SLEW_MAX_GAP_US = 50000;       // Longer gaps between updates count as this
+
+// DC closed-loop speed (linked encoder), gains in duty (0-255) per encoder count
+constexpr uint32_t DC_PID_INTERVAL_MS = 2;   // Sample period, the encoder speed is updated every tick
+constexpr float DC_PID_DEFAULT_KP = 0.05f;   // Per count/s of error
+constexpr float DC_PID_DEFAULT_KI = 0.5f;    // Per count of accumulated error
+constexpr float DC_PID_DEFAULT_KD = 0.0f;    // Per count/s^2
+constexpr float DC_PID_DEFAULT_KFF = 0.0f;   // Per count/s of setpoint
+
+// DC closed-loop position, cascaded over the speed PID (encoder counts)
+constexpr float DC_POSITION_DEFAULT_KP = 10.0f;       // Speed setpoint (counts/s) per count of error
+constexpr float DC_POSITION_DEFAULT_SPEED = 2000.0f;  // Reference profile, counts/s
+constexpr float DC_POSITION_DEFAULT_ACCEL = 8000.0f;  // Reference profile, counts/s^2
+constexpr int32_t DC_POSITION_TOLERANCE = 4;          // In position within +-counts
 
 // ============================================================================
 // Stepper Configuration
@@ -205,12 +265,56 @@ constexpr uint16_t SERVO_MAX_PULSE = 2400;   // microseconds
 constexpr uint16_t NEMA17_STEPS_PER_REV = 200;  // 1.8 degree steps
 constexpr float DEFAULT_STEPPER_SPEED = 1000;    // steps/sec
 constexpr float DEFAULT_STEPPER_ACCEL = 500;     // steps/sec^2
-constexpr float MAX_STEPPER_SPEED = 4000;        // steps/sec
+constexpr float MAX_STEPPER_SPEED = 40000;       // steps/sec (1/16 microstepping)
 
 // 28BYJ-48 defaults
 constexpr uint16_t ULN2003_STEPS_PER_REV = 2048; // With 64:1 gearbox, half-step
 constexpr float DEFAULT_28BYJ_SPEED = 10;        // RPM
 constexpr float MAX_28BYJ_SPEED = 15;            // RPM
+constexpr uint16_t ULN2003_IDLE_RELEASE_MS = 1000;      // Coils off after this long idle, 0 = hold
+constexpr uint8_t ULN2003_HOLD_DUTY = 100;              // Percent of full coil current while idle
+constexpr uint32_t ULN2003_HOLD_PWM_FREQUENCY = 20000;  // Hold PWM, above hearing
+constexpr uint8_t ULN2003_HOLD_PWM_RESOLUTION = 8;
+
+// Step engine (gptimer ISR step generation)
+constexpr uint8_t MAX_STEP_CHANNELS = MAX_MOTORS;
+constexpr uint32_t STEP_ENGINE_TIMER_HZ = 10000000;  // 0.1us tick resolution
+constexpr uint32_t STEP_PULSE_TICKS = 25;            // 2.5us STEP high time (DRV8825 min 1.9us)
+constexpr uint32_t STEP_ENGINE_GUARD_TICKS = 10;     // Events this close are serviced together
+constexpr uint32_t STEP_ENGINE_LEAD_TICKS = 200;     // Delay from DIR write to first step
+constexpr float STEP_ENGINE_MAX_RATE = 100000;       // steps/sec, 5us min period per channel
+constexpr uint8_t MAX_AXIS_GROUPS = 2;               // Concurrent coordinated moves (e.g. XY + pan/tilt)
+constexpr uint8_t STEP_LOOKAHEAD_DEPTH = 8;          // Targets queued behind the current one per channel
+constexpr uint8_t STEP_MICROSTEP_MAX_SHIFT = 5;      // Microstep switching: up to 32x coarser (1/32 to full)
+
+// RMT pulse train output (alternative to the step engine for A4988/DRV8825)
+constexpr uint8_t RMT_STEP_MAX_OUTPUTS = 2;          // Slots that can use RMT at once
+constexpr uint32_t RMT_STEP_RESOLUTION_HZ = 1000000; // 1us symbol resolution
+constexpr uint16_t RMT_STEP_BLOCK_SYMBOLS = 128;     // Symbols per queued transaction
+constexpr uint8_t RMT_STEP_QUEUE_DEPTH = 4;          // Transactions queued ahead
+constexpr uint32_t RMT_STEP_BLOCK_US = 5000;         // Motion per transaction, bounds stop latency
+constexpr uint16_t RMT_STEP_PULSE_TICKS = 3;         // 3us STEP high time
+
+// Constant speed runs (run command): the speed ramps at the slot acceleration in
+// the motor task. With runOutput "ledc" STEP is a 50% duty LEDC output whose
+// frequency follows the ramp, and PCNT counts the pulses back for position.
+constexpr float STEP_RUN_MIN_SPEED = 20.0f;          // steps/sec, slowest run; ramps start and end here
+constexpr uint32_t STEP_RUN_MAX_GAP_US = 20000;      // Longest ramp step, bounds a late tick
+constexpr uint8_t STEP_FREQUENCY_MAX_OUTPUTS = 2;    // Slots that can run on LEDC at once
+constexpr int STEP_FREQUENCY_PCNT_LIMIT = 30000;     // PCNT counts up to this, then wraps to 0
+constexpr uint32_t STEP_FREQUENCY_GLITCH_NS = 1000;  // Shorter pulses on the STEP pin are not counted
+
+// Electronic gearing (slot following a master encoder)
+constexpr int32_t FOLLOW_RATIO_MAX = 10000;  // Largest numerator / denominator
+constexpr uint8_t MAX_CAMS = 16;             // Cam tables kept on LittleFS (points: CAM_MAX_POINTS)
+constexpr uint8_t CAM_NAME_LENGTH = 32;      // Including the terminator
+
+// Waveform mode (DDS oscillator per slot, advanced every motor task tick)
+constexpr float WAVEFORM_MAX_HZ = 50.0f;            // At least 20 setpoints per cycle
+constexpr float WAVEFORM_MAX_AMPLITUDE = 1.0e9f;    // Amplitude and offset, setpoint units
+
+// Step loss detection (stepper slot with a linked encoder)
+constexpr int32_t STEP_MONITOR_DEFAULT_THRESHOLD = 32;  // Following error that trips the slot, steps
 
 // Microstepping modes
 enum class MicrostepMode : uint8_t {
@@ -222,6 +326,57 @@ enum class MicrostepMode : uint8_t {
   THIRTYSECOND = 32  // DRV8825 only
 };
 
+// 28BYJ-48 coil sequences
+enum class CoilStepMode : uint8_t {
+  HALF = 0,  // Alternates one and two coils, ULN2003_STEPS_PER_REV steps
+  FULL = 1,  // Two coils, half the steps, most torque
+  WAVE = 2   // One coil, half the steps, least current
+};
+
+// ============================================================================
+// Slot Configuration Structure
+// ============================================================================
+
+struct SlotPins {
+  uint8_t pinA;
+  uint8_t pinB;
+  uint8_t pinEn;
+  uint8_t pinEx;  // Extra pin for ULN2003
+  uint8_t ms1, ms2, ms3;  // A4988/DRV8825 microstep select, 255 = hardwired
+
+  SlotPins() : pinA(255), pinB(255), pinEn(255), pinEx(255), ms1(255), ms2(255), ms3(255) {}
+  SlotPins(uint8_t a, uint8_t b, uint8_t en, uint8_t ex = 255)
+    : pinA(a), pinB(b), pinEn(en), pinEx(ex), ms1(255), ms2(255), ms3(255) {}
+};
+
+// Per-slot driver options (persisted alongside pins)
+struct SlotOptions {
+  uint8_t stepOutput;     // Step/dir steppers: 0 = step engine timer, 1 = RMT
+  uint32_t pwmFrequency;  // DC motors: bridge PWM frequency, Hz
+  uint8_t pwmResolution;  // DC motors: duty bits, speed range is +-(2^bits - 1)
+  uint8_t coilMode;       // 28BYJ-48: CoilStepMode
+  uint16_t idleReleaseMs; // 28BYJ-48: de-energize after this long idle, 0 = hold
+  uint8_t holdDuty;       // 28BYJ-48: coil current while idle, percent
+  uint8_t microsteps;     // Step/dir steppers: MicrostepMode, finest level when switching
+  uint32_t microstepSwitchRate;  // Step/dir steppers: coarser above this many pulses/s, 0 = fixed
+  uint8_t runOutput;      // Step/dir steppers: constant speed runs on 0 = stepOutput, 1 = LEDC
+
+  SlotOptions() : stepOutput(0), pwmFrequency(PWM_FREQUENCY), pwmResolution(PWM_RESOLUTION),
+                  coilMode(0), idleReleaseMs(ULN2003_IDLE_RELEASE_MS), holdDuty(ULN2003_HOLD_DUTY),
+                  microsteps(1), microstepSwitchRate(0), runOutput(0) {}
+};
+
+// Default pin configurations for each slot
+inline SlotPins getDefaultSlotPins(uint8_t slot) {
+  switch (slot) {
+    case 0: return SlotPins(SLOT0_PIN_A, SLOT0_PIN_B, SLOT0_PIN_EN, SLOT0_PIN_EX);
+    case 1: return SlotPins(SLOT1_PIN_A, SLOT1_PIN_B, SLOT1_PIN_EN, SLOT1_PIN_EX);
+    case 2: return SlotPins(SLOT2_PIN_A, SLOT2_PIN_B, SLOT2_PIN_EN, SLOT2_PIN_EX);
+    case 3: return SlotPins(SLOT3_PIN_A, SLOT3_PIN_B, SLOT3_PIN_EN, SLOT3_PIN_EX);
+    default: return SlotPins();
+  }
+}
+
 // ============================================================================
 // Safety Limits
 // ============================================================================
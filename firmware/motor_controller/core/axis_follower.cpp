@@ -0,0 +1,105 @@
+#include "axis_follower.h"
+#include "encoder_manager.h"
+
+// Static member initialization
+AxisFollower::State AxisFollower::states[MAX_MOTORS] = {};
+CamTable AxisFollower::cams[MAX_MOTORS];
+
+bool AxisFollower::engageGear(uint8_t slot, uint8_t encoder, int32_t numerator, int32_t denominator,
+                              int64_t slavePosition) {
+  if (slot >= MAX_MOTORS || !EncoderManager::isEnabled(encoder)) return false;
+  if (denominator <= 0 || denominator > FOLLOW_RATIO_MAX) return false;
+  if (numerator == 0 || abs(numerator) > FOLLOW_RATIO_MAX) return false;
+
+  State& s = states[slot];
+  s.mode = FollowMode::GEAR;
+  s.encoder = encoder;
+  s.numerator = numerator;
+  s.denominator = denominator;
+  s.masterOrigin = EncoderManager::getCount64(encoder);
+  s.slaveOrigin = slavePosition;
+  s.lastTarget = slavePosition;
+
+  Serial.printf("[FOLLOW] Slot %d geared to encoder %d at %ld:%ld\n",
+                slot, encoder, (long)numerator, (long)denominator);
+  return true;
+}
+
+bool AxisFollower::engageCam(uint8_t slot, uint8_t encoder, const CamTable& table, const char* name,
+                             int64_t slavePosition) {
+  if (slot >= MAX_MOTORS || !EncoderManager::isEnabled(encoder) || !table.isValid()) return false;
+
+  memcpy(&cams[slot], &table, table.storedSize());
+
+  State& s = states[slot];
+  s.mode = FollowMode::CAM;
+  s.encoder = encoder;
+  s.masterOrigin = EncoderManager::getCount64(encoder);
+  s.slaveOrigin = slavePosition - table.points[0];
+  s.lastTarget = slavePosition;
+  strlcpy(s.camName, name, sizeof(s.camName));
+
+  Serial.printf("[FOLLOW] Slot %d on cam '%s' from encoder %d\n", slot, name, encoder);
+  return true;
+}
+
+void AxisFollower::disengage(uint8_t slot) {
+  if (slot >= MAX_MOTORS || states[slot].mode == FollowMode::NONE) return;
+  states[slot].mode = FollowMode::NONE;
+  Serial.printf("[FOLLOW] Slot %d disengaged\n", slot);
+}
+
+void AxisFollower::disengageAll() {
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    states[i].mode = FollowMode::NONE;
+  }
+}
+
+bool AxisFollower::isEngaged(uint8_t slot) {
+  return slot < MAX_MOTORS && states[slot].mode != FollowMode::NONE;
+}
+
+bool AxisFollower::target(uint8_t slot, int64_t& out) {
+  State& s = states[slot];
+  if (s.mode == FollowMode::NONE) return false;
+
+  if (!EncoderManager::isEnabled(s.encoder)) {
+    disengage(slot);
+    return false;
+  }
+
+  int64_t master = EncoderManager::getCount64(s.encoder) - s.masterOrigin;
+  int64_t next;
+  if (s.mode == FollowMode::CAM) {
+    next = s.slaveOrigin + cams[slot].evaluate(master);
+  } else {
+    // Floor division, so the slave steps at the same master counts in both directions
+    int64_t scaled = master * s.numerator;
+    int64_t quotient = scaled / s.denominator;
+    if ((scaled % s.denominator) < 0) quotient--;
+    next = s.slaveOrigin + quotient;
+  }
+
+  if (next == s.lastTarget) return false;
+
+  s.lastTarget = next;
+  out = next;
+  return true;
+}
+
+void AxisFollower::toJson(uint8_t slot, JsonObject& obj) {
+  if (!isEngaged(slot)) return;
+
+  const State& s = states[slot];
+  JsonObject follow = obj.createNestedObject("follow");
+  follow["encoder"] = s.encoder;
+  if (s.mode == FollowMode::CAM) {
+    follow["mode"] = "cam";
+    follow["cam"] = s.camName;
+  } else {
+    follow["mode"] = "gear";
+    follow["numerator"] = s.numerator;
+    follow["denominator"] = s.denominator;
+  }
+  follow["target"] = s.lastTarget;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+#include "cam_table.h"
+
+// ============================================================================
+// Axis Follower - Slots Slaved to a Master Encoder
+// ============================================================================
+// A following slot gets a new target from the motor task every tick,
+// computed from the master encoder's 64-bit count, so there is no HTTP or
+// queue hop between a handwheel and the axis it drives.
+//
+// Gear mode: slave = slaveOrigin + (master - masterOrigin) * num / den,
+// with the origins captured on engagement. The ratio is applied to the
+// whole distance rather than per tick, so it never accumulates rounding.
+// How closely the slave keeps up is set by its own speed and acceleration.
+//
+// Cam mode: slave = slaveOrigin + cam(master - masterOrigin) - cam(0), from
+// the slot's own RAM copy of a CamTable, so the cam also starts where the
+// slave already is. Engage with the master at the cam's zero.
+//
+// Any command addressed to the slot, a stop, an e-stop or the master
+// encoder going away disengages it.
+
+enum class FollowMode : uint8_t {
+  NONE,
+  GEAR,
+  CAM
+};
+
+class AxisFollower {
+public:
+  // === Engagement (MotorManager mutex held) ===
+  static bool engageGear(uint8_t slot, uint8_t encoder, int32_t numerator, int32_t denominator,
+                         int64_t slavePosition);
+  // Copies `table` (already validated) into the slot's cam buffer
+  static bool engageCam(uint8_t slot, uint8_t encoder, const CamTable& table, const char* name,
+                        int64_t slavePosition);
+  static void disengage(uint8_t slot);
+  static void disengageAll();
+  static bool isEngaged(uint8_t slot);
+
+  // === Motor Task (mutex held) ===
+  // Slave target for this tick; false if the slot is not following or the
+  // target has not changed since the last call
+  static bool target(uint8_t slot, int64_t& out);
+
+  // === Status ===
+  static void toJson(uint8_t slot, JsonObject& obj);
+
+private:
+  struct State {
+    FollowMode mode;
+    uint8_t encoder;
+    int32_t numerator;
+    int32_t denominator;
+    int64_t masterOrigin;
+    int64_t slaveOrigin;
+    int64_t lastTarget;
+    char camName[CAM_NAME_LENGTH];
+  };
+
+  static State states[MAX_MOTORS];
+  static CamTable cams[MAX_MOTORS];  // 1 KB each at CAM_MAX_POINTS
+};
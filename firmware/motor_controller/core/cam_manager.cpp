@@ -0,0 +1,165 @@
+#include "cam_manager.h"
+
+void CamManager::init() {
+  // Ensure cams directory exists
+  if (!LittleFS.exists("/cams")) {
+    LittleFS.mkdir("/cams");
+  }
+
+  Serial.println("[CAM] Cam Manager initialized");
+}
+
+bool CamManager::saveCam(const char* name, const CamTable& table) {
+  if (!isValidName(name) || !table.isValid()) return false;
+
+  if (!camExists(name)) {
+    JsonDocument doc;
+    JsonArray arr = doc.to<JsonArray>();
+    listCams(arr);
+    if (arr.size() >= MAX_CAMS) {
+      Serial.printf("[CAM] Cannot save '%s', %d tables stored\n", name, MAX_CAMS);
+      return false;
+    }
+  }
+
+  String path = getCamPath(name);
+  File file = LittleFS.open(path, "w");
+  if (!file) {
+    Serial.printf("[CAM] Failed to open %s for writing\n", path.c_str());
+    return false;
+  }
+
+  size_t size = table.storedSize();
+  size_t written = file.write(reinterpret_cast<const uint8_t*>(&table), size);
+  file.close();
+
+  Serial.printf("[CAM] Saved cam '%s' (%d points, %d bytes)\n",
+                name, table.header.pointCount, written);
+  return written == size;
+}
+
+bool CamManager::loadCam(const char* name, CamTable& table) {
+  if (!isValidName(name)) return false;
+
+  File file = LittleFS.open(getCamPath(name), "r");
+  if (!file) {
+    Serial.printf("[CAM] Cam '%s' not found\n", name);
+    return false;
+  }
+
+  size_t size = file.size();
+  bool ok = size >= sizeof(CamTableHeader) && size <= sizeof(CamTable) &&
+            file.read(reinterpret_cast<uint8_t*>(&table), size) == size &&
+            table.isValid() && table.storedSize() == size;
+  file.close();
+
+  if (!ok) {
+    Serial.printf("[CAM] Cam '%s' is corrupt\n", name);
+  }
+  return ok;
+}
+
+bool CamManager::deleteCam(const char* name) {
+  if (isValidName(name) && LittleFS.remove(getCamPath(name))) {
+    Serial.printf("[CAM] Deleted cam '%s'\n", name);
+    return true;
+  }
+
+  Serial.printf("[CAM] Failed to delete cam '%s'\n", name);
+  return false;
+}
+
+void CamManager::listCams(JsonArray& arr) {
+  File dir = LittleFS.open("/cams");
+  if (!dir || !dir.isDirectory()) {
+    return;
+  }
+
+  File file = dir.openNextFile();
+  while (file) {
+    if (!file.isDirectory()) {
+      String filename = file.name();
+      if (filename.endsWith(".cam")) {
+        // Remove .cam extension
+        arr.add(filename.substring(0, filename.length() - 4));
+      }
+    }
+    file = dir.openNextFile();
+  }
+}
+
+bool CamManager::camExists(const char* name) {
+  return isValidName(name) && LittleFS.exists(getCamPath(name));
+}
+
+bool CamManager::isValidName(const char* name) {
+  size_t len = strlen(name);
+  if (len == 0 || len >= CAM_NAME_LENGTH) return false;
+
+  for (size_t i = 0; i < len; i++) {
+    char c = name[i];
+    if (!isalnum((unsigned char)c) && c != '-' && c != '_') return false;
+  }
+  return true;
+}
+
+void CamManager::toJson(JsonObject& obj) {
+  JsonArray camsArr = obj.createNestedArray("cams");
+  listCams(camsArr);
+  obj["camCount"] = camsArr.size();
+  obj["maxCams"] = MAX_CAMS;
+  obj["maxPoints"] = CAM_MAX_POINTS;
+}
+
+bool CamManager::camToJson(const char* name, JsonObject& obj) {
+  static CamTable table;  // Loop task only; too large for its stack
+  if (!loadCam(name, table)) {
+    return false;
+  }
+
+  obj["name"] = name;
+  obj["interpolation"] = table.header.interpolation == (uint8_t)CamInterpolation::CUBIC ? "cubic" : "linear";
+  obj["periodic"] = table.header.periodic != 0;
+  obj["masterStep"] = table.header.masterStep;
+  obj["pointCount"] = table.header.pointCount;
+
+  JsonArray pointsArr = obj.createNestedArray("points");
+  for (uint16_t i = 0; i < table.header.pointCount; i++) {
+    pointsArr.add(table.points[i]);
+  }
+  return true;
+}
+
+bool CamManager::camFromJson(const JsonObject& obj, CamTable& table) {
+  memset(&table.header, 0, sizeof(table.header));
+  memcpy(table.header.magic, "CAM1", 4);
+  table.header.version = 1;
+
+  const char* interp = obj["interpolation"] | "linear";
+  if (strcmp(interp, "cubic") == 0) {
+    table.header.interpolation = (uint8_t)CamInterpolation::CUBIC;
+  } else if (strcmp(interp, "linear") == 0) {
+    table.header.interpolation = (uint8_t)CamInterpolation::LINEAR;
+  } else {
+    return false;
+  }
+
+  table.header.periodic = (obj["periodic"] | false) ? 1 : 0;
+  table.header.masterStep = obj["masterStep"] | 0;
+
+  JsonArray pointsArr = obj["points"];
+  if (pointsArr.size() > CAM_MAX_POINTS) return false;
+  for (JsonVariant point : pointsArr) {
+    if (!point.is<int32_t>()) return false;
+    table.points[table.header.pointCount++] = point.as<int32_t>();
+  }
+
+  return table.isValid();
+}
+
+String CamManager::getCamPath(const char* name) {
+  String path = "/cams/";
+  path += name;
+  path += ".cam";
+  return path;
+}
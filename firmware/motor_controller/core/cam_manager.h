@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include "../config.h"
+#include "cam_table.h"
+
+// ============================================================================
+// Cam Manager - Cam Table Storage
+// ============================================================================
+// Cam tables live in CAM_DIR as the binary form described in cam_table.h,
+// one file per name, next to the JSON presets. Tables are uploaded as JSON
+// and converted once; a following slot works from its own copy in RAM
+// (see AxisFollower), so the file system is never touched from the motor
+// task.
+
+class CamManager {
+public:
+  // === Initialization ===
+  static void init();
+
+  // === Table CRUD ===
+  static bool saveCam(const char* name, const CamTable& table);
+  static bool loadCam(const char* name, CamTable& table);
+  static bool deleteCam(const char* name);
+  static void listCams(JsonArray& arr);
+  static bool camExists(const char* name);
+  static bool isValidName(const char* name);  // Letters, digits, '-' and '_'
+
+  // === JSON ===
+  static void toJson(JsonObject& obj);
+  static bool camToJson(const char* name, JsonObject& obj);
+  // Builds a table from {interpolation, periodic, masterStep, points[]};
+  // false if the table is out of range
+  static bool camFromJson(const JsonObject& obj, CamTable& table);
+
+private:
+  static String getCamPath(const char* name);
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// ============================================================================
+// Cam Table - Master to Slave Position Lookup
+// ============================================================================
+// A cam profile is a list of slave positions at evenly spaced master
+// positions: point i is the slave position at master = i * masterStep.
+// Even spacing makes the lookup a single divide, with no search, so the
+// kernel costs the same at any table size.
+//
+// Between points the slave is interpolated linearly (64-bit integer math)
+// or with a Catmull-Rom cubic, which passes through every point with a
+// continuous slope. The cubic runs in single-precision float on offsets
+// from the nearest point, so the result keeps full resolution at any
+// absolute position.
+//
+// A periodic table repeats every masterStep * (pointCount - 1) master
+// counts, and each cycle adds the rise of the last point over the first
+// (zero for a closed cam, a whole slave revolution for a rotary one). A
+// non-periodic table holds its end points outside its master range.
+//
+// Stored on LittleFS as CamTableHeader followed by pointCount int32 slave
+// positions, little-endian. Header-only; scripts/check_kernels.sh checks the
+// lookup on the host.
+
+constexpr uint16_t CAM_MAX_POINTS = 256;
+
+enum class CamInterpolation : uint8_t {
+  LINEAR,
+  CUBIC
+};
+
+struct CamTableHeader {
+  char magic[4];          // "CAM1"
+  uint8_t version;        // 1
+  uint8_t interpolation;  // CamInterpolation
+  uint8_t periodic;       // 1 if the table repeats
+  uint8_t reserved;
+  uint16_t pointCount;
+  uint16_t reserved2;
+  int32_t masterStep;     // Master counts between points
+};
+
+struct CamTable {
+  CamTableHeader header;
+  int32_t points[CAM_MAX_POINTS];
+
+  // Checks the header of a table built in RAM or read from a file
+  bool isValid() const {
+    return header.magic[0] == 'C' && header.magic[1] == 'A' &&
+           header.magic[2] == 'M' && header.magic[3] == '1' &&
+           header.version == 1 &&
+           header.interpolation <= (uint8_t)CamInterpolation::CUBIC &&
+           header.pointCount >= 2 && header.pointCount <= CAM_MAX_POINTS &&
+           header.masterStep > 0;
+  }
+
+  // Bytes of the stored form
+  uint32_t storedSize() const {
+    return sizeof(CamTableHeader) + (uint32_t)header.pointCount * sizeof(int32_t);
+  }
+
+  static int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    if ((a % b) != 0 && ((a < 0) != (b < 0))) q--;
+    return q;
+  }
+
+  // Slave position at `master` counts from the start of the table
+  int64_t evaluate(int64_t master) const {
+    const int32_t n = header.pointCount;
+    const int64_t step = header.masterStep;
+    const int64_t span = step * (n - 1);
+    int64_t cycleOffset = 0;
+
+    if (header.periodic) {
+      int64_t cycles = floorDiv(master, span);
+      master -= cycles * span;
+      cycleOffset = cycles * ((int64_t)points[n - 1] - points[0]);
+    } else if (master <= 0) {
+      return points[0];
+    } else if (master >= span) {
+      return points[n - 1];
+    }
+
+    // master is now in [0, span), so i + 1 is always a point
+    int32_t i = (int32_t)(master / step);
+    int64_t rem = master - (int64_t)i * step;
+
+    const int64_t y1 = points[i];
+    const int64_t y2 = points[i + 1];
+
+    if (header.interpolation == (uint8_t)CamInterpolation::LINEAR || rem == 0) {
+      return cycleOffset + y1 + floorDiv((y2 - y1) * rem, step);
+    }
+
+    // Neighbours past the ends: wrapped with the cycle rise when periodic,
+    // otherwise the end point repeated
+    int64_t rise = (int64_t)points[n - 1] - points[0];
+    int64_t y0, y3;
+    if (i > 0) {
+      y0 = points[i - 1];
+    } else {
+      y0 = header.periodic ? (int64_t)points[n - 2] - rise : y1;
+    }
+    if (i + 2 < n) {
+      y3 = points[i + 2];
+    } else {
+      y3 = header.periodic ? (int64_t)points[1] + rise : y2;
+    }
+
+    // Catmull-Rom relative to y1 (p1 = 0)
+    float t = (float)rem / (float)step;
+    float d0 = (float)(y0 - y1);
+    float d2 = (float)(y2 - y1);
+    float d3 = (float)(y3 - y1);
+    float v = 0.5f * (t * ((d2 - d0) + t * ((2.0f * d0 + 4.0f * d2 - d3) + t * (d3 - d0 - 3.0f * d2))));
+    return cycleOffset + y1 + (int64_t)lroundf(v);
+  }
+};
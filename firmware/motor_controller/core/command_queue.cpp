@@ -0,0 +1,52 @@
+#include "command_queue.h"
+
+// Static member initialization
+SpscRing<QueuedCommand, COMMAND_QUEUE_DEPTH> CommandQueue::rings[COMMAND_SOURCE_COUNT];
+CommandQueueStats CommandQueue::stats[COMMAND_SOURCE_COUNT] = {};
+
+bool CommandQueue::enqueue(CommandSource source, const MotorCommand& cmd) {
+  uint8_t s = static_cast<uint8_t>(source);
+  if (s >= COMMAND_SOURCE_COUNT) return false;
+
+  QueuedCommand entry;
+  entry.cmd = cmd;
+  entry.queuedUs = micros();
+
+  if (!rings[s].push(entry)) {
+    stats[s].dropped = stats[s].dropped + 1;
+    return false;
+  }
+  stats[s].queued = stats[s].queued + 1;
+  return true;
+}
+
+void CommandQueue::discardAll() {
+  for (uint8_t s = 0; s < COMMAND_SOURCE_COUNT; s++) {
+    QueuedCommand entry;
+    while (rings[s].pop(entry)) {
+      stats[s].discarded = stats[s].discarded + 1;
+    }
+  }
+}
+
+uint16_t CommandQueue::pending(CommandSource source) {
+  uint8_t s = static_cast<uint8_t>(source);
+  if (s >= COMMAND_SOURCE_COUNT) return 0;
+  return rings[s].size();
+}
+
+void CommandQueue::toJson(JsonObject& obj) {
+  obj["depth"] = COMMAND_QUEUE_DEPTH;
+
+  for (uint8_t s = 0; s < COMMAND_SOURCE_COUNT; s++) {
+    CommandSource source = static_cast<CommandSource>(s);
+    JsonObject src = obj.createNestedObject(getCommandSourceName(source));
+    src["pending"] = rings[s].size();
+    src["queued"] = stats[s].queued;
+    src["dropped"] = stats[s].dropped;
+    src["executed"] = stats[s].executed;
+    src["discarded"] = stats[s].discarded;
+    src["late"] = stats[s].late;
+    src["maxLatencyUs"] = stats[s].maxLatencyUs;
+  }
+}
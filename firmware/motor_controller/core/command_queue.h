@@ -0,0 +1,103 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include "../config.h"
+
+// ============================================================================
+// Command Queue - Lock-Free Command Hand-off to the Motor Task
+// ============================================================================
+// Each command source (HTTP handlers, preset playback) owns a single-producer
+// single-consumer ring. Producers never block; the motor task drains every
+// ring at the start of its tick, so a slow producer cannot stall the loop.
+
+template <typename T, uint16_t N>
+class SpscRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "Ring size must be a power of two");
+
+public:
+  // Producer side
+  bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= N) return false;
+    items[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool pop(T& item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    item = items[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint16_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+private:
+  T items[N];
+  std::atomic<uint32_t> head{0};
+  std::atomic<uint32_t> tail{0};
+};
+
+struct QueuedCommand {
+  MotorCommand cmd;
+  uint32_t queuedUs;  // micros() when enqueued
+};
+
+// Counters are single-writer: producer side for queued/dropped, motor task
+// for the rest
+struct CommandQueueStats {
+  volatile uint32_t queued;
+  volatile uint32_t dropped;     // Ring full
+  volatile uint32_t executed;
+  volatile uint32_t discarded;   // Flushed by e-stop
+  volatile uint32_t late;        // Waited longer than one motor tick
+  volatile uint32_t maxLatencyUs;
+};
+
+class CommandQueue {
+public:
+  // === Producer Side ===
+  static bool enqueue(CommandSource source, const MotorCommand& cmd);
+
+  // === Consumer Side (motor task only) ===
+  template <typename Handler>
+  static uint8_t drain(Handler handler);
+  static void discardAll();
+
+  // === Status ===
+  static uint16_t pending(CommandSource source);
+  static void toJson(JsonObject& obj);
+
+private:
+  static SpscRing<QueuedCommand, COMMAND_QUEUE_DEPTH> rings[COMMAND_SOURCE_COUNT];
+  static CommandQueueStats stats[COMMAND_SOURCE_COUNT];
+};
+
+// Executes every pending command, oldest source first, and returns the count
+template <typename Handler>
+uint8_t CommandQueue::drain(Handler handler) {
+  const uint32_t tickUs = MOTOR_TASK_INTERVAL_MS * 1000;
+  uint32_t now = micros();
+  uint8_t count = 0;
+
+  for (uint8_t s = 0; s < COMMAND_SOURCE_COUNT; s++) {
+    QueuedCommand entry;
+    while (rings[s].pop(entry)) {
+      uint32_t latency = now - entry.queuedUs;
+      if (latency > tickUs) stats[s].late = stats[s].late + 1;
+      if (latency > stats[s].maxLatencyUs) stats[s].maxLatencyUs = latency;
+
+      handler(entry.cmd);
+      stats[s].executed = stats[s].executed + 1;
+      count++;
+    }
+  }
+  return count;
+}
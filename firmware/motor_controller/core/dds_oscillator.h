@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// DDS Oscillator - Phase-Accumulator Waveforms
+// ============================================================================
+// A 32-bit phase accumulator advanced by a fixed increment every tick, so
+// the frequency resolution is tickHz / 2^32 and a frequency change keeps
+// the phase continuous. The top DDS_LUT_BITS of the phase index a Q15 sine
+// table built at compile time, and the next 16 bits interpolate between
+// entries. Triangle and square are computed from the phase directly.
+//
+// sample() returns offset + amplitude * wave(phase + phaseOffset), so slots
+// sharing a phase accumulator stay locked at their offsets indefinitely.
+//
+// Header-only; scripts/check_kernels.sh checks the waveforms on the host.
+
+constexpr uint8_t DDS_LUT_BITS = 8;
+constexpr uint16_t DDS_LUT_SIZE = 1 << DDS_LUT_BITS;
+
+enum class WaveShape : uint8_t {
+  SINE,
+  TRIANGLE,
+  SQUARE
+};
+
+// sin(2 pi k / DDS_LUT_SIZE) in Q15, one guard entry for interpolation
+struct DdsSineTable {
+  int16_t q15[DDS_LUT_SIZE + 1];
+
+  // Taylor series on [-pi, pi], accurate well past Q15
+  static constexpr double sine(double x) {
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; n++) {
+      term *= -x * x / ((2 * n) * (2 * n + 1));
+      sum += term;
+    }
+    return sum;
+  }
+
+  constexpr DdsSineTable() : q15() {
+    const double pi = 3.14159265358979323846;
+    for (int k = 0; k <= DDS_LUT_SIZE; k++) {
+      int j = k > DDS_LUT_SIZE / 2 ? k - DDS_LUT_SIZE : k;
+      double s = sine(2.0 * pi * j / DDS_LUT_SIZE) * 32767.0;
+      q15[k] = (int16_t)(s < 0 ? s - 0.5 : s + 0.5);
+    }
+  }
+};
+
+constexpr DdsSineTable DDS_SINE = DdsSineTable();
+
+struct DdsOscillator {
+  uint32_t phase = 0;
+  uint32_t increment = 0;     // Phase per tick, 2^32 = one cycle
+  uint32_t phaseOffset = 0;   // Added to the phase of this output only
+  WaveShape shape = WaveShape::SINE;
+  int32_t amplitude = 0;
+  int32_t offset = 0;
+
+  static uint32_t incrementFor(float hz, float tickHz) {
+    return (uint32_t)((double)hz / tickHz * 4294967296.0 + 0.5);
+  }
+
+  static float frequencyOf(uint32_t increment, float tickHz) {
+    return (float)((double)increment * tickHz / 4294967296.0);
+  }
+
+  static uint32_t phaseFromDegrees(float degrees) {
+    double turns = degrees / 360.0;
+    turns -= (double)(int64_t)turns;
+    if (turns < 0) turns += 1.0;
+    return (uint32_t)(turns * 4294967296.0);
+  }
+
+  // Waveform value at `p`, Q15 in [-32767, 32767]
+  static int32_t wave(WaveShape shape, uint32_t p) {
+    switch (shape) {
+      case WaveShape::TRIANGLE: {
+        // Rises from 0 through +1 at a quarter cycle, like the sine
+        int32_t q = (int32_t)(p + 0x40000000u);
+        int32_t fold = (q < 0 ? ~q : q) >> 16;  // 0..32767, peak half a cycle on
+        return 2 * fold - 32767;
+      }
+      case WaveShape::SQUARE:
+        return p < 0x80000000u ? 32767 : -32767;
+      case WaveShape::SINE:
+      default: {
+        uint32_t index = p >> (32 - DDS_LUT_BITS);
+        int32_t frac = (int32_t)((p >> (16 - DDS_LUT_BITS)) & 0xFFFF);
+        int32_t a = DDS_SINE.q15[index];
+        int32_t b = DDS_SINE.q15[index + 1];
+        return a + (((b - a) * frac) >> 16);
+      }
+    }
+  }
+
+  // Output at the current phase, then advances one tick
+  int32_t sample() {
+    int32_t unit = wave(shape, phase + phaseOffset);
+    phase += increment;
+    return offset + (int32_t)(((int64_t)amplitude * unit + 16384) >> 15);
+  }
+};
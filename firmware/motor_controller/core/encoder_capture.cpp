@@ -0,0 +1,202 @@
+#include "encoder_capture.h"
+#include "encoder_manager.h"
+#include <esp_timer.h>
+
+// Static member initialization
+EncoderCapture::Sample EncoderCapture::ring[ENCODER_CAPTURE_DEPTH];
+gptimer_handle_t EncoderCapture::timer = nullptr;
+volatile CaptureState EncoderCapture::state = CaptureState::IDLE;
+uint8_t EncoderCapture::encoder = 0;
+uint32_t EncoderCapture::rate = 0;
+uint16_t EncoderCapture::postTrigger = 0;
+uint16_t EncoderCapture::preWanted = 0;
+CaptureTrigger EncoderCapture::triggerMode = CaptureTrigger::NOW;
+int32_t EncoderCapture::threshold = 0;
+int32_t EncoderCapture::armCount = 0;
+volatile uint16_t EncoderCapture::head = 0;
+volatile uint16_t EncoderCapture::filled = 0;
+volatile uint16_t EncoderCapture::remaining = 0;
+volatile uint16_t EncoderCapture::preTaken = 0;
+
+static const char* captureStateName(CaptureState s) {
+  switch (s) {
+    case CaptureState::IDLE: return "idle";
+    case CaptureState::ARMED: return "armed";
+    case CaptureState::TRIGGERED: return "triggered";
+    case CaptureState::DONE: return "done";
+    default: return "unknown";
+  }
+}
+
+bool EncoderCapture::initTimer() {
+  gptimer_config_t config = {};
+  config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+  config.direction = GPTIMER_COUNT_UP;
+  config.resolution_hz = ENCODER_CAPTURE_TIMER_HZ;
+
+  if (gptimer_new_timer(&config, &timer) != ESP_OK) {
+    timer = nullptr;
+    Serial.println("[CAPTURE] Failed to allocate capture timer!");
+    return false;
+  }
+
+  gptimer_event_callbacks_t callbacks = {};
+  callbacks.on_alarm = onAlarm;
+  gptimer_register_event_callbacks(timer, &callbacks, nullptr);
+  gptimer_enable(timer);
+  return true;
+}
+
+bool EncoderCapture::arm(uint8_t encoderId, uint32_t rateHz, uint16_t samples, uint16_t preTrigger,
+                         CaptureTrigger trigger, int32_t moveThreshold) {
+  if (encoderId >= MAX_ENCODERS || !EncoderManager::isEnabled(encoderId)) return false;
+  if (rateHz < ENCODER_CAPTURE_MIN_HZ || rateHz > ENCODER_CAPTURE_MAX_HZ) return false;
+  if (samples == 0 || samples > ENCODER_CAPTURE_DEPTH || preTrigger >= samples) return false;
+  if (trigger == CaptureTrigger::MOVE && moveThreshold <= 0) return false;
+  if (timer == nullptr && !initTimer()) return false;
+
+  stop();
+
+  // The ISR is idle until the timer starts below
+  uint32_t period = ENCODER_CAPTURE_TIMER_HZ / rateHz;
+  encoder = encoderId;
+  rate = ENCODER_CAPTURE_TIMER_HZ / period;
+  preWanted = preTrigger;
+  postTrigger = samples - preTrigger;
+  triggerMode = trigger;
+  threshold = moveThreshold;
+  armCount = EncoderManager::getCount(encoderId);
+  head = 0;
+  filled = 0;
+  remaining = 0;
+  preTaken = 0;
+
+  gptimer_alarm_config_t alarm = {};
+  alarm.alarm_count = period;
+  alarm.reload_count = 0;
+  alarm.flags.auto_reload_on_alarm = 1;
+  gptimer_set_alarm_action(timer, &alarm);
+
+  state = CaptureState::ARMED;
+  gptimer_start(timer);
+
+  Serial.printf("[CAPTURE] Encoder %d armed: %lu Hz, %d samples (%d before trigger), trigger %s\n",
+                encoderId, (unsigned long)rate, samples, preTrigger,
+                trigger == CaptureTrigger::NOW ? "now" : "move");
+  return true;
+}
+
+void EncoderCapture::stop() {
+  CaptureState s = state;
+  if (s == CaptureState::ARMED || s == CaptureState::TRIGGERED) {
+    gptimer_stop(timer);
+    state = CaptureState::IDLE;
+    Serial.println("[CAPTURE] Capture stopped");
+  }
+}
+
+bool IRAM_ATTR EncoderCapture::onAlarm(gptimer_handle_t t, const gptimer_alarm_event_data_t* edata, void* ctx) {
+  CaptureState s = state;
+  if (s != CaptureState::ARMED && s != CaptureState::TRIGGERED) return false;
+
+  // ESP32Encoder reads the PCNT counter under a spinlock, which is ISR safe
+  Sample& sample = ring[head];
+  sample.count = EncoderManager::getCount(encoder);
+  sample.timeUs = (uint32_t)esp_timer_get_time();
+
+  uint16_t next = head + 1;
+  head = next == ENCODER_CAPTURE_DEPTH ? 0 : next;
+  if (filled < ENCODER_CAPTURE_DEPTH) filled++;
+
+  if (s == CaptureState::ARMED) {
+    if (triggerMode == CaptureTrigger::MOVE && abs(sample.count - armCount) < threshold) return false;
+
+    // This sample is the first of the post-trigger part
+    uint16_t history = filled - 1;
+    preTaken = history < preWanted ? history : preWanted;
+    remaining = postTrigger - 1;
+    s = remaining == 0 ? CaptureState::DONE : CaptureState::TRIGGERED;
+  } else if (--remaining == 0) {
+    s = CaptureState::DONE;
+  }
+
+  state = s;
+  if (s == CaptureState::DONE) gptimer_stop(t);
+  return false;
+}
+
+uint16_t EncoderCapture::sampleCount() {
+  return preTaken + postTrigger;
+}
+
+uint16_t EncoderCapture::firstIndex() {
+  return (head + ENCODER_CAPTURE_DEPTH - sampleCount()) % ENCODER_CAPTURE_DEPTH;
+}
+
+uint32_t EncoderCapture::getDataSize() {
+  if (state != CaptureState::DONE) return 0;
+  return sizeof(EncoderCaptureHeader) + 4UL * sampleCount();
+}
+
+size_t EncoderCapture::readData(uint32_t offset, uint8_t* out, size_t length) {
+  uint32_t size = getDataSize();
+  if (offset >= size) return 0;
+  if (length > size - offset) length = size - offset;
+
+  const uint16_t first = firstIndex();
+  size_t written = 0;
+
+  while (written < length) {
+    uint32_t pos = offset + written;
+    uint8_t chunk[sizeof(EncoderCaptureHeader)];
+    uint32_t chunkStart, chunkSize;
+
+    if (pos < sizeof(EncoderCaptureHeader)) {
+      EncoderCaptureHeader header = {};
+      memcpy(header.magic, "ECAP", 4);
+      header.version = 1;
+      header.encoder = encoder;
+      header.preTrigger = preTaken;
+      header.rateHz = rate;
+      header.sampleCount = sampleCount();
+      header.startUs = ring[first].timeUs;
+      header.startCount = ring[first].count;
+      memcpy(chunk, &header, sizeof(header));
+      chunkStart = 0;
+      chunkSize = sizeof(header);
+    } else {
+      // One record, delta against the previous sample
+      uint32_t i = (pos - sizeof(EncoderCaptureHeader)) / 4;
+      const Sample& cur = ring[(first + i) % ENCODER_CAPTURE_DEPTH];
+      const Sample& prev = ring[(first + (i > 0 ? i - 1 : 0)) % ENCODER_CAPTURE_DEPTH];
+      uint32_t dt = cur.timeUs - prev.timeUs;
+      int32_t dCount = cur.count - prev.count;
+      uint16_t record[2];
+      record[0] = dt > UINT16_MAX ? UINT16_MAX : (uint16_t)dt;
+      record[1] = (uint16_t)(int16_t)constrain(dCount, (int32_t)INT16_MIN, (int32_t)INT16_MAX);
+      memcpy(chunk, record, 4);
+      chunkStart = sizeof(EncoderCaptureHeader) + i * 4;
+      chunkSize = 4;
+    }
+
+    uint32_t skip = pos - chunkStart;
+    size_t n = min((size_t)(chunkSize - skip), length - written);
+    memcpy(out + written, chunk + skip, n);
+    written += n;
+  }
+  return written;
+}
+
+void EncoderCapture::toJson(JsonObject& obj) {
+  CaptureState s = state;
+  obj["state"] = captureStateName(s);
+  obj["encoder"] = encoder;
+  obj["rateHz"] = rate;
+  obj["samples"] = preWanted + postTrigger;
+  obj["preTrigger"] = preWanted;
+  obj["trigger"] = triggerMode == CaptureTrigger::NOW ? "now" : "move";
+  obj["filled"] = s == CaptureState::DONE ? sampleCount() : filled;
+  obj["bytes"] = getDataSize();
+  obj["maxSamples"] = ENCODER_CAPTURE_DEPTH;
+  obj["maxRateHz"] = ENCODER_CAPTURE_MAX_HZ;
+}
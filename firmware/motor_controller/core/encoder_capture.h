@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <driver/gptimer.h>
+#include "../config.h"
+
+// ============================================================================
+// Encoder Capture - High-Rate Count Trace for Loop Tuning
+// ============================================================================
+// A gptimer alarm samples one encoder at up to ENCODER_CAPTURE_MAX_HZ into a
+// static ring, independent of the motor task and of HTTP polling. Each
+// sample is the count and an esp_timer microsecond timestamp.
+//
+// Arming starts sampling at once. Samples taken before the trigger are
+// kept as pre-trigger history, up to the requested amount. The trigger is
+// either immediate or the count moving `threshold` counts from where it
+// was when armed, so a trace can be armed first and the move sent after.
+// The capture stops on its own once the post-trigger samples are in.
+//
+// The finished trace is downloaded as a compact binary stream:
+//   header  EncoderCaptureHeader, little-endian, 24 bytes
+//   records { uint16 dtUs; int16 dCount; } per sample, relative to the
+//           previous sample (the first record is relative to the header)
+
+enum class CaptureState : uint8_t {
+  IDLE,
+  ARMED,      // Sampling, waiting for the trigger
+  TRIGGERED,  // Sampling the post-trigger part
+  DONE
+};
+
+enum class CaptureTrigger : uint8_t {
+  NOW,
+  MOVE
+};
+
+struct EncoderCaptureHeader {
+  char magic[4];          // "ECAP"
+  uint8_t version;        // 1
+  uint8_t encoder;
+  uint16_t preTrigger;    // Samples before the trigger sample
+  uint32_t rateHz;
+  uint32_t sampleCount;
+  uint32_t startUs;       // Timestamp of the first sample
+  int32_t startCount;     // Count of the first sample
+};
+
+class EncoderCapture {
+public:
+  // === Control (loop task) ===
+  // Returns false if the encoder is not enabled or the parameters are out of range
+  static bool arm(uint8_t encoderId, uint32_t rateHz, uint16_t samples, uint16_t preTrigger,
+                  CaptureTrigger trigger, int32_t threshold);
+  static void stop();
+
+  // === Results ===
+  static CaptureState getState() { return state; }
+  static uint32_t getDataSize();  // Bytes of the binary stream, 0 until DONE
+  // Fills `out` with up to `length` bytes of the stream starting at `offset`
+  static size_t readData(uint32_t offset, uint8_t* out, size_t length);
+  static void toJson(JsonObject& obj);
+
+private:
+  struct Sample {
+    uint32_t timeUs;
+    int32_t count;
+  };
+
+  static Sample ring[ENCODER_CAPTURE_DEPTH];
+  static gptimer_handle_t timer;
+  static volatile CaptureState state;
+
+  // Set by arm() while the timer is stopped, read by the ISR
+  static uint8_t encoder;
+  static uint32_t rate;
+  static uint16_t postTrigger;
+  static uint16_t preWanted;
+  static CaptureTrigger triggerMode;
+  static int32_t threshold;
+  static int32_t armCount;
+
+  // Written by the ISR
+  static volatile uint16_t head;       // Next slot to write
+  static volatile uint16_t filled;     // Valid samples in the ring
+  static volatile uint16_t remaining;  // Post-trigger samples still to take
+  static volatile uint16_t preTaken;   // Pre-trigger samples in the result
+
+  static bool initTimer();
+  static uint16_t sampleCount();
+  static uint16_t firstIndex();
+  static bool IRAM_ATTR onAlarm(gptimer_handle_t t, const gptimer_alarm_event_data_t* edata, void* ctx);
+};
@@ -3,9 +3,15 @@
 // Static member initialization
 ESP32Encoder EncoderManager::encoders[MAX_ENCODERS];
 EncoderConfig EncoderManager::configs[MAX_ENCODERS];
-int32_t EncoderManager::lastCounts[MAX_ENCODERS] = {0};
-uint32_t EncoderManager::lastUpdateTime[MAX_ENCODERS] = {0};
-float EncoderManager::velocities[MAX_ENCODERS] = {0};
+VelocityObserverState EncoderManager::observers[MAX_ENCODERS] = {};
+const VelocityObserverConfig EncoderManager::observerConfig = {
+  ENCODER_OBSERVER_BANDWIDTH_HZ, ENCODER_PERIOD_SPEED, ENCODER_PERIOD_WINDOW_US,
+  ENCODER_STOP_US, ENCODER_MAX_GAP_US
+};
+volatile bool EncoderManager::sampleReset[MAX_ENCODERS] = {false};
+int64_t EncoderManager::extendedCounts[MAX_ENCODERS] = {0};
+int32_t EncoderManager::lastRawCounts[MAX_ENCODERS] = {0};
+std::atomic<uint32_t> EncoderManager::countSequence[MAX_ENCODERS] = {};
 
 void EncoderManager::init() {
   // Enable internal pull-ups for encoder pins
@@ -17,9 +23,7 @@ void EncoderManager::init() {
     configs[i].reversed = false;
     configs[i].pulsesPerRevolution = 400;  // Common encoder value (100 PPR x4 quadrature)
     configs[i].linkedMotorSlot = 255;
-    lastCounts[i] = 0;
-    lastUpdateTime[i] = millis();
-    velocities[i] = 0;
+    sampleReset[i] = true;
   }
 
   // Set default pin configurations
@@ -32,25 +36,37 @@ void EncoderManager::init() {
 }
 
 void EncoderManager::update() {
-  uint32_t now = millis();
+  uint32_t now = micros();
 
   for (uint8_t i = 0; i < MAX_ENCODERS; i++) {
     if (!configs[i].enabled) continue;
 
-    int32_t count = encoders[i].getCount();
-    uint32_t dt = now - lastUpdateTime[i];
+    int32_t count = getCount(i);
+    if (sampleReset[i]) {
+      sampleReset[i] = false;
+      lastRawCounts[i] = count;
+      publishCount(i, count);
+      VelocityObserver::reset(observers[i], count, now);
+      continue;
+    }
 
-    if (dt > 0) {
-      // Calculate velocity (counts per second)
-      int32_t dCount = count - lastCounts[i];
-      velocities[i] = (float)dCount * 1000.0f / (float)dt;
+    // Signed 32-bit difference is exact across a wrap of the raw count
+    int32_t delta = (int32_t)((uint32_t)count - (uint32_t)lastRawCounts[i]);
+    lastRawCounts[i] = count;
+    publishCount(i, extendedCounts[i] + delta);
 
-      lastCounts[i] = count;
-      lastUpdateTime[i] = now;
-    }
+    VelocityObserver::update(observers[i], observerConfig, count, now);
   }
 }
 
+void EncoderManager::publishCount(uint8_t encoderId, int64_t count) {
+  uint32_t seq = countSequence[encoderId].load(std::memory_order_relaxed);
+  countSequence[encoderId].store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  extendedCounts[encoderId] = count;
+  countSequence[encoderId].store(seq + 2, std::memory_order_release);
+}
+
 bool EncoderManager::configureEncoder(uint8_t encoderId, uint8_t pinA, uint8_t pinB) {
   if (encoderId >= MAX_ENCODERS) return false;
 
@@ -68,9 +84,7 @@ bool EncoderManager::configureEncoder(uint8_t encoderId, uint8_t pinA, uint8_t p
   encoders[encoderId].clearCount();
 
   configs[encoderId].enabled = true;
-  lastCounts[encoderId] = 0;
-  lastUpdateTime[encoderId] = millis();
-  velocities[encoderId] = 0;
+  sampleReset[encoderId] = true;
 
   Serial.printf("[ENCODER] Encoder %d configured (pins %d, %d)\n", encoderId, pinA, pinB);
   return true;
@@ -82,7 +96,7 @@ bool EncoderManager::disableEncoder(uint8_t encoderId) {
   if (configs[encoderId].enabled) {
     encoders[encoderId].detach();
     configs[encoderId].enabled = false;
-    velocities[encoderId] = 0;
+    sampleReset[encoderId] = true;
     Serial.printf("[ENCODER] Encoder %d disabled\n", encoderId);
   }
 
@@ -103,6 +117,13 @@ void EncoderManager::unlinkFromMotor(uint8_t encoderId) {
   configs[encoderId].linkedMotorSlot = 255;
 }
 
+int8_t EncoderManager::getLinkedEncoder(uint8_t motorSlot) {
+  for (uint8_t i = 0; i < MAX_ENCODERS; i++) {
+    if (configs[i].enabled && configs[i].linkedMotorSlot == motorSlot) return i;
+  }
+  return -1;
+}
+
 int32_t EncoderManager::getCount(uint8_t encoderId) {
   if (encoderId >= MAX_ENCODERS || !configs[encoderId].enabled) return 0;
 
@@ -110,11 +131,31 @@ int32_t EncoderManager::getCount(uint8_t encoderId) {
   return configs[encoderId].reversed ? -count : count;
 }
 
+int64_t EncoderManager::getCount64(uint8_t encoderId) {
+  if (encoderId >= MAX_ENCODERS || !configs[encoderId].enabled) return 0;
+
+  // The motor task writes for well under a microsecond; a reader that
+  // keeps colliding returns the last value it saw
+  int64_t count = 0;
+  for (uint8_t attempt = 0; attempt < MOTOR_STATUS_READ_RETRIES; attempt++) {
+    uint32_t before = countSequence[encoderId].load(std::memory_order_acquire);
+    if (before & 1) continue;
+    count = extendedCounts[encoderId];
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (countSequence[encoderId].load(std::memory_order_relaxed) == before) break;
+  }
+  return count;
+}
+
 float EncoderManager::getRevolutions(uint8_t encoderId) {
   if (encoderId >= MAX_ENCODERS || !configs[encoderId].enabled) return 0.0f;
   if (configs[encoderId].pulsesPerRevolution == 0) return 0.0f;
 
-  return (float)getCount(encoderId) / (float)configs[encoderId].pulsesPerRevolution;
+  // Whole revolutions in integer math, so the fraction keeps its precision
+  int64_t count = getCount64(encoderId);
+  int32_t ppr = configs[encoderId].pulsesPerRevolution;
+  int64_t whole = count / ppr;
+  return (float)whole + (float)(count - whole * ppr) / (float)ppr;
 }
 
 float EncoderManager::getRPM(uint8_t encoderId) {
@@ -122,31 +163,32 @@ float EncoderManager::getRPM(uint8_t encoderId) {
   if (configs[encoderId].pulsesPerRevolution == 0) return 0.0f;
 
   // velocity is counts/second, convert to RPM
-  float revPerSecond = velocities[encoderId] / (float)configs[encoderId].pulsesPerRevolution;
+  float revPerSecond = getVelocity(encoderId) / (float)configs[encoderId].pulsesPerRevolution;
   return revPerSecond * 60.0f;
 }
 
 float EncoderManager::getVelocity(uint8_t encoderId) {
   if (encoderId >= MAX_ENCODERS || !configs[encoderId].enabled) return 0.0f;
-  return configs[encoderId].reversed ? -velocities[encoderId] : velocities[encoderId];
+  if (sampleReset[encoderId]) return 0.0f;
+  return observers[encoderId].output;
 }
 
 void EncoderManager::resetCount(uint8_t encoderId) {
   if (encoderId >= MAX_ENCODERS || !configs[encoderId].enabled) return;
   encoders[encoderId].clearCount();
-  lastCounts[encoderId] = 0;
-  velocities[encoderId] = 0;
+  sampleReset[encoderId] = true;
 }
 
 void EncoderManager::setCount(uint8_t encoderId, int32_t count) {
   if (encoderId >= MAX_ENCODERS || !configs[encoderId].enabled) return;
   encoders[encoderId].setCount(configs[encoderId].reversed ? -count : count);
-  lastCounts[encoderId] = count;
+  sampleReset[encoderId] = true;
 }
 
 void EncoderManager::setReversed(uint8_t encoderId, bool reversed) {
   if (encoderId >= MAX_ENCODERS) return;
   configs[encoderId].reversed = reversed;
+  sampleReset[encoderId] = true;
 }
 
 void EncoderManager::setPulsesPerRevolution(uint8_t encoderId, int32_t ppr) {
@@ -154,6 +196,11 @@ void EncoderManager::setPulsesPerRevolution(uint8_t encoderId, int32_t ppr) {
   configs[encoderId].pulsesPerRevolution = ppr;
 }
 
+int32_t EncoderManager::getPulsesPerRevolution(uint8_t encoderId) {
+  if (encoderId >= MAX_ENCODERS) return 0;
+  return configs[encoderId].pulsesPerRevolution;
+}
+
 bool EncoderManager::isEnabled(uint8_t encoderId) {
   if (encoderId >= MAX_ENCODERS) return false;
   return configs[encoderId].enabled;
@@ -180,9 +227,10 @@ void EncoderManager::encoderToJson(uint8_t encoderId, JsonObject& obj) {
   obj["linkedMotorSlot"] = configs[encoderId].linkedMotorSlot;
 
   if (configs[encoderId].enabled) {
-    obj["count"] = getCount(encoderId);
+    obj["count"] = getCount64(encoderId);
     obj["revolutions"] = getRevolutions(encoderId);
     obj["rpm"] = getRPM(encoderId);
     obj["velocity"] = getVelocity(encoderId);
+    obj["velocitySource"] = observers[encoderId].lowSpeed ? "period" : "observer";
   }
 }
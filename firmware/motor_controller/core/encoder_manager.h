@@ -3,7 +3,9 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <ESP32Encoder.h>
+#include <atomic>
 #include "../config.h"
+#include "velocity_observer.h"
 
 // ============================================================================
 // Encoder Manager - Hardware PCNT Encoder Interface
@@ -22,16 +24,20 @@ class EncoderManager {
 public:
   // === Initialization ===
   static void init();
-  static void update();  // Called from encoder task
+  static void update();  // Called from the motor task every tick
 
   // === Encoder Configuration ===
   static bool configureEncoder(uint8_t encoderId, uint8_t pinA, uint8_t pinB);
   static bool disableEncoder(uint8_t encoderId);
   static bool linkToMotor(uint8_t encoderId, uint8_t motorSlot);
   static void unlinkFromMotor(uint8_t encoderId);
+  static int8_t getLinkedEncoder(uint8_t motorSlot);  // -1 if none is enabled and linked
 
   // === Reading ===
+  // Live hardware count, low 32 bits: wraps, so only use differences
   static int32_t getCount(uint8_t encoderId);
+  // Count extended to 64 bits at the last motor task sample; lock-free
+  static int64_t getCount64(uint8_t encoderId);
   static float getRevolutions(uint8_t encoderId);
   static float getRPM(uint8_t encoderId);
   static float getVelocity(uint8_t encoderId);  // counts per second
@@ -41,6 +47,7 @@ public:
   static void setCount(uint8_t encoderId, int32_t count);
   static void setReversed(uint8_t encoderId, bool reversed);
   static void setPulsesPerRevolution(uint8_t encoderId, int32_t ppr);
+  static int32_t getPulsesPerRevolution(uint8_t encoderId);
 
   // === Status ===
   static bool isEnabled(uint8_t encoderId);
@@ -51,8 +58,16 @@ private:
   static ESP32Encoder encoders[MAX_ENCODERS];
   static EncoderConfig configs[MAX_ENCODERS];
 
-  // For velocity calculation
-  static int32_t lastCounts[MAX_ENCODERS];
-  static uint32_t lastUpdateTime[MAX_ENCODERS];
-  static float velocities[MAX_ENCODERS];
+  // Sampled by the motor task, counts as reported by getCount()
+  static VelocityObserverState observers[MAX_ENCODERS];
+  static const VelocityObserverConfig observerConfig;
+  static volatile bool sampleReset[MAX_ENCODERS];  // Count changed outside the motor task
+
+  // 64-bit count, accumulated from 32-bit deltas by the motor task. Readers
+  // retry on a sequence change (odd = write in progress) instead of locking.
+  static int64_t extendedCounts[MAX_ENCODERS];
+  static int32_t lastRawCounts[MAX_ENCODERS];
+  static std::atomic<uint32_t> countSequence[MAX_ENCODERS];
+
+  static void publishCount(uint8_t encoderId, int64_t count);
 };
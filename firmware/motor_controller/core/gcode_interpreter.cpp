@@ -0,0 +1,421 @@
+#include "gcode_interpreter.h"
+#include "motor_manager.h"
+#include "safety_manager.h"
+
+// Static member initialization
+SpscRing<GcodeBlock, GCODE_QUEUE_DEPTH> GcodeInterpreter::ring;
+std::atomic<bool> GcodeInterpreter::busy{false};
+std::atomic<bool> GcodeInterpreter::cancelRequested{false};
+std::atomic<uint16_t> GcodeInterpreter::feedOverride{100};
+
+int32_t GcodeInterpreter::position[MAX_MOTORS] = {0};
+bool GcodeInterpreter::absolute = true;
+bool GcodeInterpreter::rapidMode = true;
+float GcodeInterpreter::feedRate = GCODE_DEFAULT_FEED;
+char GcodeInterpreter::lastError[48] = "";
+char GcodeInterpreter::serialLine[GCODE_LINE_MAX + 1] = "";
+uint8_t GcodeInterpreter::serialLength = 0;
+bool GcodeInterpreter::serialPending = false;
+bool GcodeInterpreter::serialOverflow = false;
+
+GcodeBlock GcodeInterpreter::current = {};
+bool GcodeInterpreter::active = false;
+uint32_t GcodeInterpreter::dwellStart = 0;
+volatile uint32_t GcodeInterpreter::executed = 0;
+volatile uint32_t GcodeInterpreter::linesAccepted = 0;
+
+static bool isStepDir(MotorType type) {
+  return type == MotorType::STEPPER_A4988 || type == MotorType::STEPPER_DRV8825;
+}
+
+// ============================================================================
+// Producer Side
+// ============================================================================
+
+GcodeResult GcodeInterpreter::submitLine(const char* line) {
+  if (SafetyManager::isEstopActive()) return fail("E-stop active");
+  if (cancelRequested.load(std::memory_order_acquire)) return GcodeResult::QUEUE_FULL;
+
+  int gCodes[4];
+  uint8_t gCount = 0;
+  int mCode = -1;
+  bool hasAxis[MAX_MOTORS] = {false};
+  float axis[MAX_MOTORS] = {0};
+  bool hasF = false, hasP = false, hasS = false;
+  float f = 0, p = 0, s = 0;
+
+  // Collect the words, skipping comments, line numbers and checksums
+  const char* c = line;
+  while (*c) {
+    char letter = toupper(*c);
+    if (letter == ';' || letter == '*') break;
+    if (letter == '(') {
+      while (*c && *c != ')') c++;
+      if (*c) c++;
+      continue;
+    }
+    if (isspace((unsigned char)letter)) {
+      c++;
+      continue;
+    }
+    if (!isalpha((unsigned char)letter)) return fail("Unexpected character");
+
+    char* end;
+    float value = strtof(++c, &end);
+    if (end == c) return fail("Missing number");
+    c = end;
+
+    switch (letter) {
+      case 'G':
+        if (gCount >= 4) return fail("Too many G words");
+        gCodes[gCount++] = (int)value;
+        break;
+      case 'M':
+        if (mCode >= 0) return fail("One M code per line");
+        mCode = (int)value;
+        break;
+      case 'F': hasF = true; f = value; break;
+      case 'P': hasP = true; p = value; break;
+      case 'S': hasS = true; s = value; break;
+      case 'N': break;
+      default: {
+        const char* found = strchr(GCODE_AXIS_LETTERS, letter);
+        if (found == nullptr) return fail("Unsupported word");
+        uint8_t slot = found - GCODE_AXIS_LETTERS;
+        if (!isMappedAxis(slot)) return fail("Axis not mapped to a stepper or servo");
+        hasAxis[slot] = true;
+        axis[slot] = value;
+        break;
+      }
+    }
+  }
+
+  // Modal state only changes once the line has been accepted
+  bool newAbsolute = absolute;
+  bool newRapid = rapidMode;
+  float newFeed = feedRate;
+  bool dwell = false, home = false;
+
+  for (uint8_t i = 0; i < gCount; i++) {
+    switch (gCodes[i]) {
+      case 0: newRapid = true; break;
+      case 1: newRapid = false; break;
+      case 4: dwell = true; break;
+      case 28: home = true; break;
+      case 90: newAbsolute = true; break;
+      case 91: newAbsolute = false; break;
+      default: return fail("Unsupported G code");
+    }
+  }
+  if (hasF) {
+    if (f <= 0) return fail("Feed must be positive");
+    newFeed = f;
+  }
+
+  uint8_t axisMask = 0;
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    if (hasAxis[i]) axisMask |= 1 << i;
+  }
+
+  GcodeBlock block = {};
+  bool emit = false;
+
+  if (mCode >= 0) {
+    if (gCount > 0 || axisMask != 0) return fail("M code mixed with motion");
+    switch (mCode) {
+      case 17:
+      case 18:
+        block.type = mCode == 17 ? GcodeBlockType::ENABLE : GcodeBlockType::DISABLE;
+        for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+          if (isStepDir(MotorManager::getMotorType(i))) block.axisMask |= 1 << i;
+        }
+        emit = true;
+        break;
+      case 220:
+        if (!hasS) return fail("M220 needs S");
+        setFeedOverride(s < 0 ? 0 : (uint16_t)s);
+        break;
+      default:
+        return fail("Unsupported M code");
+    }
+  } else if (dwell) {
+    float ms = hasP ? p : (hasS ? s * 1000.0f : 0.0f);
+    if (ms < 0) return fail("Negative dwell");
+    block.type = GcodeBlockType::DWELL;
+    block.dwellMs = (uint32_t)ms;
+    emit = true;
+  } else if (home || axisMask != 0) {
+    // Start from where the motors really are once everything has finished
+    if (ring.size() == 0 && !busy.load(std::memory_order_acquire)) syncPosition();
+
+    block.type = GcodeBlockType::MOVE;
+    block.rapid = home || newRapid;
+    block.feed = newFeed / 60.0f;
+
+    for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+      int32_t target;
+      if (home) {
+        if (axisMask != 0 && !hasAxis[i]) continue;
+        if (!isMappedAxis(i)) continue;
+        target = 0;
+      } else {
+        if (!hasAxis[i]) continue;
+        target = lroundf(axis[i]) + (newAbsolute ? 0 : position[i]);
+      }
+
+      if (MotorManager::getMotorType(i) == MotorType::SERVO && (target < 0 || target > 180)) {
+        return fail("Servo angle out of range");
+      }
+      block.axisMask |= 1 << i;
+      block.target[i] = target;
+    }
+    emit = block.axisMask != 0;
+  }
+
+  if (emit && !ring.push(block)) return GcodeResult::QUEUE_FULL;
+
+  absolute = newAbsolute;
+  rapidMode = newRapid;
+  feedRate = newFeed;
+  if (emit && block.type == GcodeBlockType::MOVE) {
+    for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+      if (block.axisMask & (1 << i)) position[i] = block.target[i];
+    }
+  }
+  linesAccepted = linesAccepted + 1;
+  return GcodeResult::OK;
+}
+
+const char* GcodeInterpreter::getLastError() {
+  return lastError;
+}
+
+// Ping-pong flow control: a line is answered once it is queued, and while
+// the queue is full nothing more is read, so the host waits for the "ok"
+void GcodeInterpreter::pollSerial() {
+  if (serialPending) {
+    GcodeResult result = submitLine(serialLine);
+    if (result == GcodeResult::QUEUE_FULL) return;
+    if (result == GcodeResult::OK) Serial.println("ok");
+    else Serial.printf("error: %s\n", lastError);
+    serialPending = false;
+    serialLength = 0;
+  }
+
+  while (Serial.available()) {
+    char ch = Serial.read();
+    if (ch == '\r') continue;
+    if (ch != '\n') {
+      if (serialLength < GCODE_LINE_MAX) serialLine[serialLength++] = ch;
+      else serialOverflow = true;
+      continue;
+    }
+
+    serialLine[serialLength] = '\0';
+    if (serialOverflow) {
+      Serial.println("error: Line too long");
+      serialOverflow = false;
+      serialLength = 0;
+      continue;
+    }
+
+    GcodeResult result = submitLine(serialLine);
+    if (result == GcodeResult::QUEUE_FULL) {
+      serialPending = true;
+      return;
+    }
+    if (result == GcodeResult::OK) Serial.println("ok");
+    else Serial.printf("error: %s\n", lastError);
+    serialLength = 0;
+  }
+}
+
+void GcodeInterpreter::cancel() {
+  // The motor task owns the ring's consumer side and does the flush
+  cancelRequested.store(true, std::memory_order_release);
+}
+
+void GcodeInterpreter::setFeedOverride(uint16_t percent) {
+  if (percent < GCODE_OVERRIDE_MIN) percent = GCODE_OVERRIDE_MIN;
+  if (percent > GCODE_OVERRIDE_MAX) percent = GCODE_OVERRIDE_MAX;
+  feedOverride.store(percent, std::memory_order_relaxed);
+}
+
+bool GcodeInterpreter::isMappedAxis(uint8_t slot) {
+  MotorType type = MotorManager::getMotorType(slot);
+  return isStepDir(type) || type == MotorType::STEPPER_ULN2003 || type == MotorType::SERVO;
+}
+
+void GcodeInterpreter::syncPosition() {
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    MotorStatus status;
+    if (MotorManager::getStatus(i, status)) position[i] = status.target;
+  }
+}
+
+GcodeResult GcodeInterpreter::fail(const char* message) {
+  strncpy(lastError, message, sizeof(lastError) - 1);
+  lastError[sizeof(lastError) - 1] = '\0';
+  return GcodeResult::ERROR;
+}
+
+// ============================================================================
+// Consumer Side
+// ============================================================================
+
+void GcodeInterpreter::service() {
+  if (cancelRequested.load(std::memory_order_acquire)) {
+    GcodeBlock skipped;
+    while (ring.pop(skipped)) {}
+    if (active) stopBlock();
+    active = false;
+    busy.store(false, std::memory_order_release);
+    cancelRequested.store(false, std::memory_order_release);
+    Serial.println("[GCODE] Stream cancelled");
+    return;
+  }
+
+  // Runs after this tick's status is published. Commands sent when a block
+  // starts are applied by the next updateAll(); an axis group starts at once.
+  if (active) {
+    if (!blockDone()) return;
+    active = false;
+    executed = executed + 1;
+  }
+
+  busy.store(true, std::memory_order_release);
+  if (!ring.pop(current)) {
+    busy.store(false, std::memory_order_release);
+    return;
+  }
+  startBlock();
+  active = true;
+}
+
+void GcodeInterpreter::discardAll() {
+  GcodeBlock skipped;
+  while (ring.pop(skipped)) {}
+  active = false;
+  busy.store(false, std::memory_order_release);
+  cancelRequested.store(false, std::memory_order_release);
+}
+
+void GcodeInterpreter::startBlock() {
+  switch (current.type) {
+    case GcodeBlockType::DWELL:
+      dwellStart = millis();
+      return;
+
+    case GcodeBlockType::ENABLE:
+    case GcodeBlockType::DISABLE: {
+      CommandType cmd = current.type == GcodeBlockType::ENABLE ? CommandType::ENABLE : CommandType::DISABLE;
+      for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+        if (current.axisMask & (1 << i)) MotorManager::sendCommand(i, cmd, 0, 0, CommandSource::GCODE);
+      }
+      return;
+    }
+
+    case GcodeBlockType::MOVE:
+      break;
+  }
+
+  // Path length over every axis in the block, in axis units
+  int32_t delta[MAX_MOTORS] = {0};
+  float pathSq = 0;
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    MotorStatus status;
+    if (!(current.axisMask & (1 << i))) continue;
+    if (!MotorManager::getStatus(i, status)) {
+      current.axisMask &= ~(1 << i);
+      continue;
+    }
+    delta[i] = current.target[i] - status.position;
+    pathSq += (float)delta[i] * (float)delta[i];
+  }
+
+  float feed = current.feed * feedOverride.load(std::memory_order_relaxed) / 100.0f;
+  float seconds = (current.rapid || pathSq == 0) ? 0.0f : sqrtf(pathSq) / feed;
+
+  // Step/dir steppers share one ramp so the path stays a straight line; the
+  // feed caps the rate of the longest axis
+  uint8_t groupSlots[MAX_MOTORS];
+  int32_t groupTargets[MAX_MOTORS];
+  uint8_t groupCount = 0;
+  int32_t longest = 0;
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    if (!(current.axisMask & (1 << i)) || delta[i] == 0) continue;
+    if (!isStepDir(MotorManager::getMotorType(i))) continue;
+    groupSlots[groupCount] = i;
+    groupTargets[groupCount++] = current.target[i];
+    if (abs(delta[i]) > longest) longest = abs(delta[i]);
+  }
+
+  bool grouped = false;
+  if (groupCount > 0) {
+    float maxRate = seconds > 0 ? (float)longest / seconds : 0.0f;
+    grouped = MotorManager::startGroupLocked(groupSlots, groupTargets, groupCount, maxRate) >= 0;
+  }
+
+  // Servos sweep over the move time; the rest run at their own speed
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    if (!(current.axisMask & (1 << i))) continue;
+    MotorType type = MotorManager::getMotorType(i);
+
+    if (type == MotorType::SERVO) {
+      uint32_t ms = (uint32_t)(seconds * 1000.0f);
+      MotorManager::sendCommand(i, CommandType::SET_ANGLE, current.target[i], ms > 65535 ? 65535 : ms,
+                                CommandSource::GCODE);
+    } else if (!(grouped && isStepDir(type) && delta[i] != 0)) {
+      MotorManager::sendCommand(i, CommandType::SET_POSITION, current.target[i], 0, CommandSource::GCODE);
+    }
+  }
+}
+
+bool GcodeInterpreter::blockDone() {
+  if (current.type == GcodeBlockType::DWELL) {
+    return millis() - dwellStart >= current.dwellMs;
+  }
+
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    MotorStatus status;
+    if (!(current.axisMask & (1 << i))) continue;
+    if (MotorManager::getStatus(i, status) && (status.moving || status.queuedMoves > 0)) return false;
+  }
+  return true;
+}
+
+void GcodeInterpreter::stopBlock() {
+  if (current.type != GcodeBlockType::MOVE) return;
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    if (current.axisMask & (1 << i)) MotorManager::sendCommand(i, CommandType::STOP, 0, 0, CommandSource::GCODE);
+  }
+}
+
+// ============================================================================
+// Status
+// ============================================================================
+
+uint16_t GcodeInterpreter::queued() {
+  return ring.size();
+}
+
+uint16_t GcodeInterpreter::available() {
+  return GCODE_QUEUE_DEPTH - ring.size();
+}
+
+void GcodeInterpreter::toJson(JsonObject& obj) {
+  obj["queued"] = queued();
+  obj["available"] = available();
+  obj["depth"] = GCODE_QUEUE_DEPTH;
+  obj["running"] = busy.load(std::memory_order_acquire);
+  obj["linesAccepted"] = linesAccepted;
+  obj["blocksExecuted"] = executed;
+  obj["absolute"] = absolute;
+  obj["feed"] = feedRate;
+  obj["feedOverride"] = feedOverride.load(std::memory_order_relaxed);
+
+  JsonArray pos = obj.createNestedArray("position");
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    pos.add(position[i]);
+  }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include "../config.h"
+#include "command_queue.h"
+
+// ============================================================================
+// G-code Interpreter - Streamed Motion Blocks for the Motor Task
+// ============================================================================
+// Lines arrive over HTTP and Serial, both read by the loop task, which parses
+// them into fixed-size blocks. Blocks wait in a single-producer single-
+// consumer ring; the motor task only pops a block and starts it once the
+// previous one has finished, so parsing never runs on the control core and
+// a toolpath is not limited by the preset step count.
+//
+// Supported subset:
+//   G0 / G1   Rapid / feed move (X Y Z A, modal), F in units/min
+//   G4        Dwell, P milliseconds or S seconds
+//   G28       Move the listed axes (or every mapped axis) to 0
+//   G90 / G91 Absolute / relative coordinates
+//   M17 / M18 Enable / disable the stepper drivers
+//   M220 S    Feed override in percent
+
+enum class GcodeBlockType : uint8_t {
+  MOVE,
+  DWELL,
+  ENABLE,
+  DISABLE
+};
+
+struct GcodeBlock {
+  GcodeBlockType type;
+  bool rapid;                  // G0/G28: every axis at its own max speed
+  uint8_t axisMask;            // Bit per slot
+  int32_t target[MAX_MOTORS];
+  float feed;                  // Units/s along the path (G1)
+  uint32_t dwellMs;
+};
+
+enum class GcodeResult : uint8_t {
+  OK,
+  QUEUE_FULL,  // Nothing changed, submit the line again later
+  ERROR        // See getLastError()
+};
+
+class GcodeInterpreter {
+public:
+  // === Producer Side (loop task only) ===
+  static GcodeResult submitLine(const char* line);
+  static const char* getLastError();
+  static void pollSerial();  // Answers each line with "ok" or "error: ..."
+  static void cancel();      // Flush queued blocks and stop the running one
+  static void setFeedOverride(uint16_t percent);
+
+  // === Consumer Side (motor task only) ===
+  static void service();  // From MotorManager::updateAll(), mutex held
+  static void discardAll();           // E-stop
+
+  // === Status ===
+  static uint16_t queued();
+  static uint16_t available();
+  static void toJson(JsonObject& obj);
+
+private:
+  static SpscRing<GcodeBlock, GCODE_QUEUE_DEPTH> ring;
+  static std::atomic<bool> busy;             // Block popped and not finished
+  static std::atomic<bool> cancelRequested;
+  static std::atomic<uint16_t> feedOverride;
+
+  // Parser state (loop task)
+  static int32_t position[MAX_MOTORS];       // End of the last queued block
+  static bool absolute;
+  static bool rapidMode;
+  static float feedRate;                     // Units/min
+  static char lastError[48];
+  static char serialLine[GCODE_LINE_MAX + 1];
+  static uint8_t serialLength;
+  static bool serialPending;                 // Complete line waiting for room
+  static bool serialOverflow;
+
+  // Executor state (motor task)
+  static GcodeBlock current;
+  static bool active;
+  static uint32_t dwellStart;
+  static volatile uint32_t executed;
+  static volatile uint32_t linesAccepted;
+
+  static bool isMappedAxis(uint8_t slot);
+  static void syncPosition();
+  static GcodeResult fail(const char* message);
+  static void startBlock();
+  static bool blockDone();
+  static void stopBlock();
+};
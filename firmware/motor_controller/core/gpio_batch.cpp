@@ -0,0 +1,200 @@
+#include "gpio_batch.h"
+#include <soc/gpio_struct.h>
+
+// Static member initialization
+uint32_t GpioBatch::level[2] = {0, 0};
+uint32_t GpioBatch::known[2] = {0, 0};
+uint32_t GpioBatch::setMask[2] = {0, 0};
+uint32_t GpioBatch::clearMask[2] = {0, 0};
+uint32_t GpioBatch::duty[GPIO_BATCH_PIN_COUNT];
+uint64_t GpioBatch::dutyStaged = 0;
+bool GpioBatch::staging = false;
+TaskHandle_t GpioBatch::stagingTask = nullptr;
+portMUX_TYPE GpioBatch::lock = portMUX_INITIALIZER_UNLOCKED;
+uint32_t GpioBatch::pinWrites = 0;
+uint32_t GpioBatch::dutyWrites = 0;
+uint32_t GpioBatch::elided = 0;
+uint32_t GpioBatch::commits = 0;
+
+void GpioBatch::init() {
+  portENTER_CRITICAL(&lock);
+  for (uint8_t b = 0; b < 2; b++) {
+    level[b] = known[b] = setMask[b] = clearMask[b] = 0;
+  }
+  for (uint8_t pin = 0; pin < GPIO_BATCH_PIN_COUNT; pin++) {
+    duty[pin] = DUTY_UNKNOWN;
+  }
+  dutyStaged = 0;
+  staging = false;
+  portEXIT_CRITICAL(&lock);
+}
+
+void GpioBatch::configureOutput(uint8_t pin, bool high) {
+  if (pin >= GPIO_BATCH_PIN_COUNT) return;
+
+  forget(pin);
+  uint8_t b = pin >> 5;
+  uint32_t bit = 1UL << (pin & 31);
+  uint32_t set[2] = {0, 0};
+  uint32_t clear[2] = {0, 0};
+  (high ? set : clear)[b] = bit;
+  portENTER_CRITICAL(&lock);
+  writeBanks(set, clear);  // Level first, so enabling the output does not glitch
+  portEXIT_CRITICAL(&lock);
+  pinMode(pin, OUTPUT);
+
+  portENTER_CRITICAL(&lock);
+  known[b] |= bit;
+  if (high) level[b] |= bit; else level[b] &= ~bit;
+  pinWrites++;
+  portEXIT_CRITICAL(&lock);
+}
+
+void GpioBatch::forget(uint8_t pin) {
+  if (pin >= GPIO_BATCH_PIN_COUNT) return;
+
+  uint8_t b = pin >> 5;
+  uint32_t bit = 1UL << (pin & 31);
+  portENTER_CRITICAL(&lock);
+  known[b] &= ~bit;
+  setMask[b] &= ~bit;
+  clearMask[b] &= ~bit;
+  duty[pin] = DUTY_UNKNOWN;
+  dutyStaged &= ~(1ULL << pin);
+  portEXIT_CRITICAL(&lock);
+}
+
+void GpioBatch::write(uint8_t pin, bool high) {
+  if (pin >= GPIO_BATCH_PIN_COUNT) return;
+
+  uint32_t bit = 1UL << (pin & 31);
+  writeBank(pin >> 5, bit, high ? bit : 0);
+}
+
+void GpioBatch::writeBank(uint8_t b, uint32_t mask, uint32_t levels) {
+  if (b > 1 || mask == 0) return;
+  bool stage = stagingHere();
+
+  portENTER_CRITICAL(&lock);
+  // Only pins whose level is unknown or different
+  levels &= mask;
+  uint32_t changed = mask & (~known[b] | (level[b] ^ levels));
+  if (changed == 0) {
+    elided++;
+    portEXIT_CRITICAL(&lock);
+    return;
+  }
+
+  known[b] |= changed;
+  level[b] = (level[b] & ~changed) | (levels & changed);
+  pinWrites++;
+
+  uint32_t set = levels & changed;
+  uint32_t clear = changed & ~levels;
+
+  if (stage) {
+    // The last write in a tick wins
+    setMask[b] = (setMask[b] & ~clear) | set;
+    clearMask[b] = (clearMask[b] & ~set) | clear;
+  } else {
+    // Overrides anything the motor task staged for these pins
+    setMask[b] &= ~changed;
+    clearMask[b] &= ~changed;
+    uint32_t sets[2] = {0, 0};
+    uint32_t clears[2] = {0, 0};
+    sets[b] = set;
+    clears[b] = clear;
+    writeBanks(sets, clears);
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+void GpioBatch::writeDuty(uint8_t pin, uint32_t value) {
+  if (pin >= GPIO_BATCH_PIN_COUNT) return;
+  bool stage = stagingHere();
+
+  portENTER_CRITICAL(&lock);
+  if (duty[pin] == value) {
+    elided++;
+    portEXIT_CRITICAL(&lock);
+    return;
+  }
+  duty[pin] = value;
+  dutyWrites++;
+  if (stage) {
+    dutyStaged |= 1ULL << pin;
+    portEXIT_CRITICAL(&lock);
+    return;
+  }
+  dutyStaged &= ~(1ULL << pin);
+  portEXIT_CRITICAL(&lock);
+
+  flushDuty(pin);
+}
+
+void GpioBatch::begin() {
+  portENTER_CRITICAL(&lock);
+  stagingTask = xTaskGetCurrentTaskHandle();
+  staging = true;
+  portEXIT_CRITICAL(&lock);
+}
+
+void GpioBatch::commit() {
+  portENTER_CRITICAL(&lock);
+  staging = false;
+  if ((setMask[0] | setMask[1] | clearMask[0] | clearMask[1]) != 0) {
+    writeBanks(setMask, clearMask);
+    for (uint8_t b = 0; b < 2; b++) {
+      setMask[b] = clearMask[b] = 0;
+    }
+    commits++;
+  }
+  uint64_t pending = dutyStaged;
+  dutyStaged = 0;
+  portEXIT_CRITICAL(&lock);
+
+  // Duties after the pins, the order the drivers write them in
+  while (pending != 0) {
+    uint8_t pin = __builtin_ctzll(pending);
+    pending &= pending - 1;
+    flushDuty(pin);
+  }
+}
+
+bool GpioBatch::stagingHere() {
+  return staging && xTaskGetCurrentTaskHandle() == stagingTask;
+}
+
+// ledcWrite() cannot run under the spinlock. Writes the cached duty until
+// it stops changing, so a write from another task in between (an
+// emergency stop) is never overwritten by a stale duty.
+void GpioBatch::flushDuty(uint8_t pin) {
+  portENTER_CRITICAL(&lock);
+  uint32_t value = duty[pin];
+  portEXIT_CRITICAL(&lock);
+
+  while (value != DUTY_UNKNOWN) {
+    ledcWrite(pin, value);
+
+    portENTER_CRITICAL(&lock);
+    uint32_t now = duty[pin];
+    portEXIT_CRITICAL(&lock);
+    if (now == value) break;
+    value = now;
+  }
+}
+
+// Clears before sets, one register write per bank that has changes
+void GpioBatch::writeBanks(const uint32_t set[2], const uint32_t clear[2]) {
+  if (clear[0]) GPIO.out_w1tc = clear[0];
+  if (clear[1]) GPIO.out1_w1tc.val = clear[1];
+  if (set[0]) GPIO.out_w1ts = set[0];
+  if (set[1]) GPIO.out1_w1ts.val = set[1];
+}
+
+void GpioBatch::toJson(JsonObject& obj) {
+  obj["pinWrites"] = pinWrites;
+  obj["dutyWrites"] = dutyWrites;
+  obj["elided"] = elided;
+  obj["commits"] = commits;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+
+// ============================================================================
+// GPIO Batch - Staged Pin and PWM Writes for the Motor Task
+// ============================================================================
+// Drivers write their bridge, coil, enable and mode pins through here rather
+// than digitalWrite()/ledcWrite(). A write that repeats the last level (or
+// duty) sent to the pin is dropped, so a motor holding its speed costs no
+// I/O at all.
+//
+// During a motor task tick, between begin() and commit(), the remaining
+// changes are collected as set/clear masks and written with one out_w1tc
+// and one out_w1ts per bank, so edges from every slot land together; duties
+// follow, after the pins. Outside a tick (slot setup, emergency stops from
+// other tasks) writes go out immediately.
+//
+// Only the task that called begin() stages. Writes from any other task,
+// such as an emergency stop from the loop or web task (which does not wait
+// for the MotorManager mutex), go out at once and drop whatever the motor
+// task had staged for those pins. A spinlock guards the cache and masks.
+//
+// STEP and DIR pins (step engine ISR, RMT output) are timed against the
+// pulses and do not pass through here.
+
+class GpioBatch {
+public:
+  static void init();
+
+  // pinMode(OUTPUT) and drive `level` now, whatever is staged
+  static void configureOutput(uint8_t pin, bool level);
+  // Drops the remembered level and duty, for a pin handed to (or taken back
+  // from) another peripheral
+  static void forget(uint8_t pin);
+
+  static void write(uint8_t pin, bool level);
+  // Drives the pins in `mask` of one bank (pin / 32) to `levels` in one
+  // register write per direction, e.g. all coils of a stepper at once
+  static void writeBank(uint8_t bank, uint32_t mask, uint32_t levels);
+  static void writeDuty(uint8_t pin, uint32_t duty);  // LEDC-attached pin
+
+  // Motor task: stage writes from begin() until commit()
+  static void begin();
+  static void commit();
+
+  // === Status ===
+  static void toJson(JsonObject& obj);
+
+private:
+  static constexpr uint32_t DUTY_UNKNOWN = UINT32_MAX;
+
+  static uint32_t level[2];     // Last level written or staged, per bank
+  static uint32_t known[2];     // Pins whose level is known
+  static uint32_t setMask[2];   // Staged this tick
+  static uint32_t clearMask[2];
+  static uint32_t duty[GPIO_BATCH_PIN_COUNT];
+  static uint64_t dutyStaged;   // Pins with a staged duty
+  static bool staging;
+  static TaskHandle_t stagingTask;  // Caller of begin()
+  static portMUX_TYPE lock;
+
+  // Since boot
+  static uint32_t pinWrites;
+  static uint32_t dutyWrites;
+  static uint32_t elided;
+  static uint32_t commits;
+
+  static bool stagingHere();
+  static void flushDuty(uint8_t pin);
+  static void writeBanks(const uint32_t set[2], const uint32_t clear[2]);
+};
@@ -0,0 +1,138 @@
+#include "ledc_allocator.h"
+#include "gpio_batch.h"
+
+// Static member initialization
+LedcAllocator::Channel LedcAllocator::channels[LEDC_CHANNEL_COUNT];
+LedcAllocator::Timer LedcAllocator::timers[LEDC_CHANNEL_COUNT / 2];
+
+void LedcAllocator::init() {
+  for (uint8_t i = 0; i < LEDC_CHANNEL_COUNT; i++) {
+    channels[i].pin = 255;
+    channels[i].owner = 255;
+  }
+  for (uint8_t i = 0; i < LEDC_CHANNEL_COUNT / 2; i++) {
+    timers[i] = {};
+  }
+}
+
+bool LedcAllocator::isValid(uint32_t frequency, uint8_t resolution) {
+  if (frequency == 0 || resolution < 1 || resolution > LEDC_MAX_RESOLUTION) return false;
+  return (uint64_t)frequency << resolution <= LEDC_SOURCE_CLOCK_HZ;
+}
+
+int8_t LedcAllocator::attach(uint8_t pin, uint32_t frequency, uint8_t resolution, uint8_t owner) {
+  if (!isValid(frequency, resolution)) {
+    Serial.printf("[LEDC] %lu Hz at %d bits is out of range\n", (unsigned long)frequency, resolution);
+    return -1;
+  }
+
+  // Prefer the free half of a pair already running this timing, so
+  // untouched pairs stay available for other frequencies
+  int8_t chosen = -1;
+  for (uint8_t pass = 0; pass < 2 && chosen < 0; pass++) {
+    for (uint8_t ch = 0; ch < LEDC_CHANNEL_COUNT; ch++) {
+      if (channels[ch].pin != 255) continue;
+      const Timer& t = timers[ch / 2];
+      bool shared = t.users > 0 && !t.exclusive && t.frequency == frequency && t.resolution == resolution;
+      if ((pass == 0 && shared) || (pass == 1 && t.users == 0)) {
+        chosen = ch;
+        break;
+      }
+    }
+  }
+
+  if (chosen < 0) {
+    Serial.printf("[LEDC] No channel free for pin %d at %lu Hz/%d bits\n",
+                  pin, (unsigned long)frequency, resolution);
+    return -1;
+  }
+
+  return bind(chosen, pin, frequency, resolution, owner) ? chosen : -1;
+}
+
+int8_t LedcAllocator::attachExclusive(uint8_t pin, uint32_t frequency, uint8_t resolution, uint8_t owner) {
+  if (!isValid(frequency, resolution)) {
+    Serial.printf("[LEDC] %lu Hz at %d bits is out of range\n", (unsigned long)frequency, resolution);
+    return -1;
+  }
+
+  for (uint8_t ch = 0; ch < LEDC_CHANNEL_COUNT; ch += 2) {
+    if (channels[ch].pin != 255 || channels[ch + 1].pin != 255 || timers[ch / 2].users > 0) continue;
+    if (!bind(ch, pin, frequency, resolution, owner)) return -1;
+    timers[ch / 2].exclusive = true;
+    return ch;
+  }
+
+  Serial.printf("[LEDC] No free channel pair for pin %d\n", pin);
+  return -1;
+}
+
+bool LedcAllocator::changeFrequency(uint8_t pin, uint32_t frequency, uint8_t resolution) {
+  if (pin == 255 || !isValid(frequency, resolution)) return false;
+
+  for (uint8_t ch = 0; ch < LEDC_CHANNEL_COUNT; ch++) {
+    if (channels[ch].pin != pin) continue;
+    Timer& t = timers[ch / 2];
+    if (!t.exclusive) return false;
+    if (ledcChangeFrequency(pin, frequency, resolution) == 0) return false;
+    t.frequency = frequency;
+    t.resolution = resolution;
+    return true;
+  }
+  return false;
+}
+
+bool LedcAllocator::bind(int8_t ch, uint8_t pin, uint32_t frequency, uint8_t resolution, uint8_t owner) {
+  if (!ledcAttachChannel(pin, frequency, resolution, ch)) {
+    Serial.printf("[LEDC] Failed to attach pin %d to channel %d\n", pin, ch);
+    return false;
+  }
+
+  GpioBatch::forget(pin);
+  channels[ch].pin = pin;
+  channels[ch].owner = owner;
+  Timer& t = timers[ch / 2];
+  t.frequency = frequency;
+  t.resolution = resolution;
+  t.users++;
+  return true;
+}
+
+void LedcAllocator::detach(uint8_t pin) {
+  if (pin == 255) return;
+
+  for (uint8_t ch = 0; ch < LEDC_CHANNEL_COUNT; ch++) {
+    if (channels[ch].pin != pin) continue;
+    ledcDetach(pin);
+    GpioBatch::forget(pin);
+    channels[ch].pin = 255;
+    channels[ch].owner = 255;
+    Timer& t = timers[ch / 2];
+    if (t.users > 0) t.users--;
+    if (t.users == 0) t.exclusive = false;
+    return;
+  }
+}
+
+uint8_t LedcAllocator::getFreeCount() {
+  uint8_t count = 0;
+  for (uint8_t ch = 0; ch < LEDC_CHANNEL_COUNT; ch++) {
+    if (channels[ch].pin == 255) count++;
+  }
+  return count;
+}
+
+void LedcAllocator::toJson(JsonObject& obj) {
+  obj["free"] = getFreeCount();
+  JsonArray arr = obj.createNestedArray("channels");
+  for (uint8_t ch = 0; ch < LEDC_CHANNEL_COUNT; ch++) {
+    if (channels[ch].pin == 255) continue;
+    JsonObject c = arr.createNestedObject();
+    c["channel"] = ch;
+    c["pin"] = channels[ch].pin;
+    c["slot"] = channels[ch].owner;
+    c["frequency"] = timers[ch / 2].frequency;
+    c["resolution"] = timers[ch / 2].resolution;
+    c["exclusive"] = timers[ch / 2].exclusive;
+  }
+}
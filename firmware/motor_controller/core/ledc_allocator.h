@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+
+// ============================================================================
+// LEDC Allocator - PWM Channel and Timer Ownership
+// ============================================================================
+// The ESP32 has 16 LEDC channels in two groups of 8. Each pair of channels
+// (0-1, 2-3, ...) shares one of its group's timers, so both must run at
+// the same frequency and resolution. Left to itself, ledcAttach() takes the
+// next free channel and reprograms its timer, silently retuning whatever
+// owns the other half of the pair.
+//
+// Every PWM output (DC motor bridges, servos, 28BYJ-48 hold current)
+// attaches through here. A channel is shared-timer only with a partner of
+// the same frequency and resolution; otherwise it goes to a pair with both
+// channels free. Channels are returned when the owning driver releases
+// them or is destroyed, so reconfiguring slots never leaks them.
+//
+// Called with the MotorManager mutex held (slot create/destroy).
+
+class LedcAllocator {
+public:
+  static void init();
+
+  // Attaches `pin` to a channel at the given frequency and resolution.
+  // Returns the channel, or -1 if the pair is impossible (see isValid) or
+  // no compatible channel is free.
+  static int8_t attach(uint8_t pin, uint32_t frequency, uint8_t resolution, uint8_t owner);
+  // For an output that retunes its timer while running (stepper frequency
+  // runs): takes a pair with both channels free and keeps the partner
+  // unused until detach
+  static int8_t attachExclusive(uint8_t pin, uint32_t frequency, uint8_t resolution, uint8_t owner);
+  static void detach(uint8_t pin);
+  // Exclusive channels only; the caller rewrites the duty for the new
+  // resolution
+  static bool changeFrequency(uint8_t pin, uint32_t frequency, uint8_t resolution);
+
+  // frequency * 2^resolution must fit the LEDC source clock
+  static bool isValid(uint32_t frequency, uint8_t resolution);
+  static uint32_t maxDuty(uint8_t resolution) { return (1UL << resolution) - 1; }
+
+  // === Status ===
+  static uint8_t getFreeCount();
+  static void toJson(JsonObject& obj);
+
+private:
+  struct Channel {
+    uint8_t pin;    // 255 = free
+    uint8_t owner;  // Slot
+  };
+
+  struct Timer {
+    uint32_t frequency;
+    uint8_t resolution;
+    uint8_t users;
+    bool exclusive;  // Retuned at run time, never shared
+  };
+
+  static Channel channels[LEDC_CHANNEL_COUNT];
+  static Timer timers[LEDC_CHANNEL_COUNT / 2];
+
+  static bool bind(int8_t ch, uint8_t pin, uint32_t frequency, uint8_t resolution, uint8_t owner);
+};
@@ -0,0 +1,128 @@
+#include "loop_timing.h"
+#include <esp_cpu.h>
+
+// Static member initialization
+uint32_t LoopTiming::periodUs = MOTOR_TASK_INTERVAL_MS * 1000;
+uint32_t LoopTiming::cyclesPerUs = 240;
+int64_t LoopTiming::expectedWakeUs = 0;
+int64_t LoopTiming::wakeUs = 0;
+uint32_t LoopTiming::startCycles = 0;
+volatile bool LoopTiming::resetPending = false;
+volatile uint32_t LoopTiming::ticks = 0;
+volatile uint32_t LoopTiming::overruns = 0;
+volatile uint32_t LoopTiming::missedWakes = 0;
+volatile uint32_t LoopTiming::mutexSkips = 0;
+volatile uint32_t LoopTiming::maxCycles = 0;
+uint32_t LoopTiming::resetAtMs = 0;
+TimingHistogram LoopTiming::wake = {};
+TimingHistogram LoopTiming::exec = {};
+
+void LoopTiming::init(uint32_t period) {
+  periodUs = period;
+  cyclesPerUs = getCpuFrequencyMhz();
+  if (cyclesPerUs == 0) cyclesPerUs = 1;
+  expectedWakeUs = 0;
+  clear();
+}
+
+void LoopTiming::beginTick() {
+  wakeUs = esp_timer_get_time();
+  startCycles = esp_cpu_get_cycle_count();
+
+  if (resetPending) {
+    clear();
+    expectedWakeUs = 0;
+    resetPending = false;
+  }
+
+  // The first tick only anchors the schedule
+  if (expectedWakeUs == 0) {
+    expectedWakeUs = wakeUs;
+    return;
+  }
+
+  expectedWakeUs += periodUs;
+  int64_t late = wakeUs - expectedWakeUs;
+
+  if (late < 0) {
+    // The RTOS tick woke us early relative to esp_timer; re-anchor
+    expectedWakeUs = wakeUs;
+    late = 0;
+  } else if (late >= periodUs) {
+    // vTaskDelayUntil skips ticks that are already past, so follow it
+    missedWakes = missedWakes + 1;
+    expectedWakeUs += (late / periodUs) * periodUs;
+  }
+
+  record(wake, (uint32_t)late);
+}
+
+void LoopTiming::endTick(bool updated) {
+  uint32_t cycles = esp_cpu_get_cycle_count() - startCycles;
+  if (cycles > maxCycles) maxCycles = cycles;
+  record(exec, cycles / cyclesPerUs);
+
+  if (!updated) mutexSkips = mutexSkips + 1;
+
+  if (expectedWakeUs != 0 && esp_timer_get_time() > expectedWakeUs + periodUs) {
+    overruns = overruns + 1;
+  }
+  ticks = ticks + 1;
+}
+
+void LoopTiming::clear() {
+  ticks = 0;
+  overruns = 0;
+  missedWakes = 0;
+  mutexSkips = 0;
+  maxCycles = 0;
+  memset(&wake, 0, sizeof(wake));
+  memset(&exec, 0, sizeof(exec));
+  wake.minUs = UINT32_MAX;
+  exec.minUs = UINT32_MAX;
+  resetAtMs = millis();
+}
+
+void LoopTiming::record(TimingHistogram& h, uint32_t us) {
+  uint8_t bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+  if (bucket >= LOOP_TIMING_BUCKETS) bucket = LOOP_TIMING_BUCKETS - 1;
+  h.buckets[bucket]++;
+  if (us < h.minUs) h.minUs = us;
+  if (us > h.maxUs) h.maxUs = us;
+  h.sumUs += us;
+}
+
+void LoopTiming::histogramToJson(const TimingHistogram& h, JsonObject& obj) {
+  uint32_t count = 0;
+  JsonArray buckets = obj.createNestedArray("histogram");
+  for (uint8_t i = 0; i < LOOP_TIMING_BUCKETS; i++) {
+    buckets.add(h.buckets[i]);
+    count += h.buckets[i];
+  }
+
+  obj["minUs"] = count > 0 ? h.minUs : 0;
+  obj["maxUs"] = h.maxUs;
+  obj["avgUs"] = count > 0 ? (float)h.sumUs / (float)count : 0.0f;
+}
+
+void LoopTiming::toJson(JsonObject& obj) {
+  // Counters are updated by the motor task; a poll may straddle one tick
+  obj["periodUs"] = periodUs;
+  obj["ticks"] = ticks;
+  obj["overruns"] = overruns;
+  obj["missedWakes"] = missedWakes;
+  obj["mutexSkips"] = mutexSkips;
+  obj["maxCycles"] = maxCycles;
+  obj["sinceResetMs"] = millis() - resetAtMs;
+
+  JsonArray floors = obj.createNestedArray("bucketFloorUs");
+  for (uint8_t i = 0; i < LOOP_TIMING_BUCKETS; i++) {
+    floors.add(i == 0 ? 0 : 1UL << (i - 1));
+  }
+
+  JsonObject wakeObj = obj.createNestedObject("wakeLatency");
+  histogramToJson(wake, wakeObj);
+
+  JsonObject execObj = obj.createNestedObject("execution");
+  histogramToJson(exec, execObj);
+}
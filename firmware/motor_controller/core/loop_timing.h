@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+
+// ============================================================================
+// Loop Timing - Motor Task Jitter and Overrun Instrumentation
+// ============================================================================
+// The motor task brackets each tick with beginTick()/endTick(). Wake latency
+// (how late vTaskDelayUntil returned) comes from esp_timer, execution time
+// from the CPU cycle counter. Both feed log2 microsecond histograms.
+//
+// Only the motor task writes the counters. A reset from the web thread is
+// a request that the motor task applies at its next tick.
+
+struct TimingHistogram {
+  uint32_t buckets[LOOP_TIMING_BUCKETS];  // Bucket i >= 2^(i-1) us, bucket 0 < 1us
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t sumUs;
+};
+
+class LoopTiming {
+public:
+  // === Motor Task ===
+  static void init(uint32_t periodUs);
+  static void beginTick();
+  static void endTick(bool updated);  // updated = false when updateAll() skipped
+
+  // === Readers ===
+  static void requestReset() { resetPending = true; }
+  static void toJson(JsonObject& obj);
+
+private:
+  static uint32_t periodUs;
+  static uint32_t cyclesPerUs;
+  static int64_t expectedWakeUs;   // Scheduled wake time of the current tick
+  static int64_t wakeUs;
+  static uint32_t startCycles;
+
+  static volatile bool resetPending;
+  static volatile uint32_t ticks;
+  static volatile uint32_t overruns;     // Tick finished after its deadline
+  static volatile uint32_t missedWakes;  // Woke a full period or more late
+  static volatile uint32_t mutexSkips;
+  static volatile uint32_t maxCycles;
+  static uint32_t resetAtMs;
+  static TimingHistogram wake;
+  static TimingHistogram exec;
+
+  static void clear();
+  static void record(TimingHistogram& h, uint32_t us);
+  static void histogramToJson(const TimingHistogram& h, JsonObject& obj);
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// ============================================================================
+// Motion Planner - Integer Trapezoid Step Intervals
+// ============================================================================
+// Computes the interval before each step of a trapezoidal move. Intervals
+// are fixed-point ticks of the caller's time base (Q24.8), so the same ramp
+// drives the step engine ISR (0.1us ticks), RMT pulse trains and task-polled
+// coil steppers (1us ticks).
+//
+// The first MOTION_TABLE_SIZE intervals of a ramp from rest come from a
+// constant Q16.16 table of sqrt(k+1) - sqrt(k), scaled by the first interval:
+// exact times for the steps where Austin's recurrence is least accurate. Past
+// the table the recurrence cn = cn - 2cn / (4n + 1) takes over with a 32-bit
+// divide. The division remainder is carried to the next step (Bresenham
+// style); at high speeds the per-step change is below one Q8 unit and would
+// otherwise truncate to zero and stall the ramp. Floats and sqrt are only
+// used when the speed or acceleration is set, never per step.
+//
+// Header-only and free of Arduino dependencies so it also builds on the host
+// (see firmware/bench/planner_bench.cpp).
+
+constexpr uint16_t MOTION_TABLE_SIZE = 128;
+
+struct MotionRamp {
+  int32_t n;            // Steps from rest while accelerating, -(steps to stop) while decelerating
+  uint32_t cnQ8;        // Current step interval, ticks << 8
+  uint32_t c0Q8;        // First interval of a ramp from rest
+  uint32_t cminQ8;      // Interval at maximum speed
+  uint32_t rem;         // Recurrence remainder carried between steps
+  float acceleration;   // steps/s^2, setup only
+  float tickHz;         // Time base of the intervals
+};
+
+// sqrt(k+1) - sqrt(k) in Q16.16, built at compile time
+struct MotionUnitRamp {
+  uint32_t q16[MOTION_TABLE_SIZE];
+
+  static constexpr uint64_t isqrt(uint64_t v) {
+    uint64_t r = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > v) bit >>= 2;
+    while (bit != 0) {
+      if (v >= r + bit) {
+        v -= r + bit;
+        r = (r >> 1) + bit;
+      } else {
+        r >>= 1;
+      }
+      bit >>= 2;
+    }
+    return r;
+  }
+
+  constexpr MotionUnitRamp() : q16() {
+    // sqrt(k << 32) is sqrt(k) in Q16.16; round the difference to nearest
+    // by working two fraction bits finer
+    for (uint32_t k = 0; k < MOTION_TABLE_SIZE; k++) {
+      uint64_t hi = isqrt((uint64_t)(k + 1) << 36);
+      uint64_t lo = isqrt((uint64_t)k << 36);
+      q16[k] = (uint32_t)((hi - lo + 2) >> 2);
+    }
+  }
+};
+
+inline constexpr MotionUnitRamp MOTION_UNIT_RAMP{};
+
+class MotionPlanner {
+public:
+  // === Setup (task context, float) ===
+  static void init(MotionRamp& r, float tickHz, float maxSpeed, float acceleration) {
+    r.n = 0;
+    r.cnQ8 = 0;
+    r.rem = 0;
+    r.tickHz = tickHz;
+    setMaxSpeed(r, maxSpeed);
+    setAcceleration(r, acceleration);
+  }
+
+  static void setMaxSpeed(MotionRamp& r, float stepsPerSecond) {
+    r.cminQ8 = intervalQ8(r, stepsPerSecond);
+  }
+
+  // Keeps the current speed of a ramp in progress
+  static void setAcceleration(MotionRamp& r, float stepsPerSecondSquared) {
+    if (stepsPerSecondSquared < 1.0f) stepsPerSecondSquared = 1.0f;
+    r.acceleration = stepsPerSecondSquared;
+    r.c0Q8 = toQ8(sqrtf(2.0f / stepsPerSecondSquared) * r.tickHz);
+    if (r.n > 0) r.n = stepsToStop(r);
+  }
+
+  static uint32_t intervalQ8(const MotionRamp& r, float stepsPerSecond) {
+    if (stepsPerSecond <= 0.0f) return UINT32_MAX;
+    return toQ8(r.tickHz / stepsPerSecond);
+  }
+
+  // Steps needed to stop from the current interval, v^2 / 2a, which is also
+  // the ramp index n that produces that speed
+  static int32_t stepsToStop(const MotionRamp& r) {
+    if (r.cnQ8 == 0) return 0;
+    float v = r.tickHz * 256.0f / (float)r.cnQ8;
+    return (int32_t)((v * v) / (2.0f * r.acceleration));
+  }
+
+  static float speed(const MotionRamp& r) {
+    if (r.cnQ8 == 0) return 0.0f;
+    return r.tickHz * 256.0f / (float)r.cnQ8;
+  }
+
+  // === Per Step (ISR safe, integer) ===
+  // Call after each step, and once with n == 0 to start a move. Updates
+  // cnQ8 to the interval before the next step. Returns false when the move
+  // is complete. On a start from rest, startDir is set to the direction of
+  // the first step; otherwise it is left alone.
+  static bool IRAM_ATTR next(MotionRamp& r, int32_t distanceTo, int8_t direction, int8_t& startDir) {
+    int32_t stepsToStop = r.n >= 0 ? r.n : -r.n;
+
+    if (distanceTo == 0 && stepsToStop <= 1) {
+      // At target and nearly stopped
+      r.n = 0;
+      return false;
+    }
+
+    if (distanceTo > 0) {
+      if (r.n > 0) {
+        // Accelerating or cruising: decelerate if we would overshoot or
+        // are heading the wrong way
+        if (stepsToStop >= distanceTo || direction < 0) {
+          r.n = -stepsToStop;
+          r.rem = 0;
+        }
+      } else if (r.n < 0) {
+        // Decelerating: accelerate again if there is room and direction is right
+        if (stepsToStop < distanceTo && direction > 0) {
+          r.n = -r.n;
+          r.rem = 0;
+        }
+      }
+    } else if (distanceTo < 0) {
+      if (r.n > 0) {
+        if (stepsToStop >= -distanceTo || direction > 0) {
+          r.n = -stepsToStop;
+          r.rem = 0;
+        }
+      } else if (r.n < 0) {
+        if (stepsToStop < -distanceTo && direction < 0) {
+          r.n = -r.n;
+          r.rem = 0;
+        }
+      }
+    }
+
+    if (r.n == 0) {
+      // First step from standstill
+      r.cnQ8 = r.c0Q8 > r.cminQ8 ? r.c0Q8 : r.cminQ8;
+      r.rem = 0;
+      startDir = distanceTo > 0 ? 1 : -1;
+    } else if (r.n > 0) {
+      if (r.cnQ8 <= r.cminQ8) {
+        // Cruising: hold n at the ramp index of max speed so it keeps
+        // meaning "steps to stop"
+        r.cnQ8 = r.cminQ8;
+        return true;
+      }
+      if (r.n < MOTION_TABLE_SIZE) {
+        r.cnQ8 = scaleQ16(r.c0Q8, MOTION_UNIT_RAMP.q16[r.n]);
+      } else {
+        uint32_t shrink = twiceOver(r.cnQ8, 4 * (uint32_t)r.n + 1, r.rem);
+        r.cnQ8 = shrink < r.cnQ8 ? r.cnQ8 - shrink : 0;
+      }
+      if (r.cnQ8 < r.cminQ8) r.cnQ8 = r.cminQ8;
+    } else {
+      // Decelerating: mirror of the acceleration ramp, stepsToStop >= 1
+      if (stepsToStop <= MOTION_TABLE_SIZE) {
+        r.cnQ8 = scaleQ16(r.c0Q8, MOTION_UNIT_RAMP.q16[stepsToStop - 1]);
+      } else {
+        uint32_t grow = twiceOver(r.cnQ8, 4 * (uint32_t)stepsToStop - 1, r.rem);
+        r.cnQ8 = r.cnQ8 > UINT32_MAX - grow ? UINT32_MAX : r.cnQ8 + grow;
+      }
+      if (r.cnQ8 < r.cminQ8) r.cnQ8 = r.cminQ8;
+    }
+
+    r.n++;
+    return true;
+  }
+
+private:
+  // Single precision so setup stays cheap inside the engine spinlock
+  static uint32_t toQ8(float ticks) {
+    float q8 = ticks * 256.0f;
+    return q8 >= 4294967040.0f ? UINT32_MAX : (uint32_t)q8;
+  }
+
+  static inline uint32_t IRAM_ATTR scaleQ16(uint32_t valueQ8, uint32_t fractionQ16) {
+    return (uint32_t)(((uint64_t)valueQ8 * fractionQ16) >> 16);
+  }
+
+  // (2v + rem) / d, keeping the new remainder. 32-bit unless v is huge.
+  static inline uint32_t IRAM_ATTR twiceOver(uint32_t v, uint32_t d, uint32_t& rem) {
+    if (rem >= d) rem = d - 1;
+    if (v < 0x40000000UL) {
+      uint32_t num = (v << 1) + rem;
+      uint32_t q = num / d;
+      rem = num - q * d;
+      return q;
+    }
+    uint64_t num = ((uint64_t)v << 1) + rem;
+    uint64_t q = num / d;
+    rem = (uint32_t)(num - q * d);
+    return q > UINT32_MAX ? UINT32_MAX : (uint32_t)q;
+  }
+};
@@ -1,20 +1,36 @@
 #include "motor_manager.h"
+#include "encoder_manager.h"
+#include "safety_manager.h"
+#include "axis_follower.h"
+#include "ledc_allocator.h"
+#include "gpio_batch.h"
+#include "gcode_interpreter.h"
 #include <LittleFS.h>
 #include <Preferences.h>
 
 // Static member initialization
+MotorSlot MotorManager::slots[MAX_MOTORS];
 MotorBase* MotorManager::motors[MAX_MOTORS] = {nullptr};
 MotorType MotorManager::motorTypes[MAX_MOTORS] = {MotorType::NONE};
 SlotPins MotorManager::slotPins[MAX_MOTORS];
+SlotOptions MotorManager::slotOptions[MAX_MOTORS];
 SemaphoreHandle_t MotorManager::mutex = nullptr;
+MotorStatusSlot MotorManager::status[MAX_MOTORS];
 
 void MotorManager::init() {
   // Create mutex for thread safety
   mutex = xSemaphoreCreateMutex();
 
+  // Hardware step generation and the PWM channel map must be up before
+  // slots are restored
+  StepEngine::init();
+  GpioBatch::init();
+  LedcAllocator::init();
+
   // Initialize slot pins to defaults
   for (uint8_t i = 0; i < MAX_MOTORS; i++) {
     slotPins[i] = getDefaultSlotPins(i);
+    slotOptions[i] = SlotOptions();
     motors[i] = nullptr;
     motorTypes[i] = MotorType::NONE;
   }
@@ -25,10 +41,12 @@ void MotorManager::init() {
   Serial.println("[MOTOR] Motor Manager initialized");
 }
 
-bool MotorManager::configureSlot(uint8_t slot, MotorType type, const JsonObject& config) {
+bool MotorManager::configureSlot(uint8_t slot, MotorType type, const JsonObject& config,
+                                 const JsonObject& options) {
   if (slot >= MAX_MOTORS) return false;
 
   SlotPins pins = slotPins[slot];
+  SlotOptions opts = slotOptions[slot];
 
   // Parse pin configuration from JSON if provided
   if (config.containsKey("pinA")) pins.pinA = config["pinA"];
@@ -40,6 +58,9 @@ bool MotorManager::configureSlot(uint8_t slot, MotorType type, const JsonObject&
   if (config.containsKey("stepPin")) pins.pinA = config["stepPin"];
   if (config.containsKey("dirPin")) pins.pinB = config["dirPin"];
   if (config.containsKey("enablePin")) pins.pinEn = config["enablePin"];
+  if (config.containsKey("ms1Pin")) pins.ms1 = config["ms1Pin"];
+  if (config.containsKey("ms2Pin")) pins.ms2 = config["ms2Pin"];
+  if (config.containsKey("ms3Pin")) pins.ms3 = config["ms3Pin"];
 
   // For servo
   if (config.containsKey("pin")) pins.pinA = config["pin"];
@@ -50,11 +71,76 @@ bool MotorManager::configureSlot(uint8_t slot, MotorType type, const JsonObject&
   if (config.containsKey("in3")) pins.pinEn = config["in3"];
   if (config.containsKey("in4")) pins.pinEx = config["in4"];
 
-  return configureSlot(slot, type, pins);
+  // Step pulse output for step/dir drivers: "timer" or "rmt"
+  if (options.containsKey("output")) {
+    const char* output = options["output"] | "timer";
+    opts.stepOutput = strcmp(output, "rmt") == 0 ? 1 : 0;
+  }
+  // Constant speed runs: "step" (the output above) or "ledc"
+  if (options.containsKey("runOutput")) {
+    const char* runOutput = options["runOutput"] | "step";
+    opts.runOutput = strcmp(runOutput, "ledc") == 0 ? 1 : 0;
+  }
+
+  // Bridge PWM for DC slots; the speed range follows the resolution
+  if (options.containsKey("pwmFrequency")) opts.pwmFrequency = options["pwmFrequency"];
+  if (options.containsKey("pwmResolution")) opts.pwmResolution = options["pwmResolution"];
+  if (!LedcAllocator::isValid(opts.pwmFrequency, opts.pwmResolution)) {
+    Serial.printf("[MOTOR] Slot %d PWM %lu Hz at %d bits is out of range\n",
+                  slot, (unsigned long)opts.pwmFrequency, opts.pwmResolution);
+    return false;
+  }
+
+  // Coil sequence and idle current for 28BYJ-48 slots
+  if (options.containsKey("stepMode")) {
+    const char* mode = options["stepMode"] | "half";
+    if (strcmp(mode, "half") == 0) opts.coilMode = static_cast<uint8_t>(CoilStepMode::HALF);
+    else if (strcmp(mode, "full") == 0) opts.coilMode = static_cast<uint8_t>(CoilStepMode::FULL);
+    else if (strcmp(mode, "wave") == 0) opts.coilMode = static_cast<uint8_t>(CoilStepMode::WAVE);
+    else {
+      Serial.printf("[MOTOR] Slot %d unknown step mode '%s'\n", slot, mode);
+      return false;
+    }
+  }
+  if (options.containsKey("idleReleaseMs")) opts.idleReleaseMs = options["idleReleaseMs"];
+  if (options.containsKey("holdDuty")) {
+    uint16_t holdDuty = options["holdDuty"];
+    if (holdDuty > 100) {
+      Serial.printf("[MOTOR] Slot %d hold duty %d%% is out of range\n", slot, holdDuty);
+      return false;
+    }
+    opts.holdDuty = holdDuty;
+  }
+
+  // Microstepping for step/dir slots, optionally switched with the speed
+  if (options.containsKey("microsteps")) {
+    uint8_t microsteps = options["microsteps"];
+    if (microsteps == 0 || microsteps > 32 || (microsteps & (microsteps - 1)) != 0) {
+      Serial.printf("[MOTOR] Slot %d microsteps must be 1, 2, 4, 8, 16 or 32\n", slot);
+      return false;
+    }
+    opts.microsteps = microsteps;
+  }
+  if (options.containsKey("microstepSwitchRate")) {
+    uint32_t rate = options["microstepSwitchRate"];
+    if (rate > STEP_ENGINE_MAX_RATE) {
+      Serial.printf("[MOTOR] Slot %d microstep switch rate %lu is out of range\n",
+                    slot, (unsigned long)rate);
+      return false;
+    }
+    opts.microstepSwitchRate = rate;
+  }
+
+  return configureSlot(slot, type, pins, opts);
 }
 
 bool MotorManager::configureSlot(uint8_t slot, MotorType type, const SlotPins& pins) {
   if (slot >= MAX_MOTORS) return false;
+  return configureSlot(slot, type, pins, slotOptions[slot]);
+}
+
+bool MotorManager::configureSlot(uint8_t slot, MotorType type, const SlotPins& pins, const SlotOptions& options) {
+  if (slot >= MAX_MOTORS) return false;
 
   xSemaphoreTake(mutex, portMAX_DELAY);
 
@@ -63,15 +149,18 @@ bool MotorManager::configureSlot(uint8_t slot, MotorType type, const SlotPins& p
 
   if (type == MotorType::NONE) {
     slotPins[slot] = pins;
+    slotOptions[slot] = options;
     motorTypes[slot] = MotorType::NONE;
+    publishStatus(slot);
     xSemaphoreGive(mutex);
     Serial.printf("[MOTOR] Slot %d cleared\n", slot);
     return true;
   }
 
   // Create new motor
-  MotorBase* motor = createMotor(slot, type, pins);
+  MotorBase* motor = createMotor(slot, type, pins, options);
   if (motor == nullptr) {
+    publishStatus(slot);
     xSemaphoreGive(mutex);
     Serial.printf("[MOTOR] Failed to create motor for slot %d\n", slot);
     return false;
@@ -80,9 +169,20 @@ bool MotorManager::configureSlot(uint8_t slot, MotorType type, const SlotPins& p
   motors[slot] = motor;
   motorTypes[slot] = type;
   slotPins[slot] = pins;
+  slotOptions[slot] = options;
 
-  // Initialize the motor
+  // Initialize the motor; a driver that could not claim its outputs
+  // (e.g. no PWM channel left) stays disabled
   motor->init();
+  if (!motor->isEnabled()) {
+    destroyMotor(slot);
+    motorTypes[slot] = MotorType::NONE;
+    publishStatus(slot);
+    xSemaphoreGive(mutex);
+    Serial.printf("[MOTOR] Slot %d failed to initialize\n", slot);
+    return false;
+  }
+  publishStatus(slot);
 
   xSemaphoreGive(mutex);
 
@@ -96,6 +196,7 @@ bool MotorManager::removeMotor(uint8_t slot) {
   xSemaphoreTake(mutex, portMAX_DELAY);
   destroyMotor(slot);
   motorTypes[slot] = MotorType::NONE;
+  publishStatus(slot);
   xSemaphoreGive(mutex);
 
   return true;
@@ -118,6 +219,8 @@ bool MotorManager::isSlotConfigured(uint8_t slot) {
 
 void MotorManager::stopAll() {
   xSemaphoreTake(mutex, portMAX_DELAY);
+  AxisFollower::disengageAll();
+  WaveformGenerator::stopAll();
   for (uint8_t i = 0; i < MAX_MOTORS; i++) {
     if (motors[i] != nullptr) {
       motors[i]->stop();
@@ -128,72 +231,450 @@ void MotorManager::stopAll() {
 }
 
 void MotorManager::emergencyStopAll() {
-  // Don't wait for mutex in emergency - just stop
+  // Don't wait for mutex in emergency - just stop. Pin and duty writes
+  // from this task bypass the motor task's staging (see GpioBatch).
+  AxisFollower::disengageAll();
+  WaveformGenerator::stopAll();
   for (uint8_t i = 0; i < MAX_MOTORS; i++) {
-    if (motors[i] != nullptr) {
-      motors[i]->emergencyStop();
-    }
+    std::visit([](auto& motor) {
+      using Driver = std::decay_t<decltype(motor)>;
+      if constexpr (std::is_same_v<Driver, StepperNema17>) {
+        motor.requestEmergencyStop();  // RMT driver calls stay with the mutex holder
+      } else if constexpr (!std::is_same_v<Driver, std::monostate>) {
+        motor.emergencyStop();
+      }
+    }, slots[i]);
   }
   Serial.println("[MOTOR] EMERGENCY STOP - All motors");
 }
 
-void MotorManager::updateAll() {
+void MotorManager::applyPendingHalts() {
+  if (xSemaphoreTake(mutex, pdMS_TO_TICKS(1)) != pdTRUE) return;
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    if (StepperNema17* stepper = std::get_if<StepperNema17>(&slots[i])) stepper->applyPendingHalt();
+  }
+  xSemaphoreGive(mutex);
+}
+
+int8_t MotorManager::moveAxes(const uint8_t* slotList, const int32_t* targets, uint8_t count,
+                              float maxRate) {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  int8_t group = startGroupLocked(slotList, targets, count, maxRate);
+  xSemaphoreGive(mutex);
+
+  if (group >= 0) {
+    Serial.printf("[MOTOR] Axis group %d started (%d axes)\n", group, count);
+  }
+  return group;
+}
+
+int8_t MotorManager::startGroupLocked(const uint8_t* slotList, const int32_t* targets, uint8_t count,
+                                      float maxRate) {
+  if (count == 0 || count > MAX_MOTORS) return -1;
+
+  int8_t channels[MAX_MOTORS];
+  int32_t clamped[MAX_MOTORS];
+  int8_t group = -1;
+  bool valid = true;
+
+  // Only step engine channels can share a ramp
+  for (uint8_t i = 0; i < count && valid; i++) {
+    uint8_t slot = slotList[i];
+    if (slot >= MAX_MOTORS || motors[slot] == nullptr ||
+        (motorTypes[slot] != MotorType::STEPPER_A4988 && motorTypes[slot] != MotorType::STEPPER_DRV8825)) {
+      valid = false;
+      break;
+    }
+
+    StepperNema17* stepper = static_cast<StepperNema17*>(motors[slot]);
+    channels[i] = stepper->getStepChannel();
+    clamped[i] = stepper->clampToLimits(targets[i]);
+    valid = channels[i] >= 0;
+  }
+
+  if (valid) {
+    group = StepEngine::moveGroup(channels, clamped, count, maxRate);
+  }
+  if (group >= 0) {
+    for (uint8_t i = 0; i < count; i++) releaseSetpoint(slotList[i]);
+  }
+  return group;
+}
+
+bool MotorManager::updateAll() {
   // Called from motor task - should be fast
   if (xSemaphoreTake(mutex, pdMS_TO_TICKS(1)) == pdTRUE) {
+    // Pin writes from this tick go out together at the commit below
+    GpioBatch::begin();
+
+    // Apply queued commands before stepping the motors
+    CommandQueue::drain(executeCommand);
+
+    // Visit the concrete driver so update() is a direct call
     for (uint8_t i = 0; i < MAX_MOTORS; i++) {
-      if (motors[i] != nullptr) {
-        motors[i]->update();
-      }
+      std::visit([i](auto& motor) {
+        using Driver = std::decay_t<decltype(motor)>;
+        if constexpr (!std::is_same_v<Driver, std::monostate>) {
+          if constexpr (std::is_same_v<Driver, DCMotor>) {
+            feedEncoder(i, motor);
+          }
+          if constexpr (!std::is_same_v<Driver, ServoMotor>) {
+            followMaster(i, motor);
+          }
+          driveWaveform(i, motor);
+          motor.update();
+          if constexpr (std::is_same_v<Driver, StepperNema17> || std::is_same_v<Driver, Stepper28BYJ48>) {
+            checkStepLoss(i, motor);
+          }
+        }
+      }, slots[i]);
+    }
+    GpioBatch::commit();
+
+    // Publish after the motors have moved so readers see this tick
+    for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+      publishStatus(i);
     }
+
+    // Next G-code block, under this tick's mutex so a group start never
+    // waits for it
+    GcodeInterpreter::service();
     xSemaphoreGive(mutex);
+    return true;
   }
+  return false;
 }
 
-bool MotorManager::sendCommand(uint8_t slot, CommandType cmd, int32_t value, uint16_t duration) {
-  if (slot >= MAX_MOTORS || motors[slot] == nullptr) return false;
+// Feeds the linked encoder to a DC slot's closed loop; mutex held
+void MotorManager::feedEncoder(uint8_t slot, DCMotor& motor) {
+  int8_t encoder = EncoderManager::getLinkedEncoder(slot);
+  if (encoder < 0) {
+    if (motor.isClosedLoop()) {
+      releaseSetpoint(slot);
+      motor.stop();
+      Serial.printf("[MOTOR] Slot %d lost its encoder, closed loop stopped\n", slot);
+    }
+    return;
+  }
+  motor.setEncoderFeedback(EncoderManager::getCount64(encoder), EncoderManager::getVelocity(encoder),
+                           EncoderManager::getPulsesPerRevolution(encoder));
+}
+
+// Compares a stepper with its linked encoder; mutex held. A trip stops the
+// slot within the tick it is detected.
+template <typename Stepper>
+void MotorManager::checkStepLoss(uint8_t slot, Stepper& motor) {
+  if (!StepMonitor::isEnabled(slot)) return;
+
+  int8_t encoder = EncoderManager::getLinkedEncoder(slot);
+  if (encoder < 0) {
+    StepMonitor::requestAlign(slot);  // Realign once an encoder is linked again
+    return;
+  }
+
+  int64_t count = EncoderManager::getCount64(encoder);
+  int32_t stepPosition = motor.getPosition();
+  int32_t inFlight = 0;
+  if constexpr (std::is_same_v<Stepper, StepperNema17>) inFlight = motor.stepsInFlight();
+  int32_t encoderSteps;
+  if (!StepMonitor::check(slot, stepPosition, count, encoderSteps, inFlight)) return;
+
+  motor.emergencyStop();
+  releaseSetpoint(slot);
+
+  char reason[48];
+  snprintf(reason, sizeof(reason), "step loss, %ld steps off", (long)(stepPosition - encoderSteps));
+  SafetyManager::raiseFault(slot, reason);
+
+  if (StepMonitor::resyncEnabled(slot)) {
+    motor.setCurrentPosition(encoderSteps);
+    StepMonitor::align(slot, encoderSteps, count);
+    Serial.printf("[MOTOR] Slot %d position resynced to %ld from the encoder\n", slot, (long)encoderSteps);
+  }
+}
+
+// Moves a following slot to this tick's target; mutex held
+template <typename Driver>
+void MotorManager::followMaster(uint8_t slot, Driver& motor) {
+  int64_t target;
+  if (!AxisFollower::target(slot, target)) return;
+
+  if constexpr (std::is_same_v<Driver, DCMotor>) {
+    motor.moveTo(target);
+  } else {
+    motor.moveTo((int32_t)constrain(target, (int64_t)INT32_MIN, (int64_t)INT32_MAX));
+  }
+}
+
+// Position a slot starts following from; false if it cannot follow the
+// encoder. Mutex held.
+bool MotorManager::followOrigin(uint8_t slot, uint8_t encoder, int64_t& position) {
+  if (StepperNema17* stepper = std::get_if<StepperNema17>(&slots[slot])) {
+    position = stepper->getTargetPosition();
+    return true;
+  }
+  if (Stepper28BYJ48* stepper = std::get_if<Stepper28BYJ48>(&slots[slot])) {
+    position = stepper->getTargetPosition();
+    return true;
+  }
+  if (DCMotor* dc = std::get_if<DCMotor>(&slots[slot])) {
+    // A DC slave needs its own encoder, and must not follow it
+    int8_t own = EncoderManager::getLinkedEncoder(slot);
+    if (own >= 0 && own != encoder) {
+      position = dc->getEncoderPosition();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MotorManager::engageGear(uint8_t slot, uint8_t encoder, int32_t numerator, int32_t denominator) {
+  if (slot >= MAX_MOTORS || encoder >= MAX_ENCODERS) return false;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  int64_t position;
+  bool ok = followOrigin(slot, encoder, position) &&
+            AxisFollower::engageGear(slot, encoder, numerator, denominator, position);
+  if (ok) WaveformGenerator::stop(slot);
+  xSemaphoreGive(mutex);
+
+  return ok;
+}
+
+bool MotorManager::engageCam(uint8_t slot, uint8_t encoder, const CamTable& table, const char* name) {
+  if (slot >= MAX_MOTORS || encoder >= MAX_ENCODERS) return false;
 
   xSemaphoreTake(mutex, portMAX_DELAY);
-  MotorBase* motor = motors[slot];
-  MotorType type = motorTypes[slot];
+  int64_t position;
+  bool ok = followOrigin(slot, encoder, position) &&
+            AxisFollower::engageCam(slot, encoder, table, name, position);
+  if (ok) WaveformGenerator::stop(slot);
+  xSemaphoreGive(mutex);
+
+  return ok;
+}
+
+void MotorManager::disengageFollow(uint8_t slot) {
+  if (slot >= MAX_MOTORS) return;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  AxisFollower::disengage(slot);
+  xSemaphoreGive(mutex);
+}
+
+// Moves a slot to this tick's waveform setpoint; mutex held
+template <typename Driver>
+void MotorManager::driveWaveform(uint8_t slot, Driver& motor) {
+  int32_t setpoint;
+  if (!WaveformGenerator::sample(slot, setpoint)) return;
+
+  if constexpr (std::is_same_v<Driver, ServoMotor>) {
+    motor.setAngleCentidegrees(setpoint);
+  } else {
+    motor.moveTo(setpoint);
+  }
+}
+
+bool MotorManager::startWaveform(uint8_t slot, const WaveformConfig& config) {
+  if (slot >= MAX_MOTORS) return false;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  bool ok = false;
+  if (ServoMotor* servo = std::get_if<ServoMotor>(&slots[slot])) {
+    ok = WaveformGenerator::start(slot, config, 100, servo->getTargetAngle() * 100);  // Centidegrees
+  } else if (StepperNema17* stepper = std::get_if<StepperNema17>(&slots[slot])) {
+    ok = WaveformGenerator::start(slot, config, 1, stepper->getTargetPosition());
+  } else if (Stepper28BYJ48* stepper = std::get_if<Stepper28BYJ48>(&slots[slot])) {
+    ok = WaveformGenerator::start(slot, config, 1, stepper->getTargetPosition());
+  } else if (DCMotor* dc = std::get_if<DCMotor>(&slots[slot])) {
+    if (isDcWithEncoder(slot)) {
+      ok = WaveformGenerator::start(slot, config, 1,
+                                     (int32_t)constrain(dc->getEncoderPosition(), (int64_t)INT32_MIN, (int64_t)INT32_MAX));
+    }
+  }
+  if (ok) AxisFollower::disengage(slot);
+  xSemaphoreGive(mutex);
+
+  return ok;
+}
+
+void MotorManager::stopWaveform(uint8_t slot) {
+  if (slot >= MAX_MOTORS) return;
 
-  switch (cmd) {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  WaveformGenerator::stop(slot);
+  xSemaphoreGive(mutex);
+}
+
+// Mutex held
+void MotorManager::releaseSetpoint(uint8_t slot) {
+  AxisFollower::disengage(slot);
+  WaveformGenerator::stop(slot);
+}
+
+bool MotorManager::configureStepMonitor(uint8_t slot, const StepMonitorConfig& config) {
+  if (slot >= MAX_MOTORS) return false;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  bool stepper = std::holds_alternative<StepperNema17>(slots[slot]) ||
+                 std::holds_alternative<Stepper28BYJ48>(slots[slot]);
+  bool ok = stepper && StepMonitor::configure(slot, config);
+  xSemaphoreGive(mutex);
+
+  return ok;
+}
+
+bool MotorManager::setPidGains(uint8_t slot, float kp, float ki, float kd, float kff) {
+  if (slot >= MAX_MOTORS) return false;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  DCMotor* motor = std::get_if<DCMotor>(&slots[slot]);
+  if (motor != nullptr) {
+    motor->setPidGains(kp, ki, kd, kff);
+  }
+  xSemaphoreGive(mutex);
+
+  if (motor == nullptr) return false;
+  Serial.printf("[MOTOR] Slot %d PID gains kp=%.4f ki=%.4f kd=%.4f kff=%.4f\n", slot, kp, ki, kd, kff);
+  return true;
+}
+
+bool MotorManager::setPositionLoop(uint8_t slot, float kpPos, float maxSpeed, float acceleration) {
+  if (slot >= MAX_MOTORS) return false;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  DCMotor* motor = std::get_if<DCMotor>(&slots[slot]);
+  if (motor != nullptr) {
+    motor->setPositionLoop(kpPos, maxSpeed, acceleration);
+  }
+  xSemaphoreGive(mutex);
+
+  return motor != nullptr;
+}
+
+bool MotorManager::setRampLimits(uint8_t slot, float acceleration, float deceleration, float jerk) {
+  if (slot >= MAX_MOTORS) return false;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  DCMotor* motor = std::get_if<DCMotor>(&slots[slot]);
+  if (motor != nullptr) {
+    motor->setRampLimits(acceleration, deceleration, jerk);
+  }
+  xSemaphoreGive(mutex);
+
+  if (motor == nullptr) return false;
+  Serial.printf("[MOTOR] Slot %d ramp accel=%.1f decel=%.1f jerk=%.1f duty/s\n", slot, acceleration, deceleration, jerk);
+  return true;
+}
+
+bool MotorManager::setRpmRampLimits(uint8_t slot, float acceleration, float deceleration, float jerk) {
+  if (slot >= MAX_MOTORS) return false;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  DCMotor* motor = std::get_if<DCMotor>(&slots[slot]);
+  if (motor != nullptr) {
+    motor->setRpmRampLimits(acceleration, deceleration, jerk);
+  }
+  xSemaphoreGive(mutex);
+
+  return motor != nullptr;
+}
+
+// Closed-loop DC commands need a linked encoder; logs when they are ignored
+bool MotorManager::isDcWithEncoder(uint8_t slot) {
+  if (motorTypes[slot] != MotorType::DC_L298N && motorTypes[slot] != MotorType::DC_L9110S) return false;
+  if (EncoderManager::getLinkedEncoder(slot) >= 0) return true;
+
+  Serial.printf("[MOTOR] Slot %d has no linked encoder, closed-loop command ignored\n", slot);
+  return false;
+}
+
+bool MotorManager::sendCommand(uint8_t slot, CommandType cmd, int32_t value, uint16_t duration,
+                               CommandSource source) {
+  if (slot >= MAX_MOTORS || motors[slot] == nullptr) return false;
+
+  MotorCommand command;
+  command.slot = slot;
+  command.command = cmd;
+  command.value = value;
+  command.duration = duration;
+  return CommandQueue::enqueue(source, command);
+}
+
+// Motor task only, with the mutex held
+void MotorManager::executeCommand(const MotorCommand& cmd) {
+  if (cmd.slot >= MAX_MOTORS || motors[cmd.slot] == nullptr) return;
+
+  // An explicit command takes the slot back from its master or waveform
+  if (cmd.command != CommandType::ENABLE) releaseSetpoint(cmd.slot);
+
+  MotorBase* motor = motors[cmd.slot];
+  MotorType type = motorTypes[cmd.slot];
+
+  switch (cmd.command) {
     case CommandType::STOP:
       motor->stop();
       break;
 
     case CommandType::SET_SPEED:
       if (type == MotorType::DC_L298N || type == MotorType::DC_L9110S) {
-        static_cast<DCMotor*>(motor)->setSpeed(value);
+        static_cast<DCMotor*>(motor)->setSpeed(cmd.value);
       } else if (type == MotorType::STEPPER_A4988 || type == MotorType::STEPPER_DRV8825) {
-        static_cast<StepperNema17*>(motor)->setSpeed(value);
+        static_cast<StepperNema17*>(motor)->setSpeed(cmd.value);
       } else if (type == MotorType::STEPPER_ULN2003) {
-        static_cast<Stepper28BYJ48*>(motor)->setSpeedSteps(value);
+        static_cast<Stepper28BYJ48*>(motor)->setSpeedSteps(cmd.value);
+      }
+      break;
+
+    case CommandType::SET_RPM:
+      if (isDcWithEncoder(cmd.slot)) {
+        static_cast<DCMotor*>(motor)->setTargetRpm(cmd.value);
+      }
+      break;
+
+    case CommandType::RUN:
+      if (type == MotorType::STEPPER_A4988 || type == MotorType::STEPPER_DRV8825) {
+        static_cast<StepperNema17*>(motor)->runSpeed(cmd.value);
       }
       break;
 
     case CommandType::SET_POSITION:
       if (type == MotorType::STEPPER_A4988 || type == MotorType::STEPPER_DRV8825) {
-        static_cast<StepperNema17*>(motor)->moveTo(value);
+        static_cast<StepperNema17*>(motor)->moveTo(cmd.value);
       } else if (type == MotorType::STEPPER_ULN2003) {
-        static_cast<Stepper28BYJ48*>(motor)->moveTo(value);
+        static_cast<Stepper28BYJ48*>(motor)->moveTo(cmd.value);
+      } else if (isDcWithEncoder(cmd.slot)) {
+        static_cast<DCMotor*>(motor)->moveTo(cmd.value);
       }
       break;
 
     case CommandType::SET_ANGLE:
       if (type == MotorType::SERVO) {
-        if (duration > 0) {
-          static_cast<ServoMotor*>(motor)->setAngleSmooth(value, duration);
+        if (cmd.duration > 0) {
+          static_cast<ServoMotor*>(motor)->setAngleSmooth(cmd.value, cmd.duration);
         } else {
-          static_cast<ServoMotor*>(motor)->setAngle(value);
+          static_cast<ServoMotor*>(motor)->setAngle(cmd.value);
         }
       }
       break;
 
+    case CommandType::QUEUE_POSITION:
+      if (type == MotorType::STEPPER_A4988 || type == MotorType::STEPPER_DRV8825) {
+        if (!static_cast<StepperNema17*>(motor)->queueMove(cmd.value)) {
+          Serial.printf("[MOTOR] Slot %d look-ahead full, move dropped\n", cmd.slot);
+        }
+      } else if (type == MotorType::STEPPER_ULN2003) {
+        static_cast<Stepper28BYJ48*>(motor)->moveTo(cmd.value);
+      }
+      break;
+
     case CommandType::MOVE_RELATIVE:
       if (type == MotorType::STEPPER_A4988 || type == MotorType::STEPPER_DRV8825) {
-        static_cast<StepperNema17*>(motor)->moveRelative(value);
+        static_cast<StepperNema17*>(motor)->moveRelative(cmd.value);
       } else if (type == MotorType::STEPPER_ULN2003) {
-        static_cast<Stepper28BYJ48*>(motor)->moveRelative(value);
+        static_cast<Stepper28BYJ48*>(motor)->moveRelative(cmd.value);
+      } else if (isDcWithEncoder(cmd.slot)) {
+        static_cast<DCMotor*>(motor)->moveRelative(cmd.value);
       }
       break;
 
@@ -232,16 +713,14 @@ bool MotorManager::sendCommand(uint8_t slot, CommandType cmd, int32_t value, uin
         static_cast<Stepper28BYJ48*>(motor)->moveTo(0);
       } else if (type == MotorType::SERVO) {
         static_cast<ServoMotor*>(motor)->setAngle(90);
+      } else if (isDcWithEncoder(cmd.slot)) {
+        static_cast<DCMotor*>(motor)->moveTo(0);
       }
       break;
 
     default:
-      xSemaphoreGive(mutex);
-      return false;
+      break;
   }
-
-  xSemaphoreGive(mutex);
-  return true;
 }
 
 void MotorManager::toJson(JsonDocument& doc) {
@@ -253,6 +732,9 @@ void MotorManager::toJson(JsonDocument& doc) {
   }
 
   doc["configuredCount"] = getConfiguredCount();
+
+  JsonObject queue = doc.createNestedObject("commandQueue");
+  CommandQueue::toJson(queue);
 }
 
 void MotorManager::slotToJson(uint8_t slot, JsonObject& obj) {
@@ -269,13 +751,55 @@ void MotorManager::slotToJson(uint8_t slot, JsonObject& obj) {
   pins["pinB"] = slotPins[slot].pinB;
   pins["pinEn"] = slotPins[slot].pinEn;
   pins["pinEx"] = slotPins[slot].pinEx;
-
-  // Add motor-specific data if configured
-  if (motors[slot] != nullptr) {
-    motors[slot]->toJson(obj);
+  pins["ms1Pin"] = slotPins[slot].ms1;
+  pins["ms2Pin"] = slotPins[slot].ms2;
+  pins["ms3Pin"] = slotPins[slot].ms3;
+
+  JsonObject options = obj.createNestedObject("options");
+  options["output"] = slotOptions[slot].stepOutput == 1 ? "rmt" : "timer";
+  options["pwmFrequency"] = slotOptions[slot].pwmFrequency;
+  options["pwmResolution"] = slotOptions[slot].pwmResolution;
+  options["stepMode"] = slotOptions[slot].coilMode == static_cast<uint8_t>(CoilStepMode::FULL) ? "full" :
+                        slotOptions[slot].coilMode == static_cast<uint8_t>(CoilStepMode::WAVE) ? "wave" : "half";
+  options["idleReleaseMs"] = slotOptions[slot].idleReleaseMs;
+  options["holdDuty"] = slotOptions[slot].holdDuty;
+  options["microsteps"] = slotOptions[slot].microsteps;
+  options["microstepSwitchRate"] = slotOptions[slot].microstepSwitchRate;
+  options["runOutput"] = slotOptions[slot].runOutput == 1 ? "ledc" : "step";
+
+  // Add motor-specific data if configured. Reconfiguration publishes a
+  // fresh snapshot, so a mismatched type means the slot changed under us.
+  MotorStatus s;
+  if (motors[slot] != nullptr && getStatus(slot, s) && s.type == motors[slot]->getType()) {
+    motors[slot]->toJson(obj, s);
+    StepMonitor::toJson(slot, obj, s);
+    AxisFollower::toJson(slot, obj);
+    WaveformGenerator::toJson(slot, obj);
   }
 }
 
+bool MotorManager::getStatus(uint8_t slot, MotorStatus& out) {
+  if (slot >= MAX_MOTORS) return false;
+  if (!status[slot].read(out)) return false;
+  return out.type != MotorType::NONE;
+}
+
+uint32_t MotorManager::statusVersion(uint8_t slot) {
+  return slot < MAX_MOTORS ? status[slot].version() : 0;
+}
+
+void MotorManager::publishStatus(uint8_t slot) {
+  MotorStatus s = {};
+  s.type = MotorType::NONE;
+  std::visit([&s](auto& motor) {
+    if constexpr (!std::is_same_v<std::decay_t<decltype(motor)>, std::monostate>) {
+      motor.captureStatus(s);
+    }
+  }, slots[slot]);
+  StepMonitor::capture(slot, s);
+  status[slot].publish(s);
+}
+
 uint8_t MotorManager::getConfiguredCount() {
   uint8_t count = 0;
   for (uint8_t i = 0; i < MAX_MOTORS; i++) {
@@ -305,6 +829,42 @@ void MotorManager::saveConfig() {
 
     snprintf(key, sizeof(key), "pinEx%d", i);
     prefs.putUChar(key, slotPins[i].pinEx);
+
+    snprintf(key, sizeof(key), "ms1p%d", i);
+    prefs.putUChar(key, slotPins[i].ms1);
+
+    snprintf(key, sizeof(key), "ms2p%d", i);
+    prefs.putUChar(key, slotPins[i].ms2);
+
+    snprintf(key, sizeof(key), "ms3p%d", i);
+    prefs.putUChar(key, slotPins[i].ms3);
+
+    snprintf(key, sizeof(key), "out%d", i);
+    prefs.putUChar(key, slotOptions[i].stepOutput);
+
+    snprintf(key, sizeof(key), "pwmf%d", i);
+    prefs.putULong(key, slotOptions[i].pwmFrequency);
+
+    snprintf(key, sizeof(key), "pwmr%d", i);
+    prefs.putUChar(key, slotOptions[i].pwmResolution);
+
+    snprintf(key, sizeof(key), "coil%d", i);
+    prefs.putUChar(key, slotOptions[i].coilMode);
+
+    snprintf(key, sizeof(key), "idle%d", i);
+    prefs.putUShort(key, slotOptions[i].idleReleaseMs);
+
+    snprintf(key, sizeof(key), "hold%d", i);
+    prefs.putUChar(key, slotOptions[i].holdDuty);
+
+    snprintf(key, sizeof(key), "mstp%d", i);
+    prefs.putUChar(key, slotOptions[i].microsteps);
+
+    snprintf(key, sizeof(key), "msr%d", i);
+    prefs.putULong(key, slotOptions[i].microstepSwitchRate);
+
+    snprintf(key, sizeof(key), "run%d", i);
+    prefs.putUChar(key, slotOptions[i].runOutput);
   }
 
   prefs.end();
@@ -333,6 +893,42 @@ void MotorManager::loadConfig() {
     snprintf(key, sizeof(key), "pinEx%d", i);
     slotPins[i].pinEx = prefs.getUChar(key, getDefaultSlotPins(i).pinEx);
 
+    snprintf(key, sizeof(key), "ms1p%d", i);
+    slotPins[i].ms1 = prefs.getUChar(key, 255);
+
+    snprintf(key, sizeof(key), "ms2p%d", i);
+    slotPins[i].ms2 = prefs.getUChar(key, 255);
+
+    snprintf(key, sizeof(key), "ms3p%d", i);
+    slotPins[i].ms3 = prefs.getUChar(key, 255);
+
+    snprintf(key, sizeof(key), "out%d", i);
+    slotOptions[i].stepOutput = prefs.getUChar(key, 0);
+
+    snprintf(key, sizeof(key), "pwmf%d", i);
+    slotOptions[i].pwmFrequency = prefs.getULong(key, PWM_FREQUENCY);
+
+    snprintf(key, sizeof(key), "pwmr%d", i);
+    slotOptions[i].pwmResolution = prefs.getUChar(key, PWM_RESOLUTION);
+
+    snprintf(key, sizeof(key), "coil%d", i);
+    slotOptions[i].coilMode = prefs.getUChar(key, 0);
+
+    snprintf(key, sizeof(key), "idle%d", i);
+    slotOptions[i].idleReleaseMs = prefs.getUShort(key, ULN2003_IDLE_RELEASE_MS);
+
+    snprintf(key, sizeof(key), "hold%d", i);
+    slotOptions[i].holdDuty = prefs.getUChar(key, ULN2003_HOLD_DUTY);
+
+    snprintf(key, sizeof(key), "mstp%d", i);
+    slotOptions[i].microsteps = prefs.getUChar(key, 1);
+
+    snprintf(key, sizeof(key), "msr%d", i);
+    slotOptions[i].microstepSwitchRate = prefs.getULong(key, 0);
+
+    snprintf(key, sizeof(key), "run%d", i);
+    slotOptions[i].runOutput = prefs.getUChar(key, 0);
+
     // Restore motor configuration
     if (type != MotorType::NONE) {
       configureSlot(i, type, slotPins[i]);
@@ -343,25 +939,47 @@ void MotorManager::loadConfig() {
   Serial.println("[MOTOR] Configuration loaded");
 }
 
-MotorBase* MotorManager::createMotor(uint8_t slot, MotorType type, const SlotPins& pins) {
+MotorBase* MotorManager::createMotor(uint8_t slot, MotorType type, const SlotPins& pins, const SlotOptions& options) {
+  StepOutput stepOutput = options.stepOutput == 1 ? StepOutput::RMT : StepOutput::TIMER;
+
   switch (type) {
     case MotorType::DC_L298N:
-      return new DCMotor(slot, DCDriverType::L298N, pins.pinA, pins.pinB, pins.pinEn);
+      return &slots[slot].emplace<DCMotor>(slot, DCDriverType::L298N, pins.pinA, pins.pinB, pins.pinEn,
+                                           options.pwmFrequency, options.pwmResolution);
 
     case MotorType::DC_L9110S:
-      return new DCMotor(slot, DCDriverType::L9110S, pins.pinA, pins.pinB);
+      return &slots[slot].emplace<DCMotor>(slot, DCDriverType::L9110S, pins.pinA, pins.pinB, 255,
+                                           options.pwmFrequency, options.pwmResolution);
 
     case MotorType::SERVO:
-      return new ServoMotor(slot, pins.pinA);
-
-    case MotorType::STEPPER_A4988:
-      return new StepperNema17(slot, StepperDriver::A4988, pins.pinA, pins.pinB, pins.pinEn);
+      return &slots[slot].emplace<ServoMotor>(slot, pins.pinA);
+
+    case MotorType::STEPPER_A4988: {
+      StepperNema17* stepper = &slots[slot].emplace<StepperNema17>(slot, StepperDriver::A4988, pins.pinA, pins.pinB, pins.pinEn,
+                                                                   pins.ms1, pins.ms2, pins.ms3);
+      stepper->setOutput(stepOutput);
+      stepper->setMicrosteps(static_cast<MicrostepMode>(options.microsteps));
+      stepper->setMicrostepSwitching(options.microstepSwitchRate);
+      stepper->setRunOutput(options.runOutput == 1);
+      return stepper;
+    }
 
-    case MotorType::STEPPER_DRV8825:
-      return new StepperNema17(slot, StepperDriver::DRV8825, pins.pinA, pins.pinB, pins.pinEn);
+    case MotorType::STEPPER_DRV8825: {
+      StepperNema17* stepper = &slots[slot].emplace<StepperNema17>(slot, StepperDriver::DRV8825, pins.pinA, pins.pinB, pins.pinEn,
+                                                                   pins.ms1, pins.ms2, pins.ms3);
+      stepper->setOutput(stepOutput);
+      stepper->setMicrosteps(static_cast<MicrostepMode>(options.microsteps));
+      stepper->setMicrostepSwitching(options.microstepSwitchRate);
+      stepper->setRunOutput(options.runOutput == 1);
+      return stepper;
+    }
 
-    case MotorType::STEPPER_ULN2003:
-      return new Stepper28BYJ48(slot, pins.pinA, pins.pinB, pins.pinEn, pins.pinEx);
+    case MotorType::STEPPER_ULN2003: {
+      Stepper28BYJ48* stepper = &slots[slot].emplace<Stepper28BYJ48>(slot, pins.pinA, pins.pinB, pins.pinEn, pins.pinEx);
+      stepper->setCoilMode(static_cast<CoilStepMode>(options.coilMode));
+      stepper->setIdleRelease(options.idleReleaseMs, options.holdDuty);
+      return stepper;
+    }
 
     default:
       return nullptr;
@@ -371,7 +989,9 @@ MotorBase* MotorManager::createMotor(uint8_t slot, MotorType type, const SlotPin
 void MotorManager::destroyMotor(uint8_t slot) {
   if (motors[slot] != nullptr) {
     motors[slot]->emergencyStop();
-    delete motors[slot];
     motors[slot] = nullptr;
   }
+  slots[slot].emplace<std::monostate>();
+  StepMonitor::requestAlign(slot);
+  releaseSetpoint(slot);
 }
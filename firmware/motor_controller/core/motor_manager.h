@@ -4,7 +4,13 @@
 #include <ArduinoJson.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <variant>
 #include "../config.h"
+#include "command_queue.h"
+#include "motor_status.h"
+#include "step_monitor.h"
+#include "cam_table.h"
+#include "waveform_generator.h"
 #include "../drivers/motor_base.h"
 #include "../drivers/dc_motor.h"
 #include "../drivers/servo_motor.h"
@@ -15,17 +21,23 @@
 // Motor Manager - Centralized Motor Slot Management
 // ============================================================================
 // Manages 4 motor slots with runtime motor type configuration.
-// Uses factory pattern to create appropriate driver instances.
+// Uses factory pattern to create appropriate driver instances in place in a
+// fixed per-slot variant, so reconfiguring never touches the heap.
 // Thread-safe access via mutex for FreeRTOS compatibility.
 
+// One slot's driver storage, sized for the largest driver
+using MotorSlot = std::variant<std::monostate, DCMotor, ServoMotor, StepperNema17, Stepper28BYJ48>;
+
 class MotorManager {
 public:
   // === Initialization ===
   static void init();
 
   // === Slot Management ===
-  static bool configureSlot(uint8_t slot, MotorType type, const JsonObject& config);
+  static bool configureSlot(uint8_t slot, MotorType type, const JsonObject& config,
+                            const JsonObject& options = JsonObject());
   static bool configureSlot(uint8_t slot, MotorType type, const SlotPins& pins);
+  static bool configureSlot(uint8_t slot, MotorType type, const SlotPins& pins, const SlotOptions& options);
   static bool removeMotor(uint8_t slot);
 
   // === Motor Access ===
@@ -36,12 +48,67 @@ public:
   // === Batch Operations ===
   static void stopAll();
   static void emergencyStopAll();
-  static void updateAll();  // Called from motor task
+  // Motor task while the e-stop is latched and updateAll() does not run:
+  // applies the RMT halts emergencyStopAll() requested
+  static void applyPendingHalts();
+  static bool updateAll();  // Called from motor task, false if the mutex was busy
 
   // === Control Commands ===
-  static bool sendCommand(uint8_t slot, CommandType cmd, int32_t value = 0, uint16_t duration = 0);
+  // Queued for the motor task; returns false if the slot is not configured
+  // or the source's queue is full
+  static bool sendCommand(uint8_t slot, CommandType cmd, int32_t value = 0, uint16_t duration = 0,
+                          CommandSource source = CommandSource::API);
+
+  // === Closed-Loop Tuning ===
+  // Speed PID gains of a DC slot (see DCMotor::setPidGains); false if the
+  // slot is not a DC motor
+  static bool setPidGains(uint8_t slot, float kp, float ki, float kd, float kff);
+  // Position loop gain (counts/s per count) and reference profile limits
+  static bool setPositionLoop(uint8_t slot, float kpPos, float maxSpeed, float acceleration);
+  // Speed slew limits of a DC slot (see DCMotor::setRampLimits), open loop
+  // in 8-bit duty/s and closed-loop speed in RPM/s; zero is unlimited
+  static bool setRampLimits(uint8_t slot, float acceleration, float deceleration, float jerk);
+  static bool setRpmRampLimits(uint8_t slot, float acceleration, float deceleration, float jerk);
+
+  // === Following ===
+  // Slaves a stepper, or a DC slot with a linked encoder, to a master
+  // encoder: numerator slave steps (DC: counts) per denominator master
+  // counts, updated every tick. False if the slot cannot follow.
+  static bool engageGear(uint8_t slot, uint8_t encoder, int32_t numerator, int32_t denominator);
+  // Same, with the slave position looked up in a cam table (see CamTable)
+  static bool engageCam(uint8_t slot, uint8_t encoder, const CamTable& table, const char* name);
+  static void disengageFollow(uint8_t slot);
+
+  // === Waveforms ===
+  // Oscillates a servo's angle, or a stepper's or encoder-linked DC slot's
+  // position, every tick (see WaveformGenerator). Retuning a running slot
+  // keeps its phase. False if the slot cannot run a waveform or the config
+  // is out of range.
+  static bool startWaveform(uint8_t slot, const WaveformConfig& config);
+  static void stopWaveform(uint8_t slot);
+
+  // === Step Loss Detection ===
+  // Checks a stepper slot against its linked encoder every tick (see
+  // StepMonitor); false if the slot is not a stepper or the config is invalid
+  static bool configureStepMonitor(uint8_t slot, const StepMonitorConfig& config);
+
+  // === Coordinated Moves ===
+  // Moves several step/dir stepper slots (timer output) along a straight line
+  // so they start and finish together. Targets are clamped to each slot's
+  // limits. maxRate caps the step rate of the longest axis (0 for none).
+  // Returns the axis group id, or -1 if a slot cannot join a group, is
+  // moving, or no group is free.
+  static int8_t moveAxes(const uint8_t* slots, const int32_t* targets, uint8_t count,
+                         float maxRate = 0);
+  // Same, for work run inside updateAll() on the motor task (mutex held)
+  static int8_t startGroupLocked(const uint8_t* slots, const int32_t* targets, uint8_t count,
+                                 float maxRate);
 
   // === Status ===
+  // Latest snapshot published by the motor task; safe from any task.
+  // Returns false for an empty slot.
+  static bool getStatus(uint8_t slot, MotorStatus& out);
+  static uint32_t statusVersion(uint8_t slot);  // See MotorStatusSlot::version()
   static void toJson(JsonDocument& doc);
   static void slotToJson(uint8_t slot, JsonObject& obj);
   static uint8_t getConfiguredCount();
@@ -51,11 +118,26 @@ public:
   static void loadConfig();
 
 private:
-  static MotorBase* motors[MAX_MOTORS];
+  static MotorSlot slots[MAX_MOTORS];
+  static MotorBase* motors[MAX_MOTORS];   // Into slots[], nullptr when empty
   static MotorType motorTypes[MAX_MOTORS];
   static SlotPins slotPins[MAX_MOTORS];
+  static SlotOptions slotOptions[MAX_MOTORS];
   static SemaphoreHandle_t mutex;
+  static MotorStatusSlot status[MAX_MOTORS];
 
-  static MotorBase* createMotor(uint8_t slot, MotorType type, const SlotPins& pins);
+  static MotorBase* createMotor(uint8_t slot, MotorType type, const SlotPins& pins, const SlotOptions& options);
   static void destroyMotor(uint8_t slot);
+  static void executeCommand(const MotorCommand& cmd);
+  static void feedEncoder(uint8_t slot, DCMotor& motor);
+  static bool isDcWithEncoder(uint8_t slot);
+  template <typename Stepper>
+  static void checkStepLoss(uint8_t slot, Stepper& motor);
+  template <typename Driver>
+  static void followMaster(uint8_t slot, Driver& motor);
+  static bool followOrigin(uint8_t slot, uint8_t encoder, int64_t& position);
+  template <typename Driver>
+  static void driveWaveform(uint8_t slot, Driver& motor);
+  static void releaseSetpoint(uint8_t slot);  // Drops follower and waveform
+  static void publishStatus(uint8_t slot);  // Mutex held
 };
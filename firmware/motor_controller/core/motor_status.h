@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "../config.h"
+
+// ============================================================================
+// Motor Status - Per Slot Snapshot Published by the Motor Task
+// ============================================================================
+// Drivers are only touched by the motor task. At the end of every tick it
+// captures the dynamic state of each slot into a MotorStatus and publishes
+// it through a seqlock; web handlers, preset recording and telemetry read
+// the copy and never wait on the control loop.
+//
+// Meaning of the shared fields by motor type:
+//   position  steps (steppers), angle (servo)
+//   target    target position (steppers), target angle (servo), target duty (DC)
+//   speed     steps/s (steppers), degrees/s (servo), signed duty (DC)
+
+struct MotorStatus {
+  MotorType type;          // NONE when the slot is empty
+  bool enabled;
+  bool moving;
+  bool braking;            // DC
+  bool closedLoop;         // DC, speed held by the encoder PID
+  bool positionMode;       // DC, closed-loop position
+  bool attached;           // Servo
+  bool smoothMode;         // Servo
+  bool constantSpeed;      // NEMA17
+  bool frequencyRun;       // NEMA17, constant speed run on the LEDC output
+  bool driverEnabled;      // NEMA17
+  uint8_t queuedMoves;     // NEMA17, look-ahead targets behind target
+  uint8_t microstepShift;  // NEMA17, microstep switching level, 0 = configured microsteps
+  uint8_t coilState;       // 28BYJ-48, CoilState
+  int32_t position;
+  int32_t target;
+  float speed;
+  float maxSpeed;          // Steppers, steps/s
+  float acceleration;      // Steppers, steps/s^2
+  float targetRpm;         // DC closed loop
+  float rampRpm;           // DC closed loop, setpoint after the RPM slew limit
+  float rpm;               // DC closed loop, measured
+  float pidIntegral;       // DC closed loop, integrator share of the duty
+  int64_t targetPosition;  // DC position mode, extended encoder counts
+  int64_t encoderPosition; // DC with a linked encoder, extended count
+  int32_t followingError;  // Steppers with a step monitor: steps minus encoder, steps
+  int32_t peakFollowingError;
+  uint16_t stepLossTrips;
+  char error[64];
+};
+
+// Single writer at a time (writers hold the MotorManager mutex), any
+// number of readers. An odd sequence means a write is in progress.
+class MotorStatusSlot {
+public:
+  void publish(const MotorStatus& s) {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&data, &s, sizeof(data));
+    sequence.store(seq + 2, std::memory_order_release);
+  }
+
+  // Returns false if every attempt raced a write
+  bool read(MotorStatus& out) const {
+    for (uint8_t attempt = 0; attempt < MOTOR_STATUS_READ_RETRIES; attempt++) {
+      uint32_t before = sequence.load(std::memory_order_acquire);
+      if (before & 1) continue;
+      memcpy(&out, &data, sizeof(out));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+  }
+
+  // Advances by two per publish; odd while one is in progress
+  uint32_t version() const {
+    return sequence.load(std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<uint32_t> sequence{0};
+  MotorStatus data = {};
+};
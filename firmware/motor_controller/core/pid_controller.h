@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// PID Controller - Fixed-Point Loop for the Motor Task
+// ============================================================================
+// Setpoint and measurement are integers in the caller's units (encoder
+// counts/s for DC speed control). Gains are Q16.16 with the sample period
+// folded into the integral and derivative terms, so an update is a handful
+// of 64-bit multiplies and no float or divide.
+//
+// - Feed-forward adds kff * setpoint, so the integrator only has to carry
+//   the load and friction error.
+// - The derivative acts on the measurement, so a setpoint step does not kick.
+// - Anti-windup: the integrator is held while the output is saturated in the
+//   direction the error is pushing, and never holds more than the limit.
+//
+// Header-only and free of Arduino dependencies; scripts/check_kernels.sh
+// runs it on the host, including a 16-bit duty limit.
+
+struct PidState {
+  int32_t kpQ16;         // Output per unit of error
+  int32_t kiQ16;         // Output per unit of error per sample
+  int32_t kdQ16;         // Output per unit change of measurement per sample
+  int32_t kffQ16;        // Output per unit of setpoint
+  int64_t integralQ16;   // Integrator, output units << 16; 16-bit duty needs more than 32 bits
+  int32_t lastMeasured;
+  int32_t limit;         // Output clamp, +-limit
+  bool primed;           // lastMeasured is valid
+};
+
+class PidController {
+public:
+  // === Setup (task context, float) ===
+  // Gains in output units per unit (kp, kff), per unit-second (ki) and per
+  // unit/second (kd); samplePeriod in seconds
+  static void setGains(PidState& s, float kp, float ki, float kd, float kff, float samplePeriod) {
+    s.kpQ16 = toQ16(kp);
+    s.kiQ16 = toQ16(ki * samplePeriod);
+    s.kdQ16 = samplePeriod > 0 ? toQ16(kd / samplePeriod) : 0;
+    s.kffQ16 = toQ16(kff);
+  }
+
+  // Clears the history; the integrator starts at `output` so a switch from
+  // open loop does not jump
+  static void reset(PidState& s, int32_t limit, int32_t output = 0) {
+    s.limit = limit;
+    s.integralQ16 = clamp((int64_t)output << 16, (int64_t)limit << 16);
+    s.primed = false;
+  }
+
+  // === Sample ===
+  static int32_t update(PidState& s, int32_t setpoint, int32_t measured) {
+    const int64_t limitQ16 = (int64_t)s.limit << 16;
+    int64_t error = (int64_t)setpoint - measured;
+
+    int64_t derivative = 0;
+    if (s.primed) derivative = -(int64_t)s.kdQ16 * ((int64_t)measured - s.lastMeasured);
+    s.lastMeasured = measured;
+    s.primed = true;
+
+    int64_t fixed = (int64_t)s.kpQ16 * error + (int64_t)s.kffQ16 * setpoint + derivative;
+    int64_t integral = clamp(s.integralQ16 + (int64_t)s.kiQ16 * error, limitQ16);
+
+    // Hold the integrator if this sample would push it further into saturation
+    int64_t out = fixed + integral;
+    bool windup = (out > limitQ16 && error > 0) || (out < -limitQ16 && error < 0);
+    if (!windup) s.integralQ16 = integral;
+
+    out = clamp(fixed + s.integralQ16, limitQ16);
+    return (int32_t)(out >> 16);
+  }
+
+  static float integralOutput(const PidState& s) {
+    return (float)s.integralQ16 / 65536.0f;
+  }
+
+private:
+  static int32_t toQ16(float v) {
+    float q = v * 65536.0f;
+    if (q > 2147483647.0f) return INT32_MAX;
+    if (q < -2147483648.0f) return INT32_MIN;
+    return (int32_t)(q >= 0 ? q + 0.5f : q - 0.5f);
+  }
+
+  static int64_t clamp(int64_t v, int64_t limit) {
+    return v > limit ? limit : (v < -limit ? -limit : v);
+  }
+};
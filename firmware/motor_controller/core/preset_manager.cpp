@@ -45,6 +45,7 @@ bool PresetManager::savePreset(const char* name, const Preset& preset) {
   for (uint8_t i = 0; i < preset.stepCount; i++) {
     JsonObject stepObj = stepsArr.createNestedObject();
     stepObj["delayAfter"] = preset.steps[i].delayAfter;
+    stepObj["blend"] = preset.steps[i].blend;
     stepObj["commandCount"] = preset.steps[i].commandCount;
 
     JsonArray cmdsArr = stepObj.createNestedArray("commands");
@@ -96,6 +97,7 @@ bool PresetManager::loadPreset(const char* name, Preset& preset) {
     if (stepIdx >= MAX_SEQUENCE_STEPS) break;
 
     preset.steps[stepIdx].delayAfter = stepObj["delayAfter"] | 0;
+    preset.steps[stepIdx].blend = stepObj["blend"] | false;
     preset.steps[stepIdx].commandCount = stepObj["commandCount"] | 0;
 
     JsonArray cmdsArr = stepObj["commands"];
@@ -281,27 +283,28 @@ void PresetManager::recordMotorState() {
   memset(&step, 0, sizeof(step));
   step.commandCount = 0;
   step.delayAfter = 500;  // Default 500ms delay
+  step.blend = false;
 
   for (uint8_t i = 0; i < MAX_MOTORS; i++) {
-    MotorBase* motor = MotorManager::getMotor(i);
-    if (motor == nullptr) continue;
+    MotorStatus status;
+    if (!MotorManager::getStatus(i, status)) continue;
 
     MotorCommand cmd;
     cmd.slot = i;
     cmd.duration = 0;
 
-    MotorType type = motor->getType();
+    MotorType type = status.type;
 
     if (type == MotorType::SERVO) {
       cmd.command = CommandType::SET_ANGLE;
-      cmd.value = motor->getPosition();
+      cmd.value = status.position;
     } else if (type == MotorType::STEPPER_A4988 || type == MotorType::STEPPER_DRV8825 ||
                type == MotorType::STEPPER_ULN2003) {
       cmd.command = CommandType::SET_POSITION;
-      cmd.value = motor->getPosition();
+      cmd.value = status.position;
     } else {
       cmd.command = CommandType::SET_SPEED;
-      cmd.value = (int32_t)motor->getSpeed();
+      cmd.value = (int32_t)status.speed;
     }
 
     step.commands[step.commandCount++] = cmd;
@@ -356,6 +359,7 @@ bool PresetManager::presetToJson(const char* name, JsonObject& obj) {
     JsonObject stepObj = stepsArr.createNestedObject();
     stepObj["index"] = i;
     stepObj["delayAfter"] = preset.steps[i].delayAfter;
+    stepObj["blend"] = preset.steps[i].blend;
     stepObj["commandCount"] = preset.steps[i].commandCount;
 
     JsonArray cmdsArr = stepObj.createNestedArray("commands");
@@ -383,6 +387,7 @@ bool PresetManager::presetFromJson(const JsonObject& obj, Preset& preset) {
 
     SequenceStep& step = preset.steps[preset.stepCount];
     step.delayAfter = stepObj["delayAfter"] | 500;
+    step.blend = stepObj["blend"] | false;
     step.commandCount = 0;
 
     JsonArray cmdsArr = stepObj["commands"];
@@ -412,6 +417,13 @@ String PresetManager::getPresetPath(const char* name) {
 }
 
 void PresetManager::playbackTaskFunc(void* param) {
+  // A blended step hands its stepper targets to the look-ahead queue and
+  // moves straight on; the steps it blends into are queued the same way,
+  // so the motion only stops where the chain ends or reverses.
+  bool chained = false;
+  bool chainSlots[MAX_MOTORS] = {false};
+  int32_t planned[MAX_MOTORS] = {0};
+
   while (playing) {
     // Check for E-stop
     if (SafetyManager::isEstopActive()) {
@@ -432,10 +444,47 @@ void PresetManager::playbackTaskFunc(void* param) {
 
     // Execute current step
     SequenceStep& step = currentPreset.steps[currentStepIndex];
+    bool queueMoves = step.blend || chained;
+
+    if (queueMoves && !waitForLookahead(step)) break;
 
     for (uint8_t i = 0; i < step.commandCount; i++) {
       MotorCommand& cmd = step.commands[i];
-      MotorManager::sendCommand(cmd.slot, cmd.command, cmd.value, cmd.duration);
+      CommandType type = cmd.command;
+      int32_t value = cmd.value;
+
+      if (queueMoves && isQueuedMove(cmd)) {
+        // Relative moves continue from the end of what is already queued
+        if (!chainSlots[cmd.slot]) {
+          MotorStatus status;
+          planned[cmd.slot] = MotorManager::getStatus(cmd.slot, status) ? status.target : 0;
+          chainSlots[cmd.slot] = true;
+        }
+        if (type == CommandType::MOVE_RELATIVE) value = planned[cmd.slot] + cmd.value;
+        else if (type == CommandType::HOME) value = 0;
+        planned[cmd.slot] = value;
+        type = CommandType::QUEUE_POSITION;
+      }
+
+      if (!MotorManager::sendCommand(cmd.slot, type, value, cmd.duration,
+                                     CommandSource::PLAYBACK)) {
+        Serial.printf("[PRESET] Command for slot %d not queued\n", cmd.slot);
+      }
+    }
+
+    if (step.blend) {
+      // The next step checks for look-ahead room against these moves
+      chained = true;
+      if (!waitForApplied(step)) break;
+      currentStepIndex++;
+      continue;
+    }
+
+    if (chained) {
+      // End of a blended chain: delayAfter counts from the stop
+      if (!waitForApplied(step) || !waitForMotion(chainSlots)) break;
+      chained = false;
+      memset(chainSlots, 0, sizeof(chainSlots));
     }
 
     // Wait for delay
@@ -450,3 +499,75 @@ void PresetManager::playbackTaskFunc(void* param) {
   playbackTask = nullptr;
   vTaskDelete(nullptr);
 }
+
+bool PresetManager::isQueuedMove(const MotorCommand& cmd) {
+  if (cmd.command != CommandType::SET_POSITION && cmd.command != CommandType::MOVE_RELATIVE &&
+      cmd.command != CommandType::HOME) {
+    return false;
+  }
+  MotorType type = MotorManager::getMotorType(cmd.slot);
+  return type == MotorType::STEPPER_A4988 || type == MotorType::STEPPER_DRV8825 ||
+         type == MotorType::STEPPER_ULN2003;
+}
+
+// Blocks until the motor task has run every command this task queued and
+// published the step's slots since. The motor task may skip ticks (mutex
+// busy) or overrun, so this waits on the queue and the status version
+// rather than a fixed time. Returns false if playback was stopped meanwhile.
+bool PresetManager::waitForApplied(const SequenceStep& step) {
+  while (CommandQueue::pending(CommandSource::PLAYBACK) > 0) {
+    if (!playing || SafetyManager::isEstopActive()) return false;
+    vTaskDelay(pdMS_TO_TICKS(MOTOR_TASK_INTERVAL_MS));
+  }
+
+  // The commands are drained and run at the start of a tick, so a publish
+  // that starts after this point shows them
+  uint32_t since[MAX_MOTORS];
+  for (uint8_t i = 0; i < step.commandCount; i++) {
+    uint8_t slot = step.commands[i].slot;
+    if (slot < MAX_MOTORS) since[slot] = (MotorManager::statusVersion(slot) + 1) & ~1u;
+  }
+  for (uint8_t i = 0; i < step.commandCount; i++) {
+    uint8_t slot = step.commands[i].slot;
+    if (slot >= MAX_MOTORS) continue;
+    while ((int32_t)(MotorManager::statusVersion(slot) - since[slot]) < 2) {
+      if (!playing || SafetyManager::isEstopActive()) return false;
+      vTaskDelay(pdMS_TO_TICKS(MOTOR_TASK_INTERVAL_MS));
+    }
+  }
+  return playing;
+}
+
+// Blocks until every stepper in the step can take one more target: a free
+// look-ahead entry (one spare for a command still in flight), or for the
+// 28BYJ-48, which has no look-ahead, the end of its current move.
+// Returns false if playback was stopped meanwhile.
+bool PresetManager::waitForLookahead(const SequenceStep& step) {
+  for (uint8_t i = 0; i < step.commandCount; i++) {
+    if (!isQueuedMove(step.commands[i])) continue;
+
+    MotorStatus status;
+    while (MotorManager::getStatus(step.commands[i].slot, status)) {
+      bool room = status.type == MotorType::STEPPER_ULN2003
+                    ? !status.moving
+                    : status.queuedMoves < STEP_LOOKAHEAD_DEPTH - 1;
+      if (room) break;
+      if (!playing || SafetyManager::isEstopActive()) return false;
+      vTaskDelay(pdMS_TO_TICKS(MOTOR_TASK_INTERVAL_MS));
+    }
+  }
+  return playing;
+}
+
+bool PresetManager::waitForMotion(const bool* slots) {
+  for (uint8_t slot = 0; slot < MAX_MOTORS; slot++) {
+    if (!slots[slot]) continue;
+
+    MotorStatus status;
+    while (MotorManager::getStatus(slot, status) && (status.moving || status.queuedMoves > 0)) {
+      if (!playing || SafetyManager::isEstopActive()) return false;
+      vTaskDelay(pdMS_TO_TICKS(MOTOR_TASK_INTERVAL_MS));
+    }
+  }
+  return playing;
+}
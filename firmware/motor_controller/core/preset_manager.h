@@ -9,17 +9,11 @@
 // Preset Manager - Motion Sequence Storage and Playback
 // ============================================================================
 
-struct MotorCommand {
-  uint8_t slot;
-  CommandType command;
-  int32_t value;
-  uint16_t duration;  // ms, 0 = instant
-};
-
 struct SequenceStep {
   MotorCommand commands[MAX_MOTORS];
   uint8_t commandCount;
   uint16_t delayAfter;  // Delay after this step in ms
+  bool blend;           // Stepper moves run on into the next step without stopping; no delay
 };
 
 struct Preset {
@@ -77,5 +71,11 @@ private:
   static TaskHandle_t playbackTask;
   static void playbackTaskFunc(void* param);
 
+  // Look-ahead playback of blended steps
+  static bool isQueuedMove(const MotorCommand& cmd);
+  static bool waitForApplied(const SequenceStep& step);
+  static bool waitForLookahead(const SequenceStep& step);
+  static bool waitForMotion(const bool* slots);
+
   static String getPresetPath(const char* name);
 };
@@ -7,6 +7,9 @@ volatile bool SafetyManager::estopTriggered = false;
 uint32_t SafetyManager::estopCount = 0;
 uint32_t SafetyManager::lastEstopTime = 0;
 uint32_t SafetyManager::lastDebounceTime = 0;
+uint32_t SafetyManager::faultCount = 0;
+int8_t SafetyManager::faultSlot = -1;
+char SafetyManager::faultReason[48] = "";
 SafetyManager::EstopCallback SafetyManager::estopCallback = nullptr;
 SafetyManager::EstopCallback SafetyManager::resetCallback = nullptr;
 
@@ -82,7 +85,24 @@ void SafetyManager::triggerEstop() {
   }
 }
 
+void SafetyManager::raiseFault(uint8_t slot, const char* reason) {
+  if (state != SafetyState::ESTOP_ACTIVE) {
+    state = SafetyState::FAULT;
+  }
+  faultCount++;
+  faultSlot = slot;
+  strlcpy(faultReason, reason, sizeof(faultReason));
+
+  Serial.printf("[SAFETY] FAULT on slot %d: %s\n", slot, reason);
+}
+
 void SafetyManager::resetEstop() {
+  if (state == SafetyState::FAULT) {
+    state = SafetyState::NORMAL;
+    Serial.println("[SAFETY] Fault cleared, system normal");
+    return;
+  }
+
   if (state == SafetyState::ESTOP_ACTIVE) {
     // Check if E-stop button is still pressed
     if (digitalRead(ESTOP_PIN) == LOW) {
@@ -144,6 +164,11 @@ void SafetyManager::toJson(JsonObject& obj) {
   obj["lastEstopTime"] = lastEstopTime;
   obj["estopPin"] = ESTOP_PIN;
   obj["estopPinState"] = digitalRead(ESTOP_PIN);
+  obj["faultCount"] = faultCount;
+  if (faultSlot >= 0) {
+    obj["faultSlot"] = faultSlot;
+    obj["faultReason"] = faultReason;
+  }
 }
 
 void SafetyManager::onEstop(EstopCallback callback) {
@@ -19,6 +19,10 @@ public:
   static void resetEstop();
   static bool isEstopActive();
 
+  // === Faults ===
+  // Latches FAULT (unless the E-stop is active); cleared by resetEstop()
+  static void raiseFault(uint8_t slot, const char* reason);
+
   // === Position Limits ===
   static void setPositionLimits(uint8_t slot, int32_t min, int32_t max);
   static void clearPositionLimits(uint8_t slot);
@@ -37,6 +41,7 @@ public:
   // === Statistics ===
   static uint32_t getEstopCount() { return estopCount; }
   static uint32_t getLastEstopTime() { return lastEstopTime; }
+  static uint32_t getFaultCount() { return faultCount; }
 
 private:
   static SafetyState state;
@@ -44,6 +49,9 @@ private:
   static uint32_t estopCount;
   static uint32_t lastEstopTime;
   static uint32_t lastDebounceTime;
+  static uint32_t faultCount;
+  static int8_t faultSlot;
+  static char faultReason[48];
 
   static EstopCallback estopCallback;
   static EstopCallback resetCallback;
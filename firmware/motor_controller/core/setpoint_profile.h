@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// ============================================================================
+// Setpoint Profile - Trapezoidal Reference for Closed-Loop Position
+// ============================================================================
+// Moves a reference position towards the target at no more than maxSpeed,
+// changing speed by at most acceleration per second, and starts braking as
+// soon as the remaining distance is what it takes to stop. Evaluated one
+// sample at a time, so the target can change mid-move (including reversals)
+// and the reference stays continuous in position and speed.
+//
+// The position loop follows the reference position and uses its velocity as
+// feed-forward for the speed loop. Units are the caller's (encoder counts).
+// Header-only; checked on the host by scripts/check_kernels.sh.
+
+struct SetpointProfile {
+  float position;      // Reference position
+  float velocity;      // Reference velocity, units/s
+  float target;
+  float maxSpeed;      // units/s
+  float acceleration;  // units/s^2
+  bool done;           // Reference has settled on the target
+};
+
+class SetpointGenerator {
+public:
+  static void start(SetpointProfile& p, float position, float velocity) {
+    p.position = position;
+    p.velocity = velocity;
+    p.target = position;
+    p.done = true;
+  }
+
+  static void setTarget(SetpointProfile& p, float target) {
+    p.target = target;
+    p.done = false;
+  }
+
+  static void step(SetpointProfile& p, float dt) {
+    if (p.done) return;
+
+    float remaining = p.target - p.position;
+    float dv = p.acceleration * dt;
+
+    // Close enough to stop within this sample
+    if (fabsf(remaining) <= 0.5f && fabsf(p.velocity) <= dv) {
+      p.position = p.target;
+      p.velocity = 0.0f;
+      p.done = true;
+      return;
+    }
+
+    // Fastest speed towards the target that can still stop on it
+    float dir = remaining > 0 ? 1.0f : -1.0f;
+    float stopSpeed = sqrtf(2.0f * p.acceleration * fabsf(remaining));
+    float wanted = dir * (stopSpeed < p.maxSpeed ? stopSpeed : p.maxSpeed);
+
+    float change = wanted - p.velocity;
+    if (change > dv) change = dv;
+    if (change < -dv) change = -dv;
+    p.velocity += change;
+    p.position += p.velocity * dt;
+
+    // Do not step past the target on the last sample of a move
+    if ((p.target - p.position) * dir < 0 && p.velocity * dir > 0 && fabsf(p.velocity) <= 2.0f * dv) {
+      p.position = p.target;
+      p.velocity = 0.0f;
+      p.done = true;
+    }
+  }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// ============================================================================
+// Slew Limiter - Time-Based Rate Limit with Optional Jerk
+// ============================================================================
+// Moves a value towards a target at no more than acceleration per second
+// while its magnitude grows and deceleration per second while it shrinks
+// towards zero, so spin-up and spin-down can be tuned apart. Steps take the
+// elapsed time, so the ramp lasts as long however often it is evaluated.
+//
+// With a jerk limit the rate of change itself ramps by at most jerk per
+// second, and eases off as the value nears the target (an S-curve).
+// Zero acceleration or deceleration means no limit in that direction.
+// Header-only; scripts/check_kernels.sh runs the ramps on the host.
+
+struct SlewLimiter {
+  float value;         // Limited output
+  float rate;          // Present rate of change, units/s
+  float acceleration;  // units/s while |value| grows
+  float deceleration;  // units/s while |value| shrinks
+  float jerk;          // units/s^2, 0 = rate changes instantly
+};
+
+class SlewRateLimiter {
+public:
+  static void reset(SlewLimiter& s, float value) {
+    s.value = value;
+    s.rate = 0.0f;
+  }
+
+  static float step(SlewLimiter& s, float target, float dt) {
+    float remaining = target - s.value;
+    if (remaining == 0.0f) {
+      s.rate = 0.0f;
+      return s.value;
+    }
+
+    float dir = remaining > 0 ? 1.0f : -1.0f;
+    bool growing = s.value == 0.0f || (s.value > 0) == (remaining > 0);
+    float limit = growing ? s.acceleration : s.deceleration;
+    if (limit <= 0.0f) {
+      reset(s, target);
+      return s.value;
+    }
+
+    if (s.jerk > 0.0f) {
+      // Fastest rate towards the target that can still ease to zero on it
+      float easeRate = sqrtf(2.0f * s.jerk * fabsf(remaining));
+      float wanted = dir * (easeRate < limit ? easeRate : limit);
+      float change = wanted - s.rate;
+      float dr = s.jerk * dt;
+      if (change > dr) change = dr;
+      if (change < -dr) change = -dr;
+      s.rate += change;
+    } else {
+      s.rate = dir * limit;
+    }
+
+    s.value += s.rate * dt;
+
+    // Do not step past the target
+    if ((target - s.value) * dir <= 0.0f) {
+      reset(s, target);
+    }
+    return s.value;
+  }
+};
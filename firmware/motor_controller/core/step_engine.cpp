@@ -0,0 +1,912 @@
+#include "step_engine.h"
+#include <soc/gpio_struct.h>
+
+// Static member initialization
+StepChannel StepEngine::channels[MAX_STEP_CHANNELS];
+StepGroup StepEngine::groups[MAX_AXIS_GROUPS];
+gptimer_handle_t StepEngine::timer = nullptr;
+portMUX_TYPE StepEngine::lock = portMUX_INITIALIZER_UNLOCKED;
+volatile bool StepEngine::alarmArmed = false;
+volatile uint64_t StepEngine::alarmAt = 0;
+volatile uint32_t StepEngine::isrCount = 0;
+
+static constexpr uint64_t EVENT_IDLE = UINT64_MAX;
+
+bool StepEngine::init() {
+  if (timer != nullptr) return true;
+
+  for (uint8_t i = 0; i < MAX_STEP_CHANNELS; i++) {
+    memset(&channels[i], 0, sizeof(StepChannel));
+    channels[i].stepPin = 255;
+    channels[i].dirPin = 255;
+    channels[i].direction = 1;
+    channels[i].pendingDir = 1;
+    channels[i].nextEvent = EVENT_IDLE;
+    channels[i].group = -1;
+    MotionPlanner::init(channels[i].ramp, STEP_ENGINE_TIMER_HZ, DEFAULT_STEPPER_SPEED, DEFAULT_STEPPER_ACCEL);
+  }
+
+  for (uint8_t g = 0; g < MAX_AXIS_GROUPS; g++) {
+    memset(&groups[g], 0, sizeof(StepGroup));
+    groups[g].nextEvent = EVENT_IDLE;
+  }
+
+  gptimer_config_t config = {};
+  config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+  config.direction = GPTIMER_COUNT_UP;
+  config.resolution_hz = STEP_ENGINE_TIMER_HZ;
+
+  if (gptimer_new_timer(&config, &timer) != ESP_OK) {
+    timer = nullptr;
+    Serial.println("[STEP] Failed to allocate step timer!");
+    return false;
+  }
+
+  gptimer_event_callbacks_t callbacks = {};
+  callbacks.on_alarm = onAlarm;
+  gptimer_register_event_callbacks(timer, &callbacks, nullptr);
+  gptimer_enable(timer);
+  gptimer_start(timer);
+
+  Serial.printf("[STEP] Step engine initialized (%lu Hz timer, %d channels)\n",
+                (unsigned long)STEP_ENGINE_TIMER_HZ, MAX_STEP_CHANNELS);
+  return true;
+}
+
+int8_t StepEngine::attach(uint8_t stepPin, uint8_t dirPin, bool invertDir) {
+  if (timer == nullptr && !init()) return -1;
+
+  for (uint8_t i = 0; i < MAX_STEP_CHANNELS; i++) {
+    if (channels[i].attached) continue;
+
+    pinMode(stepPin, OUTPUT);
+    digitalWrite(stepPin, LOW);
+    if (dirPin != 255) {
+      pinMode(dirPin, OUTPUT);
+      digitalWrite(dirPin, invertDir ? HIGH : LOW);
+    }
+
+    portENTER_CRITICAL(&lock);
+    StepChannel& c = channels[i];
+    memset(&c, 0, sizeof(StepChannel));
+    c.stepPin = stepPin;
+    c.dirPin = dirPin;
+    c.invertDir = invertDir;
+    c.direction = 1;
+    c.pendingDir = 1;
+    c.nextEvent = EVENT_IDLE;
+    c.posMin = INT32_MIN;
+    c.posMax = INT32_MAX;
+    c.group = -1;
+    MotionPlanner::init(c.ramp, STEP_ENGINE_TIMER_HZ, DEFAULT_STEPPER_SPEED, DEFAULT_STEPPER_ACCEL);
+    c.shiftC0Q8[0] = c.ramp.c0Q8;
+    c.shiftCminQ8[0] = c.ramp.cminQ8;
+    c.attached = true;
+    portEXIT_CRITICAL(&lock);
+    return i;
+  }
+
+  Serial.println("[STEP] No free step channel");
+  return -1;
+}
+
+void StepEngine::detach(int8_t ch) {
+  if (!validChannel(ch)) return;
+
+  halt(ch);
+
+  portENTER_CRITICAL(&lock);
+  channels[ch].attached = false;
+  portEXIT_CRITICAL(&lock);
+}
+
+void StepEngine::moveTo(int8_t ch, int32_t target) {
+  if (!validChannel(ch)) return;
+  StepChannel& c = channels[ch];
+
+  // An independent move takes the axis out of its group
+  if (c.group >= 0) haltGroup(c.group);
+
+  portENTER_CRITICAL(&lock);
+  clearSegments(c);
+  c.target = target;
+  if (c.continuous) {
+    // Leave constant speed mode without a speed jump
+    c.continuous = false;
+    c.ramp.n = MotionPlanner::stepsToStop(c.ramp);
+  }
+
+  if (!c.running) {
+    if (c.position != target) {
+      c.ramp.n = 0;
+      c.running = true;
+      advanceRamp(c);
+      // A pending fall event will latch the direction and schedule the
+      // next rise; otherwise start the channel from idle.
+      if (!c.stepHigh) scheduleStart(c);
+    }
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+bool StepEngine::queueMove(int8_t ch, int32_t target) {
+  if (!validChannel(ch)) return false;
+  StepChannel& c = channels[ch];
+
+  if (c.group >= 0) haltGroup(c.group);
+
+  portENTER_CRITICAL(&lock);
+  if (c.running && !c.continuous) {
+    bool queued = appendSegment(c, target);
+    portEXIT_CRITICAL(&lock);
+    return queued;
+  }
+  portEXIT_CRITICAL(&lock);
+
+  // Nothing to follow: an ordinary move
+  moveTo(ch, target);
+  return true;
+}
+
+void StepEngine::runSpeed(int8_t ch, float stepsPerSecond) {
+  if (!validChannel(ch)) return;
+  StepChannel& c = channels[ch];
+
+  if (stepsPerSecond == 0.0f) {
+    halt(ch);
+    return;
+  }
+
+  if (c.group >= 0) haltGroup(c.group);
+
+  uint32_t intervalQ8 = MotionPlanner::intervalQ8(c.ramp, fabsf(stepsPerSecond));
+  if (intervalQ8 < c.shiftCminQ8[0]) intervalQ8 = c.shiftCminQ8[0];
+
+  portENTER_CRITICAL(&lock);
+  clearSegments(c);
+  if (c.shift > 0) setShift(c, 0);  // Constant speed runs at the finest level
+  c.continuous = true;
+  c.ramp.cnQ8 = intervalQ8;
+  c.ramp.n = 0;
+  c.pendingDir = stepsPerSecond > 0 ? 1 : -1;
+
+  if (!c.running) {
+    c.running = true;
+    if (!c.stepHigh) scheduleStart(c);
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+void StepEngine::stop(int8_t ch) {
+  if (!validChannel(ch)) return;
+  StepChannel& c = channels[ch];
+
+  // Stopping one axis of a coordinated move stops the whole line
+  if (c.group >= 0) {
+    stopGroup(c.group);
+    return;
+  }
+
+  portENTER_CRITICAL(&lock);
+  clearSegments(c);
+  if (c.running) {
+    if (c.continuous) {
+      c.continuous = false;
+      c.ramp.n = MotionPlanner::stepsToStop(c.ramp);
+      c.target = c.position + c.direction * (c.ramp.n + 1);
+    } else {
+      // Steps to stop are physical steps at the current microstep level
+      int32_t stepsToStop = c.ramp.n >= 0 ? c.ramp.n : -c.ramp.n;
+      c.target = c.position + c.direction * (stepsToStop << c.shift);
+    }
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+void StepEngine::halt(int8_t ch) {
+  if (!validChannel(ch)) return;
+  StepChannel& c = channels[ch];
+
+  if (c.group >= 0) haltGroup(c.group);
+
+  portENTER_CRITICAL(&lock);
+  clearSegments(c);
+  c.running = false;
+  c.continuous = false;
+  c.ramp.n = 0;
+  c.target = c.position;
+  c.stepHigh = false;
+  c.nextEvent = EVENT_IDLE;
+  if (c.shift > 0) setShift(c, 0);
+  portEXIT_CRITICAL(&lock);
+
+  digitalWrite(c.stepPin, LOW);
+}
+
+void StepEngine::setMaxSpeed(int8_t ch, float stepsPerSecond) {
+  if (!validChannel(ch)) return;
+
+  StepChannel& c = channels[ch];
+
+  // Speed in finest microsteps; a level 2^s coarser needs 2^s times fewer
+  // pulses, each level capped by the engine's pulse rate
+  float speed = stepsPerSecond < 1.0f ? 1.0f : stepsPerSecond;
+  uint32_t cminQ8[STEP_MICROSTEP_MAX_SHIFT + 1];
+  for (uint8_t s = 0; s <= STEP_MICROSTEP_MAX_SHIFT; s++) {
+    float rate = speed / (1 << s);
+    cminQ8[s] = MotionPlanner::intervalQ8(c.ramp, rate > STEP_ENGINE_MAX_RATE ? STEP_ENGINE_MAX_RATE : rate);
+  }
+
+  portENTER_CRITICAL(&lock);
+  memcpy(c.shiftCminQ8, cminQ8, sizeof(cminQ8));
+  c.ramp.cminQ8 = cminQ8[c.shift];
+  portEXIT_CRITICAL(&lock);
+}
+
+void StepEngine::setAcceleration(int8_t ch, float stepsPerSecondSquared) {
+  if (!validChannel(ch)) return;
+
+  StepChannel& c = channels[ch];
+
+  // First interval per microstep level: in steps 2^s times coarser the
+  // acceleration is 2^s times lower
+  float accel = stepsPerSecondSquared < 1.0f ? 1.0f : stepsPerSecondSquared;
+  uint32_t c0Q8[STEP_MICROSTEP_MAX_SHIFT + 1];
+  for (uint8_t s = 1; s <= STEP_MICROSTEP_MAX_SHIFT; s++) {
+    c0Q8[s] = MotionPlanner::intervalQ8(c.ramp, sqrtf(accel / (2.0f * (1 << s))));
+  }
+
+  // Ramp index is re-derived so a move in progress keeps its speed
+  portENTER_CRITICAL(&lock);
+  MotionPlanner::setAcceleration(c.ramp, accel);
+  c0Q8[0] = c.ramp.c0Q8;
+  memcpy(c.shiftC0Q8, c0Q8, sizeof(c0Q8));
+  if (c.shift > 0) {
+    // The ramp counts coarse steps: 2^shift times more of them to stop
+    c.ramp.c0Q8 = c0Q8[c.shift];
+    if (c.ramp.n > 0) c.ramp.n <<= c.shift;
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+void StepEngine::setPosition(int8_t ch, int32_t position) {
+  if (!validChannel(ch)) return;
+  if (channels[ch].group >= 0) haltGroup(channels[ch].group);
+
+  portENTER_CRITICAL(&lock);
+  StepChannel& c = channels[ch];
+  clearSegments(c);
+  c.position = position;
+  c.target = position;
+  c.running = false;
+  c.continuous = false;
+  c.ramp.n = 0;
+  if (c.shift > 0) setShift(c, 0);
+  if (!c.stepHigh) c.nextEvent = EVENT_IDLE;
+  portEXIT_CRITICAL(&lock);
+}
+
+void StepEngine::setLimits(int8_t ch, bool enabled, int32_t min, int32_t max) {
+  if (!validChannel(ch)) return;
+
+  portENTER_CRITICAL(&lock);
+  channels[ch].limitsEnabled = enabled;
+  channels[ch].posMin = min;
+  channels[ch].posMax = max;
+  portEXIT_CRITICAL(&lock);
+}
+
+bool StepEngine::setMicrostepSwitching(int8_t ch, uint8_t maxShift, float switchRate,
+                                       const uint32_t msMask[2],
+                                       const uint32_t msLevels[][2]) {
+  if (!validChannel(ch)) return false;
+  StepChannel& c = channels[ch];
+  if (maxShift > STEP_MICROSTEP_MAX_SHIFT) maxShift = STEP_MICROSTEP_MAX_SHIFT;
+
+  // Back to finer below 3/8 of the switch rate: a switch halves the pulse
+  // rate, so this leaves a margin either way
+  uint32_t upQ8 = 0, downQ8 = 0;
+  if (maxShift > 0) {
+    float rate = constrain(switchRate, 1.0f, STEP_ENGINE_MAX_RATE);
+    upQ8 = MotionPlanner::intervalQ8(c.ramp, rate);
+    downQ8 = MotionPlanner::intervalQ8(c.ramp, rate * 3.0f / 8.0f);
+  }
+
+  portENTER_CRITICAL(&lock);
+  if (c.running || c.stepHigh || c.group >= 0) {
+    portEXIT_CRITICAL(&lock);
+    return false;
+  }
+  c.maxShift = maxShift;
+  c.upIntervalQ8 = upQ8;
+  c.downIntervalQ8 = downQ8;
+  for (uint8_t b = 0; b < 2; b++) {
+    c.msMask[b] = maxShift > 0 ? msMask[b] : 0;
+    for (uint8_t s = 0; s <= STEP_MICROSTEP_MAX_SHIFT; s++) {
+      c.msLevels[s][b] = s <= maxShift ? msLevels[s][b] & c.msMask[b] : 0;
+    }
+  }
+  portEXIT_CRITICAL(&lock);
+  return true;
+}
+
+int32_t StepEngine::getPosition(int8_t ch) {
+  if (!validChannel(ch)) return 0;
+  return channels[ch].position;
+}
+
+int32_t StepEngine::getTarget(int8_t ch) {
+  if (!validChannel(ch)) return 0;
+  return channels[ch].target;
+}
+
+int32_t StepEngine::distanceToGo(int8_t ch) {
+  if (!validChannel(ch)) return 0;
+  if (channels[ch].continuous) return 0;
+  return channels[ch].target - channels[ch].position;
+}
+
+float StepEngine::getSpeed(int8_t ch) {
+  if (!validChannel(ch) || !channels[ch].running) return 0.0f;
+
+  int8_t g = channels[ch].group;
+  if (g >= 0) {
+    // Share of the master axis speed
+    const StepGroup& grp = groups[g];
+    for (uint8_t k = 0; k < grp.count; k++) {
+      if (grp.axis[k] != ch) continue;
+      return channels[ch].direction * MotionPlanner::speed(grp.ramp) * grp.delta[k] / grp.length;
+    }
+    return 0.0f;
+  }
+
+  const StepChannel& c = channels[ch];
+  return c.direction * MotionPlanner::speed(c.ramp) * (1 << c.shift);
+}
+
+bool StepEngine::isRunning(int8_t ch) {
+  if (!validChannel(ch)) return false;
+  return channels[ch].running;
+}
+
+uint8_t StepEngine::queuedMoves(int8_t ch) {
+  if (!validChannel(ch)) return 0;
+  return channels[ch].segCount;
+}
+
+uint8_t StepEngine::getMicrostepShift(int8_t ch) {
+  if (!validChannel(ch)) return 0;
+  return channels[ch].shift;
+}
+
+bool StepEngine::takeLimitHit(int8_t ch) {
+  if (!validChannel(ch) || !channels[ch].limitHit) return false;
+
+  portENTER_CRITICAL(&lock);
+  channels[ch].limitHit = false;
+  portEXIT_CRITICAL(&lock);
+  return true;
+}
+
+void StepEngine::toJson(JsonObject& obj) {
+  obj["initialized"] = timer != nullptr;
+  obj["timerHz"] = STEP_ENGINE_TIMER_HZ;
+  obj["maxRate"] = STEP_ENGINE_MAX_RATE;
+  obj["isrCount"] = isrCount;
+
+  uint8_t active = 0;
+  for (uint8_t i = 0; i < MAX_STEP_CHANNELS; i++) {
+    if (channels[i].attached && channels[i].running) active++;
+  }
+  obj["activeChannels"] = active;
+
+  uint8_t activeGroups = 0;
+  for (uint8_t g = 0; g < MAX_AXIS_GROUPS; g++) {
+    if (groups[g].active) activeGroups++;
+  }
+  obj["activeGroups"] = activeGroups;
+}
+
+// ============================================================================
+// Axis Groups
+// ============================================================================
+
+int8_t StepEngine::moveGroup(const int8_t* chs, const int32_t* targets, uint8_t count,
+                              float maxRate) {
+  if (count == 0 || count > MAX_STEP_CHANNELS) return -1;
+
+  // Deltas and limits are read before taking the lock; the channels must be
+  // idle, which is checked again under the lock together with the positions
+  int32_t start[MAX_STEP_CHANNELS];
+  uint32_t delta[MAX_STEP_CHANNELS];
+  uint32_t length = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    if (!validChannel(chs[i])) return -1;
+    for (uint8_t j = 0; j < i; j++) {
+      if (chs[j] == chs[i]) return -1;
+    }
+    start[i] = channels[chs[i]].position;
+    int64_t d = (int64_t)targets[i] - start[i];
+    delta[i] = (uint32_t)(d >= 0 ? d : -d);
+    if (delta[i] > length) length = delta[i];
+  }
+  if (length == 0 || length > INT32_MAX) return -1;
+
+  // The master axis may go as fast as the most constrained channel allows
+  float maxSpeed = STEP_ENGINE_MAX_RATE;
+  float accel = 1.0e9f;
+  for (uint8_t i = 0; i < count; i++) {
+    if (delta[i] == 0) continue;
+    const MotionRamp& r = channels[chs[i]].ramp;
+    float scale = (float)length / (float)delta[i];
+    float axisSpeed = r.tickHz * 256.0f / (float)r.cminQ8 * scale;
+    if (axisSpeed < maxSpeed) maxSpeed = axisSpeed;
+    if (r.acceleration * scale < accel) accel = r.acceleration * scale;
+  }
+  if (maxRate > 0 && maxRate < maxSpeed) maxSpeed = maxRate;
+
+  MotionRamp ramp;
+  MotionPlanner::init(ramp, STEP_ENGINE_TIMER_HZ, maxSpeed, accel);
+
+  portENTER_CRITICAL(&lock);
+
+  int8_t g = -1;
+  for (uint8_t k = 0; k < MAX_AXIS_GROUPS; k++) {
+    if (!groups[k].active) {
+      g = k;
+      break;
+    }
+  }
+
+  bool busy = g < 0;
+  for (uint8_t i = 0; i < count && !busy; i++) {
+    const StepChannel& c = channels[chs[i]];
+    busy = c.running || c.stepHigh || c.group >= 0 || c.position != start[i];
+  }
+  if (busy) {
+    portEXIT_CRITICAL(&lock);
+    return -1;
+  }
+
+  StepGroup& grp = groups[g];
+  grp.count = count;
+  grp.length = (int32_t)length;
+  grp.done = 0;
+  grp.end = (int32_t)length;
+  grp.mask0 = 0;
+  grp.mask1 = 0;
+  grp.stepHigh = false;
+  grp.ramp = ramp;
+
+  for (uint8_t i = 0; i < count; i++) {
+    StepChannel& c = channels[chs[i]];
+    grp.axis[i] = chs[i];
+    grp.delta[i] = delta[i];
+    grp.error[i] = length / 2;
+
+    c.group = g;
+    c.target = targets[i];
+    c.continuous = false;
+    c.ramp.n = 0;
+    c.running = delta[i] != 0;
+    c.direction = targets[i] >= start[i] ? 1 : -1;
+    c.pendingDir = c.direction;
+    writeDir(c);
+  }
+
+  int8_t startDir = 1;
+  MotionPlanner::next(grp.ramp, grp.end, 1, startDir);
+  grp.running = true;
+  grp.active = true;
+
+  // First rise after the DIR setup time, as for a single channel
+  grp.nextEvent = now() + STEP_ENGINE_LEAD_TICKS;
+  armAlarm(grp.nextEvent);
+
+  portEXIT_CRITICAL(&lock);
+  return g;
+}
+
+void StepEngine::stopGroup(int8_t g) {
+  if (g < 0 || g >= MAX_AXIS_GROUPS) return;
+  StepGroup& grp = groups[g];
+
+  portENTER_CRITICAL(&lock);
+  if (grp.active && grp.running) {
+    int32_t stepsToStop = grp.ramp.n >= 0 ? grp.ramp.n : -grp.ramp.n;
+    if (grp.done + stepsToStop < grp.end) grp.end = grp.done + stepsToStop;
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+void StepEngine::haltGroup(int8_t g) {
+  if (g < 0 || g >= MAX_AXIS_GROUPS) return;
+  StepGroup& grp = groups[g];
+
+  uint8_t stepPins[MAX_STEP_CHANNELS];
+  uint8_t count = 0;
+
+  portENTER_CRITICAL(&lock);
+  if (grp.active) {
+    for (uint8_t k = 0; k < grp.count; k++) {
+      stepPins[count++] = channels[grp.axis[k]].stepPin;
+    }
+    releaseGroup(grp);
+  }
+  portEXIT_CRITICAL(&lock);
+
+  for (uint8_t k = 0; k < count; k++) {
+    digitalWrite(stepPins[k], LOW);
+  }
+}
+
+bool StepEngine::isGroupRunning(int8_t g) {
+  if (g < 0 || g >= MAX_AXIS_GROUPS) return false;
+  return groups[g].active;
+}
+
+// Lock held: hand the axes back as independent, idle channels
+void IRAM_ATTR StepEngine::releaseGroup(StepGroup& grp) {
+  for (uint8_t k = 0; k < grp.count; k++) {
+    StepChannel& c = channels[grp.axis[k]];
+    c.running = false;
+    c.target = c.position;
+    c.ramp.n = 0;
+    c.group = -1;
+  }
+  grp.active = false;
+  grp.running = false;
+  grp.stepHigh = false;
+  grp.nextEvent = EVENT_IDLE;
+}
+
+// ISR, lock held: one master step. Each axis steps when its error
+// overflows. Returns false if a soft limit aborted the move.
+bool IRAM_ATTR StepEngine::riseGroup(StepGroup& grp, uint32_t& set0, uint32_t& set1) {
+  uint32_t length = (uint32_t)grp.length;
+  uint32_t error[MAX_STEP_CHANNELS];
+  uint32_t stepMask = 0;
+
+  // Check every axis before moving any, so a refused step leaves the
+  // axes on the line
+  for (uint8_t k = 0; k < grp.count; k++) {
+    error[k] = grp.error[k] + grp.delta[k];
+    if (error[k] < length) continue;
+    error[k] -= length;
+    stepMask |= 1UL << k;
+
+    StepChannel& c = channels[grp.axis[k]];
+    int32_t nextPos = c.position + c.direction;
+    if (c.limitsEnabled && (nextPos < c.posMin || nextPos > c.posMax)) {
+      c.limitHit = true;
+      releaseGroup(grp);
+      return false;
+    }
+  }
+
+  uint32_t m0 = 0, m1 = 0;
+  for (uint8_t k = 0; k < grp.count; k++) {
+    grp.error[k] = error[k];
+    if (!(stepMask & (1UL << k))) continue;
+
+    StepChannel& c = channels[grp.axis[k]];
+    c.position = c.position + c.direction;
+    if (c.stepPin < 32) m0 |= 1UL << c.stepPin; else m1 |= 1UL << (c.stepPin - 32);
+  }
+
+  grp.mask0 = m0;
+  grp.mask1 = m1;
+  set0 |= m0;
+  set1 |= m1;
+  grp.stepHigh = true;
+  grp.lastRise = grp.nextEvent;
+  grp.done++;
+
+  int8_t startDir = 1;
+  if (!MotionPlanner::next(grp.ramp, grp.end - grp.done, 1, startDir)) {
+    grp.running = false;
+  }
+
+  grp.nextEvent = grp.lastRise + STEP_PULSE_TICKS;
+  return true;
+}
+
+// ============================================================================
+// Internal
+// ============================================================================
+
+bool StepEngine::validChannel(int8_t ch) {
+  return ch >= 0 && ch < MAX_STEP_CHANNELS && channels[ch].attached;
+}
+
+uint64_t StepEngine::now() {
+  uint64_t count = 0;
+  gptimer_get_raw_count(timer, &count);
+  return count;
+}
+
+// Called with the lock held and the channel idle: latch the direction,
+// then fire the first rise shortly after so DIR setup time is met.
+void StepEngine::scheduleStart(StepChannel& c) {
+  c.direction = c.pendingDir;
+  writeDir(c);
+
+  c.nextEvent = now() + STEP_ENGINE_LEAD_TICKS;
+  armAlarm(c.nextEvent);
+}
+
+// Called with the lock held
+void StepEngine::armAlarm(uint64_t when) {
+  if (alarmArmed && when >= alarmAt) return;
+
+  gptimer_alarm_config_t alarm = {};
+  alarm.alarm_count = when;
+  gptimer_set_alarm_action(timer, &alarm);
+  alarmAt = when;
+  alarmArmed = true;
+}
+
+// Runs in the ISR after each step with the lock held, and from task context
+// to start a move or to pre-compute pulse trains for other outputs.
+void IRAM_ATTR StepEngine::advanceRamp(StepChannel& c) {
+  // Reached a junction: carry on to the next queued target at speed
+  while (c.segCount > 0 && c.position == c.target) {
+    c.target = c.segments[c.segHead];
+    c.segHead = (c.segHead + 1) % STEP_LOOKAHEAD_DEPTH;
+    c.segCount--;
+    updateRunway(c);
+  }
+
+  // Aim for the point where the motion really has to stop
+  int32_t distance = c.target - c.position + c.segDir * c.runway;
+
+  // The ramp counts physical steps at the current microstep level. Coarse
+  // steps cannot pass through a target off their grid, so the ramp slows
+  // down for it as for a stop, and carries on at a finer level.
+  if (c.maxShift > 0) {
+    switchMicrosteps(c, distance);
+    int32_t span = 1L << c.shift;
+    int32_t toTarget = c.target - c.position;
+    if ((toTarget & (span - 1)) != 0) distance = toTarget;
+    distance /= span;
+  }
+
+  int8_t startDir = c.pendingDir;
+  if (MotionPlanner::next(c.ramp, distance, c.direction, startDir)) {
+    c.pendingDir = startDir;
+  } else {
+    c.running = false;
+  }
+}
+
+// Lock held (or generator owned by the caller)
+bool StepEngine::appendSegment(StepChannel& c, int32_t target) {
+  if (c.segCount >= STEP_LOOKAHEAD_DEPTH) return false;
+  c.segments[(c.segHead + c.segCount) % STEP_LOOKAHEAD_DEPTH] = target;
+  c.segCount++;
+  updateRunway(c);
+  return true;
+}
+
+void StepEngine::clearSegments(StepChannel& c) {
+  c.segCount = 0;
+  c.segHead = 0;
+  c.segDir = 0;
+  c.runway = 0;
+}
+
+// Lock held: pick the microstep level for the next step. Finer one level
+// at a time as the speed drops, and at once as far as needed when the move
+// is about to end or reach a target off the coarse grid, so whole coarse
+// steps always land on it. Coarser one level at a time while accelerating
+// or cruising, from a position on the coarser grid.
+void IRAM_ATTR StepEngine::switchMicrosteps(StepChannel& c, int32_t distance) {
+  uint32_t remaining = distance >= 0 ? distance : -distance;
+  int32_t toTarget = c.target - c.position;
+  uint32_t toTargetAbs = toTarget >= 0 ? toTarget : -toTarget;
+
+  while (c.shift > 0) {
+    uint32_t span = 1UL << c.shift;
+    uint32_t reach = ((uint32_t)toTarget & (span - 1)) == 0 ? remaining : toTargetAbs;
+    if (c.ramp.n != 0 && reach >= 4 * span) break;
+    setShift(c, c.shift - 1);
+  }
+
+  if (c.shift > 0 && c.ramp.cnQ8 > c.downIntervalQ8) {
+    setShift(c, c.shift - 1);
+    return;
+  }
+
+  if (c.shift < c.maxShift && c.ramp.n >= 2 && c.ramp.cnQ8 < c.upIntervalQ8) {
+    uint32_t span = 2UL << c.shift;
+    uint32_t reach = ((uint32_t)toTarget & (span - 1)) == 0 ? remaining : toTargetAbs;
+    if (((uint32_t)c.position & (span - 1)) == 0 && reach >= 4 * span) {
+      setShift(c, c.shift + 1);
+    }
+  }
+}
+
+// Lock held: change level, rescaling the ramp so the shaft speed holds.
+// The step interval scales with the step size and n (steps to stop)
+// inversely. MS pins are written right away; a switch happens just after
+// a STEP rise, well ahead of the next one.
+void IRAM_ATTR StepEngine::setShift(StepChannel& c, uint8_t shift) {
+  if (shift > c.shift) {
+    uint8_t d = shift - c.shift;
+    c.ramp.cnQ8 = c.ramp.cnQ8 > (UINT32_MAX >> d) ? UINT32_MAX : c.ramp.cnQ8 << d;
+    c.ramp.n /= 1L << d;
+  } else if (shift < c.shift) {
+    uint8_t d = c.shift - shift;
+    c.ramp.cnQ8 >>= d;
+    c.ramp.n *= 1L << d;
+  }
+  c.ramp.rem = 0;
+  c.ramp.c0Q8 = c.shiftC0Q8[shift];
+  c.ramp.cminQ8 = c.shiftCminQ8[shift];
+  c.shift = shift;
+
+  uint32_t set0 = c.msLevels[shift][0], set1 = c.msLevels[shift][1];
+  uint32_t clr0 = c.msMask[0] & ~set0, clr1 = c.msMask[1] & ~set1;
+  if (clr0) GPIO.out_w1tc = clr0;
+  if (clr1) GPIO.out1_w1tc.val = clr1;
+  if (set0) GPIO.out_w1ts = set0;
+  if (set1) GPIO.out1_w1ts.val = set1;
+}
+
+// DIR from the latched direction, by register like the ISR's writes: this
+// runs with the lock held and interrupts masked
+void IRAM_ATTR StepEngine::writeDir(const StepChannel& c) {
+  if (c.dirPin == 255) return;
+
+  bool level = (c.direction > 0) != c.invertDir;
+  uint32_t bit = 1UL << (c.dirPin & 31);
+  if (c.dirPin < 32) {
+    if (level) GPIO.out_w1ts = bit; else GPIO.out_w1tc = bit;
+  } else {
+    if (level) GPIO.out1_w1ts.val = bit; else GPIO.out1_w1tc.val = bit;
+  }
+}
+
+// Junction speed for the current target, as steps of runway: the queued
+// segments that keep going the same way. A reversal or the end of the
+// queue is a full stop.
+void IRAM_ATTR StepEngine::updateRunway(StepChannel& c) {
+  int32_t toTarget = c.target - c.position;
+  c.segDir = toTarget > 0 ? 1 : (toTarget < 0 ? -1 : 0);
+
+  int64_t runway = 0;
+  int32_t prev = c.target;
+  for (uint8_t k = 0; k < c.segCount && c.segDir != 0; k++) {
+    int32_t next = c.segments[(c.segHead + k) % STEP_LOOKAHEAD_DEPTH];
+    int64_t d = (int64_t)next - prev;
+    if (d == 0) continue;
+    if ((d > 0 ? 1 : -1) != c.segDir) break;
+    runway += d > 0 ? d : -d;
+    prev = next;
+  }
+  c.runway = runway > INT32_MAX / 2 ? INT32_MAX / 2 : (int32_t)runway;
+}
+
+bool IRAM_ATTR StepEngine::onAlarm(gptimer_handle_t t, const gptimer_alarm_event_data_t* edata, void* ctx) {
+  portENTER_CRITICAL_ISR(&lock);
+  isrCount++;
+
+  uint64_t current = edata->count_value;
+
+  // Service every event that is due, then re-arm for the earliest pending
+  // one. Loop if that is already within the guard window.
+  for (uint8_t pass = 0; pass < 8; pass++) {
+    uint32_t set0 = 0, clr0 = 0, set1 = 0, clr1 = 0;
+    uint64_t next = EVENT_IDLE;
+
+    for (uint8_t i = 0; i < MAX_STEP_CHANNELS; i++) {
+      StepChannel& c = channels[i];
+      if (!c.attached || c.nextEvent == EVENT_IDLE) continue;
+
+      if (c.nextEvent <= current + STEP_ENGINE_GUARD_TICKS) {
+        uint8_t stepPin = c.stepPin;
+
+        if (c.stepHigh) {
+          // Fall edge: end the pulse, latch any direction change
+          if (stepPin < 32) clr0 |= 1UL << stepPin; else clr1 |= 1UL << (stepPin - 32);
+          c.stepHigh = false;
+
+          if (c.pendingDir != c.direction) {
+            c.direction = c.pendingDir;
+            uint8_t dirPin = c.dirPin;
+            bool level = (c.direction > 0) != c.invertDir;
+            if (dirPin < 32) {
+              if (level) set0 |= 1UL << dirPin; else clr0 |= 1UL << dirPin;
+            } else if (dirPin != 255) {
+              if (level) set1 |= 1UL << (dirPin - 32); else clr1 |= 1UL << (dirPin - 32);
+            }
+          }
+
+          if (c.running) {
+            uint64_t interval = c.ramp.cnQ8 >> 8;
+            if (interval < 2 * STEP_PULSE_TICKS) interval = 2 * STEP_PULSE_TICKS;
+            c.nextEvent = c.lastRise + interval;
+          } else {
+            c.nextEvent = EVENT_IDLE;
+          }
+        } else {
+          // Rise edge: one step in the latched direction, 2^shift
+          // positions at a coarser microstep level
+          int32_t nextPos = c.position + c.direction * (1L << c.shift);
+          if (c.limitsEnabled && (nextPos < c.posMin || nextPos > c.posMax)) {
+            c.running = false;
+            c.continuous = false;
+            c.limitHit = true;
+            c.segCount = 0;
+            c.runway = 0;
+            c.target = c.position;
+            c.ramp.n = 0;
+            c.nextEvent = EVENT_IDLE;
+            if (c.shift > 0) setShift(c, 0);
+            continue;
+          }
+
+          if (stepPin < 32) set0 |= 1UL << stepPin; else set1 |= 1UL << (stepPin - 32);
+          c.position = nextPos;
+          c.stepHigh = true;
+          c.lastRise = c.nextEvent;
+
+          if (!c.continuous) advanceRamp(c);
+          c.nextEvent = c.lastRise + STEP_PULSE_TICKS;
+        }
+      }
+
+      if (c.nextEvent < next) next = c.nextEvent;
+    }
+
+    for (uint8_t g = 0; g < MAX_AXIS_GROUPS; g++) {
+      StepGroup& grp = groups[g];
+      if (!grp.active || grp.nextEvent == EVENT_IDLE) continue;
+
+      if (grp.nextEvent <= current + STEP_ENGINE_GUARD_TICKS) {
+        if (grp.stepHigh) {
+          clr0 |= grp.mask0;
+          clr1 |= grp.mask1;
+          grp.stepHigh = false;
+
+          if (grp.running) {
+            uint64_t interval = grp.ramp.cnQ8 >> 8;
+            if (interval < 2 * STEP_PULSE_TICKS) interval = 2 * STEP_PULSE_TICKS;
+            grp.nextEvent = grp.lastRise + interval;
+          } else {
+            releaseGroup(grp);
+          }
+        } else if (!riseGroup(grp, set0, set1)) {
+          continue;
+        }
+      }
+
+      if (grp.nextEvent < next) next = grp.nextEvent;
+    }
+
+    // One register write per bank for all channels
+    if (clr0) GPIO.out_w1tc = clr0;
+    if (clr1) GPIO.out1_w1tc.val = clr1;
+    if (set0) GPIO.out_w1ts = set0;
+    if (set1) GPIO.out1_w1ts.val = set1;
+
+    if (next == EVENT_IDLE) {
+      alarmArmed = false;
+      break;
+    }
+
+    gptimer_get_raw_count(t, &current);
+    if (next > current + STEP_ENGINE_GUARD_TICKS || pass == 7) {
+      gptimer_alarm_config_t alarm = {};
+      alarm.alarm_count = next;
+      gptimer_set_alarm_action(t, &alarm);
+      alarmAt = next;
+      alarmArmed = true;
+      break;
+    }
+  }
+
+  portEXIT_CRITICAL_ISR(&lock);
+  return false;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <driver/gptimer.h>
+#include "../config.h"
+#include "motion_planner.h"
+
+// ============================================================================
+// Step Engine - Hardware Timer Step Pulse Generation
+// ============================================================================
+// Generates STEP/DIR pulses for all stepper channels from a single gptimer
+// alarm ISR. Every channel schedules its own next edge, so step rates are
+// limited by the pulse width rather than by the motor task tick.
+// Ramp math comes from MotionPlanner (integer Q8 step intervals), so it is
+// safe inside the ISR.
+//
+// Targets can be queued behind the current one. The ramp then treats the
+// same-direction steps queued past the target as runway, so it only slows
+// down for the real stop or a reversal, and passes through each junction at
+// the highest speed it can still stop from.
+//
+// Axis groups drive several channels from one ramp along a straight line:
+// the group steps a virtual master axis as long as the longest move, and
+// each channel steps when its Bresenham error overflows, so all axes start
+// and finish together.
+//
+// Microstep switching (A4988/DRV8825 with MS pins): as a channel speeds up
+// the ISR moves the driver to coarser microsteps, and back to finer ones as
+// it slows down or nears the end of the move. Positions always count the
+// finest microsteps; a coarse STEP pulse moves 2^shift of them and the ramp
+// runs in physical steps, rescaled at each switch so the shaft speed is
+// unchanged. Switches happen only on a coarse step boundary, so the
+// position stays exact. Independent timer moves only: groups and constant
+// speed run at the finest level.
+
+struct StepChannel {
+  uint8_t stepPin;
+  uint8_t dirPin;
+  bool invertDir;
+  bool attached;
+
+  // Motion state (shared with ISR, guarded by the engine spinlock)
+  volatile int32_t position;
+  volatile int32_t target;
+  volatile bool running;       // Motion in progress
+  volatile bool stepHigh;      // STEP pin currently high, fall event pending
+  volatile bool continuous;    // Constant speed mode, target ignored
+  volatile bool limitHit;      // ISR refused a step outside the limits
+  int8_t direction;            // +1 / -1, direction of the last step
+  int8_t pendingDir;           // Direction to latch on the next fall event
+
+  // Ramp state, intervals in engine timer ticks
+  MotionRamp ramp;
+
+  // Scheduling (timer ticks)
+  uint64_t lastRise;
+  uint64_t nextEvent;
+
+  // Soft limits mirrored from the motor slot
+  bool limitsEnabled;
+  int32_t posMin;
+  int32_t posMax;
+
+  int8_t group;                // Axis group driving this channel, -1 when independent
+
+  // Look-ahead targets after the current one (guarded like the motion state)
+  int32_t segments[STEP_LOOKAHEAD_DEPTH];
+  uint8_t segHead;
+  uint8_t segCount;
+  int8_t segDir;               // Direction of the current segment, 0 at rest
+  int32_t runway;              // Queued same-direction steps past the target
+
+  // Microstep switching, 0 = finest level; constants per level are
+  // precomputed so a switch in the ISR is integer copies only
+  uint8_t shift;               // Current level, each step moves 2^shift positions
+  uint8_t maxShift;            // Coarsest level, 0 = fixed microstepping
+  uint32_t upIntervalQ8;       // Coarser when the step interval is shorter
+  uint32_t downIntervalQ8;     // Finer when it is longer
+  uint32_t shiftC0Q8[STEP_MICROSTEP_MAX_SHIFT + 1];
+  uint32_t shiftCminQ8[STEP_MICROSTEP_MAX_SHIFT + 1];
+  uint32_t msMask[2];          // MS pins per GPIO bank
+  uint32_t msLevels[STEP_MICROSTEP_MAX_SHIFT + 1][2];  // MS pin levels per level and bank
+};
+
+struct StepGroup {
+  bool active;                 // Move running or final pulse pending
+  uint8_t count;
+  int8_t axis[MAX_STEP_CHANNELS];
+  uint32_t delta[MAX_STEP_CHANNELS];   // |steps| per axis
+  uint32_t error[MAX_STEP_CHANNELS];   // Bresenham accumulators
+  int32_t length;              // Master steps, the longest |delta|
+  int32_t done;                // Master steps taken
+  int32_t end;                 // Master step to stop at, < length after stop()
+
+  volatile bool running;
+  volatile bool stepHigh;
+  uint32_t mask0, mask1;       // STEP pins raised on the last rise
+  MotionRamp ramp;             // Master axis ramp, engine timer ticks
+  uint64_t lastRise;
+  uint64_t nextEvent;
+};
+
+class StepEngine {
+public:
+  // === Initialization ===
+  static bool init();
+  static bool isInitialized() { return timer != nullptr; }
+
+  // === Channel Management ===
+  static int8_t attach(uint8_t stepPin, uint8_t dirPin, bool invertDir = false);
+  static void detach(int8_t ch);
+
+  // === Motion Control ===
+  static void moveTo(int8_t ch, int32_t target);           // Replaces any queued targets
+  static bool queueMove(int8_t ch, int32_t target);        // false if the look-ahead is full
+  static void runSpeed(int8_t ch, float stepsPerSecond);  // Signed, no ramp
+  static void stop(int8_t ch);                            // Decelerate to stop
+  static void halt(int8_t ch);                            // Immediate stop
+
+  // === Configuration ===
+  static void setMaxSpeed(int8_t ch, float stepsPerSecond);
+  static void setAcceleration(int8_t ch, float stepsPerSecondSquared);
+  static void setPosition(int8_t ch, int32_t position);
+  static void setLimits(int8_t ch, bool enabled, int32_t min, int32_t max);
+  // Switch up to maxShift levels coarser above switchRate physical steps/s,
+  // back below 3/8 of it. msLevels[s] holds the MS pin levels (per bank,
+  // within msMask) for level s; level 0 must match the pins as set now.
+  // maxShift 0 turns switching off. The channel must be idle.
+  static bool setMicrostepSwitching(int8_t ch, uint8_t maxShift, float switchRate,
+                                    const uint32_t msMask[2],
+                                    const uint32_t msLevels[][2]);
+
+  // === Status ===
+  static int32_t getPosition(int8_t ch);
+  static int32_t getTarget(int8_t ch);
+  static int32_t distanceToGo(int8_t ch);
+  static float getSpeed(int8_t ch);  // Signed steps/second
+  static bool isRunning(int8_t ch);
+  static bool takeLimitHit(int8_t ch);  // Returns and clears the limit flag
+  static uint8_t queuedMoves(int8_t ch);
+  static uint8_t getMicrostepShift(int8_t ch);  // Current level, 0 = finest
+
+  // === Axis Groups ===
+  // Channels must be attached and idle. Speed and acceleration are the
+  // highest the master axis can run without any channel exceeding its own
+  // limits, further capped by maxRate (master steps/s, 0 for none).
+  // Returns the group id, or -1 if no group is free or an axis is busy.
+  static int8_t moveGroup(const int8_t* chs, const int32_t* targets, uint8_t count,
+                          float maxRate = 0);
+  static void stopGroup(int8_t g);   // Decelerate along the line
+  static void haltGroup(int8_t g);   // Immediate stop
+  static bool isGroupRunning(int8_t g);
+
+  static void toJson(JsonObject& obj);
+
+  // === Ramp Step (shared with other step outputs) ===
+  static void IRAM_ATTR advanceRamp(StepChannel& c);
+  static bool appendSegment(StepChannel& c, int32_t target);
+  static void clearSegments(StepChannel& c);
+
+private:
+  static StepChannel channels[MAX_STEP_CHANNELS];
+  static StepGroup groups[MAX_AXIS_GROUPS];
+  static gptimer_handle_t timer;
+  static portMUX_TYPE lock;
+  static volatile bool alarmArmed;
+  static volatile uint64_t alarmAt;
+  static volatile uint32_t isrCount;
+
+  static bool validChannel(int8_t ch);
+  static void scheduleStart(StepChannel& c);
+  static void armAlarm(uint64_t when);
+  static uint64_t now();
+  static void IRAM_ATTR updateRunway(StepChannel& c);
+  static void IRAM_ATTR switchMicrosteps(StepChannel& c, int32_t distance);
+  static void IRAM_ATTR setShift(StepChannel& c, uint8_t shift);
+  static void IRAM_ATTR writeDir(const StepChannel& c);
+  static void releaseGroup(StepGroup& g);
+  static bool IRAM_ATTR riseGroup(StepGroup& g, uint32_t& set0, uint32_t& set1);
+
+  static bool IRAM_ATTR onAlarm(gptimer_handle_t t, const gptimer_alarm_event_data_t* edata, void* ctx);
+};
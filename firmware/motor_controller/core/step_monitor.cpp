@@ -0,0 +1,105 @@
+#include "step_monitor.h"
+
+// Static member initialization
+StepMonitorConfig StepMonitor::configs[MAX_MOTORS] = {};
+StepMonitor::State StepMonitor::states[MAX_MOTORS] = {};
+
+bool StepMonitor::configure(uint8_t slot, const StepMonitorConfig& config) {
+  if (slot >= MAX_MOTORS) return false;
+  if (config.enabled && (config.stepsPerCount <= 0 || config.threshold <= 0)) return false;
+
+  configs[slot] = config;
+  states[slot] = {};
+  states[slot].alignPending = true;
+
+  if (config.enabled) {
+    Serial.printf("[MONITOR] Slot %d step monitor on: %.3f steps/count, threshold %ld%s\n",
+                  slot, config.stepsPerCount, (long)config.threshold, config.resync ? ", resync" : "");
+  } else {
+    Serial.printf("[MONITOR] Slot %d step monitor off\n", slot);
+  }
+  return true;
+}
+
+void StepMonitor::requestAlign(uint8_t slot) {
+  if (slot >= MAX_MOTORS) return;
+  states[slot].alignPending = true;
+}
+
+bool StepMonitor::isEnabled(uint8_t slot) {
+  return slot < MAX_MOTORS && configs[slot].enabled;
+}
+
+bool StepMonitor::resyncEnabled(uint8_t slot) {
+  return slot < MAX_MOTORS && configs[slot].resync;
+}
+
+bool StepMonitor::check(uint8_t slot, int32_t stepPosition, int64_t encoderCount, int32_t& encoderSteps,
+                        int32_t inFlight) {
+  State& st = states[slot];
+  if (st.alignPending) {
+    align(slot, stepPosition, encoderCount);
+    encoderSteps = stepPosition;
+    return false;
+  }
+
+  int64_t steps = toSteps(slot, encoderCount) + st.offset;
+  encoderSteps = (int32_t)narrow(steps);
+
+  // The hardware is somewhere between stepPosition and the end of the block
+  // in flight; only a distance outside that span is following error
+  int64_t low = inFlight < 0 ? (int64_t)stepPosition + inFlight : stepPosition;
+  int64_t high = inFlight > 0 ? (int64_t)stepPosition + inFlight : stepPosition;
+  st.error = (int32_t)narrow(steps < low ? low - steps : steps > high ? high - steps : 0);
+
+  int32_t magnitude = abs(st.error);
+  if (magnitude > st.peakError) st.peakError = magnitude;
+
+  // Stay latched until the axis is back on track (e.g. re-homed)
+  if (st.tripped) {
+    if (magnitude <= configs[slot].threshold / 2) st.tripped = false;
+    return false;
+  }
+  if (magnitude <= configs[slot].threshold) return false;
+
+  st.tripped = true;
+  st.trips++;
+  return true;
+}
+
+void StepMonitor::align(uint8_t slot, int32_t stepPosition, int64_t encoderCount) {
+  State& st = states[slot];
+  st.offset = stepPosition - toSteps(slot, encoderCount);
+  st.error = 0;
+  st.tripped = false;
+  st.alignPending = false;
+}
+
+// In double: a float product is off by whole steps past 2^24
+int64_t StepMonitor::toSteps(uint8_t slot, int64_t encoderCount) {
+  return llround((double)encoderCount * configs[slot].stepsPerCount);
+}
+
+// Saturates to int32; only a lost axis is that far off
+int64_t StepMonitor::narrow(int64_t v) {
+  return v > INT32_MAX ? INT32_MAX : (v < -INT32_MAX ? -INT32_MAX : v);
+}
+
+void StepMonitor::capture(uint8_t slot, MotorStatus& s) {
+  if (!isEnabled(slot)) return;
+  s.followingError = states[slot].error;
+  s.peakFollowingError = states[slot].peakError;
+  s.stepLossTrips = states[slot].trips;
+}
+
+void StepMonitor::toJson(uint8_t slot, JsonObject& obj, const MotorStatus& s) {
+  if (!isEnabled(slot)) return;
+
+  JsonObject mon = obj.createNestedObject("stepMonitor");
+  mon["stepsPerCount"] = configs[slot].stepsPerCount;
+  mon["threshold"] = configs[slot].threshold;
+  mon["resync"] = configs[slot].resync;
+  mon["followingError"] = s.followingError;
+  mon["peakError"] = s.peakFollowingError;
+  mon["trips"] = s.stepLossTrips;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+#include "motor_status.h"
+
+// ============================================================================
+// Step Monitor - Encoder-Verified Step Loss Detection
+// ============================================================================
+// For a stepper slot with a linked encoder, compares the step counter with
+// the encoder count scaled to steps on every motor task tick. The offset
+// between the two is captured when the monitor is enabled (or the encoder
+// is reattached), so the encoder need not be zeroed at the same place.
+//
+// Once the following error exceeds the threshold the manager stops the slot
+// and raises a safety fault; with resync it also sets the step counter to
+// the position the encoder reports, so the next move goes where it should.
+
+struct StepMonitorConfig {
+  bool enabled;
+  double stepsPerCount;  // Motor steps per encoder count; double keeps long travel exact
+  int32_t threshold;     // Trip when |following error| exceeds this, steps
+  bool resync;           // Correct the step counter after a trip
+};
+
+class StepMonitor {
+public:
+  // === Configuration (mutex held) ===
+  static bool configure(uint8_t slot, const StepMonitorConfig& config);
+  static void requestAlign(uint8_t slot);  // Any task; re-captures the offset next tick
+  static bool isEnabled(uint8_t slot);
+  static bool resyncEnabled(uint8_t slot);
+
+  // === Motor Task (mutex held) ===
+  // Returns true on the tick the error first passes the threshold;
+  // encoderSteps is the encoder position in steps. inFlight is the signed
+  // number of steps being clocked out past stepPosition (RMT block), any of
+  // which the encoder may already have seen. encoderCount is the 64-bit
+  // count, so a wrap of the 32-bit hardware count is not a jump.
+  static bool check(uint8_t slot, int32_t stepPosition, int64_t encoderCount, int32_t& encoderSteps,
+                    int32_t inFlight = 0);
+  static void align(uint8_t slot, int32_t stepPosition, int64_t encoderCount);
+  static void capture(uint8_t slot, MotorStatus& s);
+
+  // === Status ===
+  static void toJson(uint8_t slot, JsonObject& obj, const MotorStatus& s);
+
+private:
+  struct State {
+    int64_t offset;          // Steps minus scaled encoder count when aligned
+    int32_t error;           // Latest following error, steps
+    int32_t peakError;       // Largest |error| since the monitor was enabled
+    uint16_t trips;
+    bool tripped;            // Latched until the error recovers or realigns
+    volatile bool alignPending;
+  };
+
+  static StepMonitorConfig configs[MAX_MOTORS];
+  static State states[MAX_MOTORS];
+
+  static int64_t toSteps(uint8_t slot, int64_t encoderCount);
+  static int64_t narrow(int64_t v);
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// ============================================================================
+// Velocity Observer - Encoder Speed at the Motor Task Rate
+// ============================================================================
+// Differencing counts over a fixed window gives a speed that is quantised
+// to one count per window and lags by half of it. Instead, each sample:
+//
+// - An alpha-beta (critically damped, second order) tracking observer
+//   predicts the position from its velocity and corrects both with the
+//   residual against the count. The bandwidth sets the trade-off between
+//   lag and noise; dt comes from microsecond timestamps, so a late tick
+//   does not read as a speed change.
+// - Below periodSpeed, where counts arrive less than once per sample, the
+//   speed is measured from the time between count changes instead (over
+//   at least periodWindowUs). Between changes the estimate decays as
+//   1 / elapsed, and it reads zero after stopUs without a count.
+//
+// The observer keeps count - estimate rather than the estimate itself, so
+// float precision does not depend on how far the encoder has turned.
+// Header-only. scripts/check_kernels.sh feeds it synthetic counts on the host.
+
+struct VelocityObserverState {
+  float residual;        // Count minus estimated position, counts
+  float velocity;        // Observer velocity, counts/s
+  float periodVelocity;  // From the time between count changes, counts/s
+  float output;          // Reported velocity, counts/s
+  int32_t lastCount;
+  int32_t edgeCount;     // Count at the start of the period measurement
+  uint32_t edgeUs;
+  uint32_t lastUs;
+  bool lowSpeed;         // Output is the period measurement
+};
+
+struct VelocityObserverConfig {
+  float bandwidthHz;
+  float periodSpeed;       // Counts/s below which the period measurement is used
+  uint32_t periodWindowUs; // Shortest span of one period measurement
+  uint32_t stopUs;         // No count for this long reads as stopped
+  uint32_t maxGapUs;       // Samples further apart than this restart the observer
+};
+
+class VelocityObserver {
+public:
+  static void reset(VelocityObserverState& s, int32_t count, uint32_t nowUs) {
+    s = {};
+    s.lastCount = count;
+    s.edgeCount = count;
+    s.edgeUs = nowUs;
+    s.lastUs = nowUs;
+    s.lowSpeed = true;
+  }
+
+  static float update(VelocityObserverState& s, const VelocityObserverConfig& c, int32_t count, uint32_t nowUs) {
+    uint32_t elapsedUs = nowUs - s.lastUs;
+    if (elapsedUs == 0) return s.output;
+    if (elapsedUs > c.maxGapUs) {
+      reset(s, count, nowUs);
+      return 0.0f;
+    }
+
+    trackObserver(s, c, count, elapsedUs * 1e-6f);
+    trackPeriod(s, c, count, nowUs);
+    s.lastCount = count;
+    s.lastUs = nowUs;
+
+    // Hysteresis so the output does not chatter at the crossover
+    float speed = fabsf(s.velocity);
+    if (s.lowSpeed && speed > c.periodSpeed * 1.25f) s.lowSpeed = false;
+    else if (!s.lowSpeed && speed < c.periodSpeed) s.lowSpeed = true;
+
+    s.output = s.lowSpeed ? s.periodVelocity : s.velocity;
+    return s.output;
+  }
+
+private:
+  // Difference of two 32-bit counts, correct across a wrap
+  static int32_t countDelta(int32_t a, int32_t b) {
+    return (int32_t)((uint32_t)a - (uint32_t)b);
+  }
+
+  static void trackObserver(VelocityObserverState& s, const VelocityObserverConfig& c, int32_t count, float dt) {
+    const float omega = 2.0f * (float)M_PI * c.bandwidthHz;
+    float alpha = 2.0f * omega * dt;
+    if (alpha > 1.0f) alpha = 1.0f;
+    float beta = omega * omega * dt;
+
+    // Predict, then correct with the new residual
+    float r = s.residual + (float)countDelta(count, s.lastCount) - s.velocity * dt;
+    s.residual = r * (1.0f - alpha);
+    s.velocity += beta * r;
+  }
+
+  static void trackPeriod(VelocityObserverState& s, const VelocityObserverConfig& c, int32_t count, uint32_t nowUs) {
+    uint32_t sinceEdge = nowUs - s.edgeUs;
+
+    if (count != s.lastCount && sinceEdge >= c.periodWindowUs) {
+      s.periodVelocity = (float)countDelta(count, s.edgeCount) * 1e6f / (float)sinceEdge;
+      s.edgeCount = count;
+      s.edgeUs = nowUs;
+      return;
+    }
+    if (count != s.edgeCount) return;  // Window still open
+
+    // No count since the last measurement: the speed is at most one count
+    // over the time waited so far
+    if (sinceEdge >= c.stopUs) {
+      s.periodVelocity = 0.0f;
+      s.edgeUs = nowUs - c.stopUs;  // Keep the span bounded while stopped
+      return;
+    }
+    float bound = 1e6f / (float)(sinceEdge > 0 ? sinceEdge : 1);
+    if (s.periodVelocity > bound) s.periodVelocity = bound;
+    if (s.periodVelocity < -bound) s.periodVelocity = -bound;
+  }
+};
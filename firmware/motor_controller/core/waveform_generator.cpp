@@ -0,0 +1,97 @@
+#include "waveform_generator.h"
+
+// Static member initialization
+WaveformGenerator::State WaveformGenerator::states[MAX_MOTORS] = {};
+
+namespace {
+  constexpr float WAVEFORM_TICK_HZ = 1000.0f / MOTOR_TASK_INTERVAL_MS;
+
+  const char* shapeName(WaveShape shape) {
+    switch (shape) {
+      case WaveShape::TRIANGLE: return "triangle";
+      case WaveShape::SQUARE: return "square";
+      default: return "sine";
+    }
+  }
+}
+
+bool WaveformGenerator::start(uint8_t slot, const WaveformConfig& config, int32_t scale,
+                              int32_t position) {
+  if (slot >= MAX_MOTORS || scale <= 0) return false;
+  if (!(config.frequency > 0 && config.frequency <= WAVEFORM_MAX_HZ)) return false;
+  if (!(fabsf(config.amplitude) * scale <= WAVEFORM_MAX_AMPLITUDE)) return false;
+  if (!isnan(config.offset) && !(fabsf(config.offset) * scale <= WAVEFORM_MAX_AMPLITUDE)) return false;
+
+  State& s = states[slot];
+  uint32_t increment = DdsOscillator::incrementFor(config.frequency, WAVEFORM_TICK_HZ);
+
+  // Lock to a running slot at the same frequency, or carry on from our own
+  // phase if we are only being retuned
+  if (!s.running) s.osc.phase = 0;
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    if (i != slot && states[i].running && states[i].osc.increment == increment) {
+      s.osc.phase = states[i].osc.phase;
+      break;
+    }
+  }
+
+  s.osc.increment = increment;
+  s.osc.phaseOffset = DdsOscillator::phaseFromDegrees(config.phase);
+  s.osc.shape = config.shape;
+  s.osc.amplitude = lroundf(config.amplitude * scale);
+  if (!isnan(config.offset)) {
+    s.osc.offset = lroundf(config.offset * scale);
+  } else if (!s.running) {
+    s.osc.offset = position;
+  }
+  s.scale = scale;
+
+  if (!s.running) {
+    s.running = true;
+    s.last = INT32_MIN;  // First sample always applies
+  }
+
+  Serial.printf("[WAVE] Slot %d %s at %.3f Hz\n", slot, shapeName(config.shape), config.frequency);
+  return true;
+}
+
+void WaveformGenerator::stop(uint8_t slot) {
+  if (slot >= MAX_MOTORS || !states[slot].running) return;
+  states[slot].running = false;
+  Serial.printf("[WAVE] Slot %d stopped\n", slot);
+}
+
+void WaveformGenerator::stopAll() {
+  for (uint8_t i = 0; i < MAX_MOTORS; i++) {
+    states[i].running = false;
+  }
+}
+
+bool WaveformGenerator::isRunning(uint8_t slot) {
+  return slot < MAX_MOTORS && states[slot].running;
+}
+
+bool WaveformGenerator::sample(uint8_t slot, int32_t& out) {
+  State& s = states[slot];
+  if (!s.running) return false;
+
+  int32_t next = s.osc.sample();
+  if (next == s.last) return false;
+
+  s.last = next;
+  out = next;
+  return true;
+}
+
+void WaveformGenerator::toJson(uint8_t slot, JsonObject& obj) {
+  if (!isRunning(slot)) return;
+
+  const State& s = states[slot];
+  JsonObject wave = obj.createNestedObject("waveform");
+  wave["shape"] = shapeName(s.osc.shape);
+  wave["frequency"] = DdsOscillator::frequencyOf(s.osc.increment, WAVEFORM_TICK_HZ);
+  wave["amplitude"] = (float)s.osc.amplitude / s.scale;
+  wave["offset"] = (float)s.osc.offset / s.scale;
+  wave["phase"] = (float)s.osc.phaseOffset * (360.0f / 4294967296.0f);
+  wave["setpoint"] = (float)s.last / s.scale;
+}
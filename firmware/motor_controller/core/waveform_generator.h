@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "../config.h"
+#include "dds_oscillator.h"
+
+// ============================================================================
+// Waveform Generator - Oscillating Slot Setpoints
+// ============================================================================
+// Drives a slot's position (steppers, DC with a linked encoder) or angle
+// (servos) from a DdsOscillator advanced once per motor task tick, so the
+// motion is continuous across cycles instead of stepping through preset
+// points. Units are steps, encoder counts or degrees.
+//
+// Slots running at the same frequency share phase: a slot started or
+// retuned to the frequency of another running slot takes over that slot's
+// accumulator, so their phase offsets hold exactly. Changing the frequency
+// of a running slot keeps its phase continuous.
+//
+// Any command addressed to the slot, a stop, an e-stop or engaging a
+// follower stops it.
+
+struct WaveformConfig {
+  WaveShape shape;
+  float frequency;  // Hz, up to WAVEFORM_MAX_HZ
+  float amplitude;  // Peak, slot units
+  float offset;     // Centre, slot units; NAN keeps the running centre or
+                    // starts from the slot's position
+  float phase;      // Degrees
+};
+
+class WaveformGenerator {
+public:
+  // === Control (MotorManager mutex held) ===
+  // `scale` converts slot units to setpoint units (100 for servo
+  // centidegrees); `position` is the slot's setpoint now. False if the
+  // config is out of range.
+  static bool start(uint8_t slot, const WaveformConfig& config, int32_t scale, int32_t position);
+  static void stop(uint8_t slot);
+  static void stopAll();
+  static bool isRunning(uint8_t slot);
+
+  // === Motor Task (mutex held) ===
+  // Setpoint for this tick in setpoint units; false if the slot is not
+  // running a waveform or the setpoint has not changed
+  static bool sample(uint8_t slot, int32_t& out);
+
+  // === Status ===
+  static void toJson(uint8_t slot, JsonObject& obj);
+
+private:
+  struct State {
+    bool running;
+    int32_t scale;
+    int32_t last;
+    DdsOscillator osc;
+  };
+
+  static State states[MAX_MOTORS];
+};
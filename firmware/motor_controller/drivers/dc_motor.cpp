@@ -1,93 +1,149 @@
 #include "dc_motor.h"
-
-// Static counter for PWM channels
-static uint8_t nextPwmChannel = 0;
-
-DCMotor::DCMotor(uint8_t slot, DCDriverType driver, uint8_t pA, uint8_t pB, uint8_t pEn)
-  : MotorBase(slot), driverType(driver), pinA(pA), pinB(pB), pinEn(pEn) {
-  pwmChannel = nextPwmChannel++;
-  if (nextPwmChannel > 15) nextPwmChannel = 0; // Wrap around
+#include "../core/ledc_allocator.h"
+#include "../core/gpio_batch.h"
+
+DCMotor::DCMotor(uint8_t slot, DCDriverType driver, uint8_t pA, uint8_t pB, uint8_t pEn,
+                 uint32_t frequency, uint8_t resolution)
+  : MotorBase(slot), driverType(driver), pinA(pA), pinB(pB), pinEn(pEn),
+    pwmFrequency(frequency), pwmResolution(resolution),
+    maxDuty(LedcAllocator::maxDuty(resolution)) {
+  setPidGains(kp, ki, kd, kff);
+  setRampLimits(rampAccel, rampDecel, rampJerk);
+  setRpmRampLimits(rpmAccel, rpmDecel, rpmJerk);
 }
 
 DCMotor::~DCMotor() {
   emergencyStop();
+
+  // Hand the channels back so the slot can be reconfigured
+  if (!pwmAttached) return;
+  if (driverType == DCDriverType::L298N) {
+    LedcAllocator::detach(pinEn);
+  } else {
+    LedcAllocator::detach(pinA);
+    LedcAllocator::detach(pinB);
+  }
 }
 
 void DCMotor::init() {
   if (driverType == DCDriverType::L298N) {
     // L298N: IN1, IN2 are digital, EN is PWM
-    pinMode(pinA, OUTPUT);
-    pinMode(pinB, OUTPUT);
-    digitalWrite(pinA, LOW);
-    digitalWrite(pinB, LOW);
+    GpioBatch::configureOutput(pinA, false);
+    GpioBatch::configureOutput(pinB, false);
+  }
 
-    if (pinEn != 255) {
-      // Use new Arduino-ESP32 3.x API
-      ledcAttach(pinEn, PWM_FREQUENCY, PWM_RESOLUTION);
-    }
-  } else {
-    // L9110S: Both pins are PWM (no separate enable)
-    ledcAttach(pinA, PWM_FREQUENCY, PWM_RESOLUTION);
-    ledcAttach(pinB, PWM_FREQUENCY, PWM_RESOLUTION);
+  if (!attachPwm()) {
+    enabled = false;
+    Serial.printf("[MOTOR] DC Motor slot %d has no PWM channel\n", slotId);
+    return;
   }
 
   enabled = true;
   currentSpeed = 0;
   targetSpeed = 0;
   brakeMode = false;
+  SlewRateLimiter::reset(dutySlew, 0.0f);
+  lastUpdateUs = micros();
 
-  Serial.printf("[MOTOR] DC Motor slot %d initialized (%s)\n",
-                slotId, driverType == DCDriverType::L298N ? "L298N" : "L9110S");
+  Serial.printf("[MOTOR] DC Motor slot %d initialized (%s, %lu Hz, %d bits)\n",
+                slotId, driverType == DCDriverType::L298N ? "L298N" : "L9110S",
+                (unsigned long)pwmFrequency, pwmResolution);
+}
+
+bool DCMotor::attachPwm() {
+  if (driverType == DCDriverType::L298N) {
+    // L298N: EN is PWM; without it IN1/IN2 switch full speed
+    if (pinEn == 255) return true;
+    pwmAttached = LedcAllocator::attach(pinEn, pwmFrequency, pwmResolution, slotId) >= 0;
+    return pwmAttached;
+  }
+
+  // L9110S: Both pins are PWM (no separate enable)
+  if (LedcAllocator::attach(pinA, pwmFrequency, pwmResolution, slotId) < 0) return false;
+  if (LedcAllocator::attach(pinB, pwmFrequency, pwmResolution, slotId) < 0) {
+    LedcAllocator::detach(pinA);
+    return false;
+  }
+  pwmAttached = true;
+  return true;
+}
+
+void DCMotor::writeDuty(uint8_t pin, uint32_t duty) {
+  if (pwmAttached) {
+    GpioBatch::writeDuty(pin, duty);
+  }
 }
 
 void DCMotor::update() {
   if (!enabled) return;
 
-  // Ramp speed towards target
-  if (currentSpeed < targetSpeed) {
-    currentSpeed = min(currentSpeed + rampRate, (int)targetSpeed);
-  } else if (currentSpeed > targetSpeed) {
-    currentSpeed = max(currentSpeed - rampRate, (int)targetSpeed);
+  // Ramps advance by the time actually elapsed, so a late tick catches up
+  // instead of stretching the ramp
+  uint32_t now = micros();
+  uint32_t elapsedUs = min(now - lastUpdateUs, DC_SLEW_MAX_GAP_US);
+  lastUpdateUs = now;
+
+  // The closed loop sets the duty directly; a duty ramp would only add lag
+  if (mode != DCControlMode::OPEN_LOOP) {
+    loopElapsedUs += elapsedUs;
+    if (++pidTicks >= DC_PID_INTERVAL_MS / MOTOR_TASK_INTERVAL_MS) {
+      pidTicks = 0;
+      runClosedLoop(loopElapsedUs / 1000000.0f);
+      loopElapsedUs = 0;
+    }
+    applySpeed();
+    return;
   }
 
+  // Start from the present duty if something else set it (brake, coast,
+  // emergency stop, leaving closed loop)
+  if (lroundf(dutySlew.value) != currentSpeed) {
+    SlewRateLimiter::reset(dutySlew, (float)currentSpeed);
+  }
+  currentSpeed = lroundf(SlewRateLimiter::step(dutySlew, (float)targetSpeed, elapsedUs / 1000000.0f));
+
   applySpeed();
 }
 
 void DCMotor::stop() {
+  mode = DCControlMode::OPEN_LOOP;
   targetSpeed = 0;
   // Let update() ramp down gradually
 }
 
 void DCMotor::emergencyStop() {
+  mode = DCControlMode::OPEN_LOOP;
   targetSpeed = 0;
   currentSpeed = 0;
   brakeMode = false;
 
   if (driverType == DCDriverType::L298N) {
-    digitalWrite(pinA, LOW);
-    digitalWrite(pinB, LOW);
+    GpioBatch::write(pinA, false);
+    GpioBatch::write(pinB, false);
     if (pinEn != 255) {
-      ledcWrite(pinEn, 0);
+      writeDuty(pinEn, 0);
     }
   } else {
-    ledcWrite(pinA, 0);
-    ledcWrite(pinB, 0);
+    writeDuty(pinA, 0);
+    writeDuty(pinB, 0);
   }
 }
 
-void DCMotor::setSpeed(int16_t speed) {
+void DCMotor::setSpeed(int32_t speed) {
+  mode = DCControlMode::OPEN_LOOP;
   brakeMode = false;
-  targetSpeed = constrain(speed, -255, 255);
+  targetSpeed = constrain(speed, -maxDuty, maxDuty);
 
   // Apply minimum speed threshold (dead band)
   if (abs(targetSpeed) < minSpeed && targetSpeed != 0) {
-    targetSpeed = (targetSpeed > 0) ? minSpeed : -minSpeed;
+    targetSpeed = (targetSpeed > 0) ? (int32_t)minSpeed : -(int32_t)minSpeed;
   }
 }
 
 void DCMotor::setDirection(bool forward) {
+  mode = DCControlMode::OPEN_LOOP;
   if (targetSpeed == 0) {
-    targetSpeed = forward ? 128 : -128; // Default medium speed
+    targetSpeed = forward ? (maxDuty + 1) / 2 : -(maxDuty + 1) / 2; // Default medium speed
   } else {
     targetSpeed = forward ? abs(targetSpeed) : -abs(targetSpeed);
   }
@@ -95,6 +151,7 @@ void DCMotor::setDirection(bool forward) {
 }
 
 void DCMotor::brake() {
+  mode = DCControlMode::OPEN_LOOP;
   brakeMode = true;
   targetSpeed = 0;
   currentSpeed = 0;
@@ -102,37 +159,149 @@ void DCMotor::brake() {
   // Active brake: both sides HIGH or both LOW depending on driver
   if (driverType == DCDriverType::L298N) {
     // L298N: IN1=IN2=HIGH for brake
-    digitalWrite(pinA, HIGH);
-    digitalWrite(pinB, HIGH);
+    GpioBatch::write(pinA, true);
+    GpioBatch::write(pinB, true);
     if (pinEn != 255) {
-      ledcWrite(pinEn, 255);
+      writeDuty(pinEn, maxDuty);
     }
   } else {
     // L9110S: Both LOW for brake
-    ledcWrite(pinA, 0);
-    ledcWrite(pinB, 0);
+    writeDuty(pinA, 0);
+    writeDuty(pinB, 0);
   }
 }
 
 void DCMotor::coast() {
+  mode = DCControlMode::OPEN_LOOP;
   brakeMode = false;
   targetSpeed = 0;
   currentSpeed = 0;
 
   // Coast: disable all outputs
   if (driverType == DCDriverType::L298N) {
-    digitalWrite(pinA, LOW);
-    digitalWrite(pinB, LOW);
+    GpioBatch::write(pinA, false);
+    GpioBatch::write(pinB, false);
     if (pinEn != 255) {
-      ledcWrite(pinEn, 0);
+      writeDuty(pinEn, 0);
     }
   } else {
-    ledcWrite(pinA, 0);
-    ledcWrite(pinB, 0);
+    writeDuty(pinA, 0);
+    writeDuty(pinB, 0);
   }
 }
 
+void DCMotor::setTargetRpm(float rpm) {
+  enterClosedLoop(DCControlMode::SPEED);
+  targetRpm = rpm;
+}
+
+void DCMotor::moveTo(int64_t position) {
+  if (mode != DCControlMode::POSITION) {
+    enterClosedLoop(DCControlMode::POSITION);
+    profileOrigin = encoderCount;
+    SetpointGenerator::start(profile, 0.0f, encoderVelocity);
+  } else {
+    // Move the origin to the reference so long runs keep float precision
+    int32_t shift = lroundf(profile.position);
+    profileOrigin += shift;
+    profile.position -= shift;
+  }
+  targetPosition = clampToLimits(position);
+  SetpointGenerator::setTarget(profile, (float)(targetPosition - profileOrigin));
+}
+
+void DCMotor::moveRelative(int32_t counts) {
+  int64_t base = mode == DCControlMode::POSITION ? targetPosition : encoderCount;
+  moveTo(base + counts);
+}
+
+void DCMotor::setPidGains(float newKp, float newKi, float newKd, float newKff) {
+  kp = newKp;
+  ki = newKi;
+  kd = newKd;
+  kff = newKff;
+  // Gains are in 8-bit duty; the output is duty at this slot's resolution
+  float dutyScale = maxDuty / 255.0f;
+  PidController::setGains(pid, kp * dutyScale, ki * dutyScale, kd * dutyScale, kff * dutyScale,
+                          DC_PID_INTERVAL_MS / 1000.0f);
+}
+
+void DCMotor::setPositionLoop(float newKpPos, float maxSpeed, float acceleration) {
+  kpPos = newKpPos;
+  positionSpeed = maxSpeed > 0 ? maxSpeed : DC_POSITION_DEFAULT_SPEED;
+  positionAccel = acceleration > 0 ? acceleration : DC_POSITION_DEFAULT_ACCEL;
+  profile.maxSpeed = positionSpeed;
+  profile.acceleration = positionAccel;
+}
+
+void DCMotor::setRampLimits(float acceleration, float deceleration, float jerk) {
+  rampAccel = max(acceleration, 0.0f);
+  rampDecel = max(deceleration, 0.0f);
+  rampJerk = max(jerk, 0.0f);
+  // Limits are in 8-bit duty; the ramp runs in duty at this slot's resolution
+  float dutyScale = maxDuty / 255.0f;
+  dutySlew.acceleration = rampAccel * dutyScale;
+  dutySlew.deceleration = rampDecel * dutyScale;
+  dutySlew.jerk = rampJerk * dutyScale;
+}
+
+void DCMotor::setRpmRampLimits(float acceleration, float deceleration, float jerk) {
+  rpmAccel = max(acceleration, 0.0f);
+  rpmDecel = max(deceleration, 0.0f);
+  rpmJerk = max(jerk, 0.0f);
+  rpmSlew.acceleration = rpmAccel;
+  rpmSlew.deceleration = rpmDecel;
+  rpmSlew.jerk = rpmJerk;
+}
+
+void DCMotor::setEncoderFeedback(int64_t count, float countsPerSecond, int32_t pulsesPerRev) {
+  encoderCount = count;
+  encoderVelocity = countsPerSecond;
+  encoderPpr = pulsesPerRev;
+}
+
+void DCMotor::enterClosedLoop(DCControlMode newMode) {
+  if (mode == DCControlMode::OPEN_LOOP) {
+    // Start the integrator at the present duty so the switch does not jump
+    PidController::reset(pid, maxDuty, currentSpeed);
+    pidTicks = 0;
+    loopElapsedUs = 0;
+    SlewRateLimiter::reset(dutySlew, (float)currentSpeed);
+  }
+  if (newMode == DCControlMode::SPEED && mode != DCControlMode::SPEED) {
+    // Ramp the RPM setpoint from the speed the motor is turning at
+    SlewRateLimiter::reset(rpmSlew, encoderPpr > 0 ? encoderVelocity * 60.0f / encoderPpr : 0.0f);
+  }
+  profile.maxSpeed = positionSpeed;
+  profile.acceleration = positionAccel;
+  brakeMode = false;
+  mode = newMode;
+}
+
+// Every DC_PID_INTERVAL_MS: the position loop (if any) turns the reference
+// into a speed setpoint, and the speed PID turns that into duty
+void DCMotor::runClosedLoop(float elapsed) {
+  const float dt = DC_PID_INTERVAL_MS / 1000.0f;
+  measuredRpm = encoderPpr > 0 ? encoderVelocity * 60.0f / encoderPpr : 0.0f;
+
+  float setpoint;
+  if (mode == DCControlMode::POSITION) {
+    SetpointGenerator::step(profile, dt);
+    setpoint = profile.velocity + kpPos * (profile.position - (float)(encoderCount - profileOrigin));
+    setpoint = constrain(setpoint, -2.0f * positionSpeed, 2.0f * positionSpeed);
+  } else {
+    setpoint = SlewRateLimiter::step(rpmSlew, targetRpm, elapsed) * encoderPpr / 60.0f;
+  }
+
+  int32_t duty = PidController::update(pid, lroundf(setpoint), lroundf(encoderVelocity));
+  targetSpeed = duty;
+  currentSpeed = duty;
+}
+
 bool DCMotor::isMoving() const {
+  if (mode == DCControlMode::POSITION) {
+    return !profile.done || llabs(targetPosition - encoderCount) > DC_POSITION_TOLERANCE;
+  }
   return currentSpeed != 0;
 }
 
@@ -148,16 +317,58 @@ const char* DCMotor::getTypeName() const {
   return driverType == DCDriverType::L298N ? "DC (L298N)" : "DC (L9110S)";
 }
 
-void DCMotor::toJson(JsonObject& obj) const {
-  MotorBase::toJson(obj);
+void DCMotor::captureStatus(MotorStatus& s) const {
+  MotorBase::captureStatus(s);
+  s.target = targetSpeed;
+  s.braking = brakeMode;
+  s.closedLoop = mode != DCControlMode::OPEN_LOOP;
+  s.positionMode = mode == DCControlMode::POSITION;
+  s.targetPosition = targetPosition;
+  s.encoderPosition = encoderCount;
+  s.targetRpm = targetRpm;
+  s.rampRpm = rpmSlew.value;
+  s.rpm = measuredRpm;
+  s.pidIntegral = PidController::integralOutput(pid);
+}
+
+void DCMotor::toJson(JsonObject& obj, const MotorStatus& s) const {
+  MotorBase::toJson(obj, s);
   obj["driverType"] = driverType == DCDriverType::L298N ? "L298N" : "L9110S";
-  obj["targetSpeed"] = targetSpeed;
-  obj["currentSpeed"] = currentSpeed;
-  obj["braking"] = brakeMode;
-  obj["direction"] = currentSpeed >= 0 ? "forward" : "reverse";
+  obj["targetSpeed"] = s.target;
+  obj["currentSpeed"] = (int32_t)s.speed;
+  obj["braking"] = s.braking;
+  obj["direction"] = s.speed >= 0 ? "forward" : "reverse";
   obj["pinA"] = pinA;
   obj["pinB"] = pinB;
   obj["pinEn"] = pinEn;
+  obj["pwmFrequency"] = pwmFrequency;
+  obj["pwmResolution"] = pwmResolution;
+  obj["maxDuty"] = maxDuty;
+
+  JsonObject rampObj = obj.createNestedObject("ramp");
+  rampObj["acceleration"] = rampAccel;
+  rampObj["deceleration"] = rampDecel;
+  rampObj["jerk"] = rampJerk;
+  rampObj["rpmAcceleration"] = rpmAccel;
+  rampObj["rpmDeceleration"] = rpmDecel;
+  rampObj["rpmJerk"] = rpmJerk;
+
+  JsonObject pidObj = obj.createNestedObject("pid");
+  pidObj["closedLoop"] = s.closedLoop;
+  pidObj["targetRpm"] = s.targetRpm;
+  pidObj["rampRpm"] = s.rampRpm;
+  pidObj["rpm"] = s.rpm;
+  pidObj["integral"] = s.pidIntegral;
+  pidObj["kp"] = kp;
+  pidObj["ki"] = ki;
+  pidObj["kd"] = kd;
+  pidObj["kff"] = kff;
+  pidObj["positionMode"] = s.positionMode;
+  pidObj["targetPosition"] = s.targetPosition;
+  pidObj["encoderPosition"] = s.encoderPosition;
+  pidObj["kpPos"] = kpPos;
+  pidObj["maxSpeed"] = positionSpeed;
+  pidObj["acceleration"] = positionAccel;
 }
 
 void DCMotor::applySpeed() {
@@ -171,41 +382,41 @@ void DCMotor::applySpeed() {
 }
 
 void DCMotor::applyL298N() {
-  uint8_t duty = abs(currentSpeed);
+  uint32_t duty = abs(currentSpeed);
 
   if (currentSpeed > 0) {
     // Forward
-    digitalWrite(pinA, HIGH);
-    digitalWrite(pinB, LOW);
+    GpioBatch::write(pinA, true);
+    GpioBatch::write(pinB, false);
   } else if (currentSpeed < 0) {
     // Reverse
-    digitalWrite(pinA, LOW);
-    digitalWrite(pinB, HIGH);
+    GpioBatch::write(pinA, false);
+    GpioBatch::write(pinB, true);
   } else {
     // Stop
-    digitalWrite(pinA, LOW);
-    digitalWrite(pinB, LOW);
+    GpioBatch::write(pinA, false);
+    GpioBatch::write(pinB, false);
   }
 
   if (pinEn != 255) {
-    ledcWrite(pinEn, duty);
+    writeDuty(pinEn, duty);
   }
 }
 
 void DCMotor::applyL9110S() {
-  uint8_t duty = abs(currentSpeed);
+  uint32_t duty = abs(currentSpeed);
 
   if (currentSpeed > 0) {
     // Forward: pinA = PWM, pinB = 0
-    ledcWrite(pinA, duty);
-    ledcWrite(pinB, 0);
+    writeDuty(pinA, duty);
+    writeDuty(pinB, 0);
   } else if (currentSpeed < 0) {
     // Reverse: pinA = 0, pinB = PWM
-    ledcWrite(pinA, 0);
-    ledcWrite(pinB, duty);
+    writeDuty(pinA, 0);
+    writeDuty(pinB, duty);
   } else {
     // Stop
-    ledcWrite(pinA, 0);
-    ledcWrite(pinB, 0);
+    writeDuty(pinA, 0);
+    writeDuty(pinB, 0);
   }
 }
@@ -1,19 +1,37 @@
 #pragma once
 
 #include "motor_base.h"
+#include "../core/pid_controller.h"
+#include "../core/setpoint_profile.h"
+#include "../core/slew_limiter.h"
 
 // ============================================================================
 // DC Motor Driver - L298N and L9110S H-Bridge Support
 // ============================================================================
+// Speed is signed duty at the slot's PWM resolution, so the range is
+// +-(2^bits - 1): +-255 at the default 8 bits, +-1023 at 10 bits. PID gains
+// and the ramp limits stay in 8-bit duty and are scaled to the resolution,
+// so a tuning carries over when the resolution changes.
+//
+// Open-loop speed changes are slew limited against elapsed time (duty/s),
+// and closed-loop RPM setpoints optionally the same way (RPM/s), so spin-up
+// takes as long whatever the motor task's timing.
 
 enum class DCDriverType : uint8_t {
   L298N,   // IN1, IN2 for direction, EN for PWM speed
   L9110S   // IA (PWM), IB (PWM) - both pins are PWM capable
 };
 
-class DCMotor : public MotorBase {
+enum class DCControlMode : uint8_t {
+  OPEN_LOOP,  // Duty ramped towards setSpeed()
+  SPEED,      // Encoder PID holds an RPM
+  POSITION    // Trapezoid reference, position loop over the speed PID
+};
+
+class DCMotor final : public MotorBase {
 public:
-  DCMotor(uint8_t slot, DCDriverType driver, uint8_t pinA, uint8_t pinB, uint8_t pinEn = 255);
+  DCMotor(uint8_t slot, DCDriverType driver, uint8_t pinA, uint8_t pinB, uint8_t pinEn = 255,
+          uint32_t pwmFrequency = PWM_FREQUENCY, uint8_t pwmResolution = PWM_RESOLUTION);
   ~DCMotor() override;
 
   // === Core Control ===
@@ -23,16 +41,35 @@ public:
   void emergencyStop() override;
 
   // === DC Motor Specific Control ===
-  void setSpeed(int16_t speed);     // -255 to +255 (negative = reverse)
+  void setSpeed(int32_t speed);     // -maxDuty to +maxDuty (negative = reverse)
   void setDirection(bool forward);
   void brake();                      // Active braking
   void coast();                      // Free spinning (no power)
 
+  // === Closed Loop (linked encoder) ===
+  // Any open-loop command (speed, stop, brake, coast) leaves closed loop.
+  // Positions are extended (64-bit) encoder counts.
+  void setTargetRpm(float rpm);
+  void moveTo(int64_t position);
+  void moveRelative(int32_t counts);
+  void setPidGains(float kp, float ki, float kd, float kff);
+  void setPositionLoop(float kpPos, float maxSpeed, float acceleration);
+  // Open loop in 8-bit duty/s (and duty/s^2), closed-loop speed in RPM/s
+  // (and RPM/s^2); zero leaves that limit off
+  void setRampLimits(float acceleration, float deceleration, float jerk);
+  void setRpmRampLimits(float acceleration, float deceleration, float jerk);
+  void setEncoderFeedback(int64_t count, float countsPerSecond, int32_t pulsesPerRev);  // Motor task, before update()
+  bool isClosedLoop() const { return mode != DCControlMode::OPEN_LOOP; }
+  DCControlMode getControlMode() const { return mode; }
+
   // === Status ===
   bool isMoving() const override;
   float getSpeed() const override;
   float getTargetSpeed() const override { return static_cast<float>(targetSpeed); }
-  int16_t getRawSpeed() const { return currentSpeed; }
+  int32_t getPosition() const override { return (int32_t)encoderCount; }  // Low 32 bits
+  int64_t getEncoderPosition() const { return encoderCount; }
+  int32_t getRawSpeed() const { return currentSpeed; }
+  int32_t getMaxDuty() const { return maxDuty; }
   bool isReversed() const { return currentSpeed < 0; }
   bool isBraking() const { return brakeMode; }
 
@@ -41,26 +78,68 @@ public:
   const char* getTypeName() const override;
 
   // === JSON ===
-  void toJson(JsonObject& obj) const override;
+  void captureStatus(MotorStatus& s) const override;
+  void toJson(JsonObject& obj, const MotorStatus& s) const override;
 
   // === Configuration ===
-  void setRampRate(uint8_t rate) { rampRate = rate; }  // Speed change per update
-  void setMinSpeed(uint8_t min) { minSpeed = min; }    // Dead band threshold
+  void setMinSpeed(uint16_t min) { minSpeed = min; }   // Dead band threshold, duty
   DCDriverType getDriverType() const { return driverType; }
 
 private:
   DCDriverType driverType;
   uint8_t pinA, pinB, pinEn;
 
-  int16_t currentSpeed = 0;   // Current actual speed
-  int16_t targetSpeed = 0;    // Target speed
+  int32_t currentSpeed = 0;   // Current actual speed
+  int32_t targetSpeed = 0;    // Target speed
   bool brakeMode = false;
 
-  uint8_t rampRate = 10;      // Speed change per update cycle
-  uint8_t minSpeed = 0;       // Minimum speed threshold
+  uint16_t minSpeed = 0;      // Minimum speed threshold
+
+  // Slew limits, in the units set (8-bit duty/s, RPM/s)
+  float rampAccel = DC_DEFAULT_ACCELERATION;
+  float rampDecel = DC_DEFAULT_DECELERATION;
+  float rampJerk = DC_DEFAULT_JERK;
+  float rpmAccel = DC_DEFAULT_RPM_ACCELERATION;
+  float rpmDecel = DC_DEFAULT_RPM_DECELERATION;
+  float rpmJerk = DC_DEFAULT_RPM_JERK;
+  SlewLimiter dutySlew = {};   // Scaled to this slot's duty
+  SlewLimiter rpmSlew = {};
+  uint32_t lastUpdateUs = 0;
+  uint32_t loopElapsedUs = 0;  // Since the last closed-loop sample
+
+  // PWM output, channels from LedcAllocator
+  uint32_t pwmFrequency;
+  uint8_t pwmResolution;
+  int32_t maxDuty;            // Full speed, 2^resolution - 1
+  bool pwmAttached = false;
+
+  // Closed loop
+  DCControlMode mode = DCControlMode::OPEN_LOOP;
+  float targetRpm = 0;
+  float measuredRpm = 0;
+  float kp = DC_PID_DEFAULT_KP;
+  float ki = DC_PID_DEFAULT_KI;
+  float kd = DC_PID_DEFAULT_KD;
+  float kff = DC_PID_DEFAULT_KFF;
+  float kpPos = DC_POSITION_DEFAULT_KP;
+  float positionSpeed = DC_POSITION_DEFAULT_SPEED;
+  float positionAccel = DC_POSITION_DEFAULT_ACCEL;
+  int64_t targetPosition = 0;
+  int64_t profileOrigin = 0;   // Encoder count at profile position 0, keeps the float small
+  SetpointProfile profile = {};
+  PidState pid = {};
+  uint8_t pidTicks = 0;
+
+  // Linked encoder, refreshed every tick
+  int64_t encoderCount = 0;
+  float encoderVelocity = 0;   // counts/s
+  int32_t encoderPpr = 0;
 
-  uint8_t pwmChannel = 0;     // LEDC channel
+  void enterClosedLoop(DCControlMode newMode);
+  void runClosedLoop(float elapsed);
 
+  bool attachPwm();
+  void writeDuty(uint8_t pin, uint32_t duty);
   void applySpeed();
   void applyL298N();
   void applyL9110S();
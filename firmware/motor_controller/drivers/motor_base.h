@@ -3,12 +3,15 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "../config.h"
+#include "../core/motor_status.h"
 
 // ============================================================================
 // Abstract Base Class for All Motor Types
 // ============================================================================
 // All motor drivers inherit from this class, providing a uniform interface
 // for the MotorManager to control any motor type polymorphically.
+// Concrete drivers are final so the manager's per-tick dispatch over its
+// slot variant calls them directly.
 
 class MotorBase {
 public:
@@ -37,16 +40,29 @@ public:
   virtual MotorType getType() const = 0;
   virtual const char* getTypeName() const = 0;
 
+  // === Status Snapshot ===
+  // Motor task only: copy the dynamic state published to status readers
+  virtual void captureStatus(MotorStatus& s) const {
+    s.type = getType();
+    s.enabled = enabled;
+    s.moving = isMoving();
+    s.position = getPosition();
+    s.speed = getSpeed();
+    memcpy(s.error, errorMessage, sizeof(s.error));
+  }
+
   // === JSON Serialization ===
-  virtual void toJson(JsonObject& obj) const {
+  // Configuration comes from the driver, everything that moves from the
+  // snapshot, so this is safe to call outside the motor task
+  virtual void toJson(JsonObject& obj, const MotorStatus& s) const {
     obj["slot"] = slotId;
     obj["type"] = static_cast<uint8_t>(getType());
     obj["typeName"] = getTypeName();
-    obj["enabled"] = enabled;
-    obj["moving"] = isMoving();
-    obj["position"] = getPosition();
-    obj["speed"] = getSpeed();
-    obj["error"] = errorMessage;
+    obj["enabled"] = s.enabled;
+    obj["moving"] = s.moving;
+    obj["position"] = s.position;
+    obj["speed"] = s.speed;
+    obj["error"] = s.error;
   }
 
   // === Safety Limits ===
@@ -69,16 +85,17 @@ public:
   void setCurrentLimit(float amps) { currentLimit = amps; }
   float getCurrentLimit() const { return currentLimit; }
 
-  // Check if position is within limits
-  bool isWithinLimits(int32_t position) const {
+  // Check if position is within limits (64-bit for extended encoder counts)
+  bool isWithinLimits(int64_t position) const {
     if (!limitsEnabled) return true;
     return position >= posMin && position <= posMax;
   }
 
-  // Clamp position to limits
-  int32_t clampToLimits(int32_t position) const {
+  // Clamp position to limits, in the caller's width
+  template <typename T>
+  T clampToLimits(T position) const {
     if (!limitsEnabled) return position;
-    return constrain(position, posMin, posMax);
+    return constrain(position, static_cast<T>(posMin), static_cast<T>(posMax));
   }
 
   // === Error Handling ===
@@ -1,4 +1,6 @@
 #include "servo_motor.h"
+#include "../core/ledc_allocator.h"
+#include "../core/gpio_batch.h"
 
 ServoMotor::ServoMotor(uint8_t slot, uint8_t p, uint16_t minP, uint16_t maxP)
   : MotorBase(slot), pin(p), minPulse(minP), maxPulse(maxP) {
@@ -9,9 +11,14 @@ ServoMotor::~ServoMotor() {
 }
 
 void ServoMotor::init() {
-  // ESP32Servo library handles timer allocation
-  servo.attach(pin, minPulse, maxPulse);
-  servo.write(90);  // Center position
+  channel = LedcAllocator::attach(pin, SERVO_FREQUENCY, SERVO_RESOLUTION, slotId);
+  if (channel < 0) {
+    enabled = false;
+    Serial.printf("[MOTOR] Servo slot %d has no PWM channel\n", slotId);
+    return;
+  }
+
+  writeAngle(90);  // Center position
   currentAngle = 90;
   targetAngle = 90;
   enabled = true;
@@ -20,11 +27,11 @@ void ServoMotor::init() {
 }
 
 void ServoMotor::update() {
-  if (!enabled || !servo.attached()) return;
+  if (!enabled || !isAttached()) return;
 
   if (smoothMode) {
     currentAngle = calculateSmoothAngle();
-    servo.write(currentAngle);
+    writeAngle(currentAngle);
 
     // Check if movement complete
     if (currentAngle == targetAngle) {
@@ -57,8 +64,8 @@ void ServoMotor::setAngle(uint8_t angle) {
   currentAngle = angle;
   targetAngle = angle;
 
-  if (servo.attached()) {
-    servo.write(angle);
+  if (isAttached()) {
+    writeAngle(angle);
   }
 }
 
@@ -86,8 +93,8 @@ void ServoMotor::setAngleSmooth(uint8_t angle, uint16_t durationMs) {
 void ServoMotor::setPulseWidth(uint16_t microseconds) {
   microseconds = constrain(microseconds, minPulse, maxPulse);
 
-  if (servo.attached()) {
-    servo.writeMicroseconds(microseconds);
+  if (isAttached()) {
+    writePulse(microseconds);
   }
 
   // Update angle estimate
@@ -96,18 +103,37 @@ void ServoMotor::setPulseWidth(uint16_t microseconds) {
   smoothMode = false;
 }
 
+void ServoMotor::setAngleCentidegrees(int32_t centidegrees) {
+  centidegrees = constrain(centidegrees, 0, 18000);
+
+  // Check position limits if enabled
+  if (limitsEnabled) {
+    centidegrees = constrain(centidegrees, posMin * 100, posMax * 100);
+  }
+
+  if (isAttached()) {
+    writePulse(minPulse + (int32_t)(maxPulse - minPulse) * centidegrees / 18000);
+  }
+
+  currentAngle = (centidegrees + 50) / 100;
+  targetAngle = currentAngle;
+  smoothMode = false;
+}
+
 void ServoMotor::detach() {
-  if (servo.attached()) {
-    servo.detach();
+  if (isAttached()) {
+    LedcAllocator::detach(pin);
+    channel = -1;
     enabled = false;
     Serial.printf("[MOTOR] Servo slot %d detached\n", slotId);
   }
 }
 
 void ServoMotor::attach() {
-  if (!servo.attached()) {
-    servo.attach(pin, minPulse, maxPulse);
-    servo.write(currentAngle);
+  if (!isAttached()) {
+    channel = LedcAllocator::attach(pin, SERVO_FREQUENCY, SERVO_RESOLUTION, slotId);
+    if (channel < 0) return;
+    writeAngle(currentAngle);
     enabled = true;
     Serial.printf("[MOTOR] Servo slot %d attached\n", slotId);
   }
@@ -125,15 +151,23 @@ float ServoMotor::getSpeed() const {
   return (float)angleDiff * 1000.0f / (float)sweepDuration;
 }
 
-void ServoMotor::toJson(JsonObject& obj) const {
-  MotorBase::toJson(obj);
-  obj["currentAngle"] = currentAngle;
-  obj["targetAngle"] = targetAngle;
+void ServoMotor::captureStatus(MotorStatus& s) const {
+  MotorBase::captureStatus(s);
+  s.target = targetAngle;
+  s.attached = isAttached();
+  s.smoothMode = smoothMode;
+}
+
+void ServoMotor::toJson(JsonObject& obj, const MotorStatus& s) const {
+  MotorBase::toJson(obj, s);
+  obj["currentAngle"] = s.position;
+  obj["targetAngle"] = s.target;
   obj["minPulse"] = minPulse;
   obj["maxPulse"] = maxPulse;
-  obj["attached"] = servo.attached();
-  obj["smoothMode"] = smoothMode;
+  obj["attached"] = s.attached;
+  obj["smoothMode"] = s.smoothMode;
   obj["pin"] = pin;
+  obj["channel"] = channel;
 }
 
 uint8_t ServoMotor::calculateSmoothAngle() {
@@ -152,3 +186,15 @@ uint8_t ServoMotor::calculateSmoothAngle() {
 
   return sweepStartAngle + (int)(angleDiff * progress);
 }
+
+// Pulse width to duty at SERVO_FREQUENCY: duty = us * 2^bits * Hz / 1e6
+void ServoMotor::writePulse(uint32_t microseconds) {
+  uint32_t duty = ((uint64_t)microseconds * (LedcAllocator::maxDuty(SERVO_RESOLUTION) + 1) * SERVO_FREQUENCY
+                   + 500000) / 1000000;
+  GpioBatch::writeDuty(pin, duty);
+}
+
+// 0-180 degrees across minPulse..maxPulse
+void ServoMotor::writeAngle(uint8_t angle) {
+  writePulse(minPulse + (uint32_t)(maxPulse - minPulse) * angle / 180);
+}
@@ -1,13 +1,15 @@
 #pragma once
 
 #include "motor_base.h"
-#include <ESP32Servo.h>
 
 // ============================================================================
 // Servo Motor Driver - Standard PWM Servo Control
 // ============================================================================
+// Drives the pulse directly from an LEDC channel (SERVO_FREQUENCY at
+// SERVO_RESOLUTION bits, from LedcAllocator), so servo and DC outputs share
+// one channel map.
 
-class ServoMotor : public MotorBase {
+class ServoMotor final : public MotorBase {
 public:
   ServoMotor(uint8_t slot, uint8_t pin, uint16_t minPulse = SERVO_MIN_PULSE,
              uint16_t maxPulse = SERVO_MAX_PULSE);
@@ -23,6 +25,7 @@ public:
   void setAngle(uint8_t angle);                           // 0-180 degrees, instant
   void setAngleSmooth(uint8_t angle, uint16_t durationMs); // Smooth transition
   void setPulseWidth(uint16_t microseconds);              // Direct pulse control
+  void setAngleCentidegrees(int32_t centidegrees);        // 0-18000, pulse-width resolution
   void detach();                                          // Release servo
   void attach();                                          // Re-attach servo
 
@@ -32,14 +35,15 @@ public:
   float getSpeed() const override;
   uint8_t getCurrentAngle() const { return currentAngle; }
   uint8_t getTargetAngle() const { return targetAngle; }
-  bool isAttached() { return servo.attached(); }
+  bool isAttached() const { return channel >= 0; }
 
   // === Type Info ===
   MotorType getType() const override { return MotorType::SERVO; }
   const char* getTypeName() const override { return "Servo"; }
 
   // === JSON ===
-  void toJson(JsonObject& obj) const override;
+  void captureStatus(MotorStatus& s) const override;
+  void toJson(JsonObject& obj, const MotorStatus& s) const override;
 
   // === Configuration ===
   void setMinPulse(uint16_t us) { minPulse = us; }
@@ -47,8 +51,8 @@ public:
   void setSpeed(uint8_t degreesPerSecond) { sweepSpeed = degreesPerSecond; }
 
 private:
-  mutable Servo servo;
   uint8_t pin;
+  int8_t channel = -1;   // LEDC channel while attached
   uint16_t minPulse, maxPulse;
 
   uint8_t currentAngle = 90;
@@ -62,4 +66,6 @@ private:
   uint8_t sweepSpeed = 90;  // degrees per second for default smooth movement
 
   uint8_t calculateSmoothAngle();
+  void writePulse(uint32_t microseconds);
+  void writeAngle(uint8_t angle);
 };
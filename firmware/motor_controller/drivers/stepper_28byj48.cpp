@@ -1,88 +1,132 @@
 #include "stepper_28byj48.h"
+#include "../core/gpio_batch.h"
+#include "../core/ledc_allocator.h"
+
+// Coil sequences per CoilStepMode, bit i drives IN(i+1). Full and wave
+// repeat their four phases, so every mode is indexed by position & 7.
+static const uint8_t COIL_SEQUENCES[3][8] = {
+  { 0b0001, 0b0011, 0b0010, 0b0110, 0b0100, 0b1100, 0b1000, 0b1001 },  // HALF
+  { 0b0011, 0b0110, 0b1100, 0b1001, 0b0011, 0b0110, 0b1100, 0b1001 },  // FULL
+  { 0b0001, 0b0010, 0b0100, 0b1000, 0b0001, 0b0010, 0b0100, 0b1000 }   // WAVE
+};
+
+static const char* coilModeName(CoilStepMode mode) {
+  switch (mode) {
+    case CoilStepMode::FULL: return "full";
+    case CoilStepMode::WAVE: return "wave";
+    default: return "half";
+  }
+}
+
+static const char* coilStateName(CoilState state) {
+  switch (state) {
+    case CoilState::ENERGIZED: return "energized";
+    case CoilState::HOLDING: return "holding";
+    default: return "released";
+  }
+}
 
 Stepper28BYJ48::Stepper28BYJ48(uint8_t slot, uint8_t in1, uint8_t in2, uint8_t in3, uint8_t in4)
-  : MotorBase(slot),
-    // HALF4WIRE mode for half-stepping (smoother motion)
-    // Pin order: IN1, IN3, IN2, IN4 for correct sequencing
-    stepper(AccelStepper::HALF4WIRE, in1, in3, in2, in4) {
+  : MotorBase(slot) {
   pins[0] = in1;
   pins[1] = in2;
   pins[2] = in3;
   pins[3] = in4;
+  buildPhaseTable();
+  MotionPlanner::init(ramp, 1000000, rpmToStepsPerSecond(maxSpeedRPM), acceleration);
 }
 
 Stepper28BYJ48::~Stepper28BYJ48() {
   emergencyStop();
-  // Set all pins LOW to release motor
-  for (int i = 0; i < 4; i++) {
-    digitalWrite(pins[i], LOW);
-  }
 }
 
 void Stepper28BYJ48::init() {
-  // AccelStepper handles pin modes
+  for (int i = 0; i < 4; i++) {
+    GpioBatch::configureOutput(pins[i], false);
+  }
+  coilState = CoilState::RELEASED;
+  holdPins = 0;
 
   // Set reasonable defaults for 28BYJ-48
   setSpeed(maxSpeedRPM);
-  stepper.setAcceleration(acceleration);
-  stepper.setCurrentPosition(0);
+  setAcceleration(acceleration);
+  setCurrentPosition(0);
 
   enabled = true;
 
-  Serial.printf("[MOTOR] 28BYJ-48 slot %d initialized (pins %d,%d,%d,%d)\n",
-                slotId, pins[0], pins[1], pins[2], pins[3]);
+  Serial.printf("[MOTOR] 28BYJ-48 slot %d initialized (pins %d,%d,%d,%d, %s step)\n",
+                slotId, pins[0], pins[1], pins[2], pins[3], coilModeName(coilMode));
 }
 
 void Stepper28BYJ48::update() {
   if (!enabled) return;
 
-  // Check position limits before stepping
-  if (limitsEnabled && stepper.distanceToGo() != 0) {
-    int32_t nextPos = stepper.currentPosition();
-    if (stepper.distanceToGo() > 0) nextPos++;
-    else if (stepper.distanceToGo() < 0) nextPos--;
-
-    if (!isWithinLimits(nextPos)) {
-      stepper.stop();
-      setError("Position limit reached");
-      return;
+  if (!running) {
+    // Let the coils cool once the motor has stood still long enough
+    if (coilState != CoilState::RELEASED && idleReleaseMs > 0 &&
+        millis() - idleSinceMs >= idleReleaseMs) {
+      releaseCoils();
     }
+    return;
   }
 
-  stepper.run();
+  uint32_t now = micros();
+  uint32_t interval = ramp.cnQ8 >> 8;
+  if (now - lastStepUs < interval) return;
+
+  // Check position limits before stepping
+  int32_t nextPos = position + direction;
+  if (!isWithinLimits(nextPos)) {
+    halt();
+    enterIdle();
+    setError("Position limit reached");
+    return;
+  }
+
+  position = nextPos;
+  writeCoils(position & 7);
+
+  // Keep steps on their schedule unless the task fell a whole step behind
+  uint32_t due = lastStepUs + interval;
+  lastStepUs = (now - due < interval) ? due : now;
+
+  int8_t startDir = direction;
+  if (MotionPlanner::next(ramp, target - position, direction, startDir)) {
+    direction = startDir;
+  } else {
+    running = false;
+    enterIdle();
+  }
 }
 
 void Stepper28BYJ48::stop() {
-  stepper.stop();  // Decelerates to stop
+  // Decelerate to stop
+  if (!running) return;
+  int32_t stepsToStop = ramp.n >= 0 ? ramp.n : -ramp.n;
+  target = position + direction * stepsToStop;
 }
 
 void Stepper28BYJ48::emergencyStop() {
-  stepper.setCurrentPosition(stepper.currentPosition());
-  stepper.stop();
+  halt();
 
   // De-energize all coils to prevent heating
-  for (int i = 0; i < 4; i++) {
-    digitalWrite(pins[i], LOW);
-  }
+  releaseCoils();
 }
 
-void Stepper28BYJ48::moveTo(int32_t position) {
+void Stepper28BYJ48::moveTo(int32_t targetPos) {
   if (limitsEnabled) {
-    position = clampToLimits(position);
+    targetPos = clampToLimits(targetPos);
   }
-  stepper.moveTo(position);
+  target = targetPos;
+  if (!running) startMove();
 }
 
 void Stepper28BYJ48::moveRelative(int32_t steps) {
-  int32_t target = stepper.currentPosition() + steps;
-  if (limitsEnabled) {
-    target = clampToLimits(target);
-  }
-  stepper.moveTo(target);
+  moveTo(position + steps);
 }
 
 void Stepper28BYJ48::moveRevolutions(float revs) {
-  int32_t steps = (int32_t)(revs * STEPS_PER_REV);
+  int32_t steps = (int32_t)(revs * stepsPerRev);
   moveRelative(steps);
 }
 
@@ -90,71 +134,202 @@ void Stepper28BYJ48::setSpeed(float rpm) {
   // Clamp to reasonable range for 28BYJ-48
   maxSpeedRPM = constrain(rpm, 0.1f, MAX_28BYJ_SPEED);
   float stepsPerSec = rpmToStepsPerSecond(maxSpeedRPM);
-  stepper.setMaxSpeed(stepsPerSec);
+  MotionPlanner::setMaxSpeed(ramp, stepsPerSec);
 }
 
 void Stepper28BYJ48::setSpeedSteps(float stepsPerSecond) {
   float maxStepsPerSec = rpmToStepsPerSecond(MAX_28BYJ_SPEED);
   stepsPerSecond = constrain(stepsPerSecond, 0.0f, maxStepsPerSec);
-  stepper.setMaxSpeed(stepsPerSecond);
+  MotionPlanner::setMaxSpeed(ramp, stepsPerSecond);
   maxSpeedRPM = stepsPerSecondToRPM(stepsPerSecond);
 }
 
 void Stepper28BYJ48::setAcceleration(float stepsPerSecondSquared) {
   acceleration = stepsPerSecondSquared;
-  stepper.setAcceleration(acceleration);
+  MotionPlanner::setAcceleration(ramp, acceleration);
 }
 
 void Stepper28BYJ48::setCurrentPosition(int32_t position) {
-  stepper.setCurrentPosition(position);
+  halt();
+  enterIdle();
+  this->position = position;
+  target = position;
 }
 
 bool Stepper28BYJ48::isMoving() const {
-  return stepper.isRunning();
+  return running;
 }
 
 int32_t Stepper28BYJ48::getPosition() const {
-  return stepper.currentPosition();
+  return position;
 }
 
 float Stepper28BYJ48::getSpeed() const {
-  return stepper.speed();
+  if (!running) return 0.0f;
+  return direction * MotionPlanner::speed(ramp);
 }
 
 float Stepper28BYJ48::getSpeedRPM() const {
-  return stepsPerSecondToRPM(stepper.speed());
+  return stepsPerSecondToRPM(getSpeed());
 }
 
 int32_t Stepper28BYJ48::distanceToGo() const {
-  return stepper.distanceToGo();
+  return target - position;
 }
 
 int32_t Stepper28BYJ48::getTargetPosition() const {
-  return stepper.targetPosition();
+  return target;
 }
 
 float Stepper28BYJ48::getRevolutions() const {
-  return (float)stepper.currentPosition() / (float)STEPS_PER_REV;
-}
-
-void Stepper28BYJ48::toJson(JsonObject& obj) const {
-  MotorBase::toJson(obj);
-  obj["targetPosition"] = stepper.targetPosition();
-  obj["distanceToGo"] = stepper.distanceToGo();
-  obj["speedRPM"] = maxSpeedRPM;
-  obj["currentSpeedRPM"] = getSpeedRPM();
-  obj["acceleration"] = acceleration;
-  obj["stepsPerRev"] = STEPS_PER_REV;
-  obj["revolutions"] = getRevolutions();
+  return (float)position / (float)stepsPerRev;
+}
+
+void Stepper28BYJ48::captureStatus(MotorStatus& s) const {
+  MotorBase::captureStatus(s);
+  s.target = target;
+  s.maxSpeed = rpmToStepsPerSecond(maxSpeedRPM);
+  s.acceleration = acceleration;
+  s.coilState = static_cast<uint8_t>(coilState);
+}
+
+void Stepper28BYJ48::toJson(JsonObject& obj, const MotorStatus& s) const {
+  MotorBase::toJson(obj, s);
+  obj["targetPosition"] = s.target;
+  obj["distanceToGo"] = s.target - s.position;
+  obj["speedRPM"] = stepsPerSecondToRPM(s.maxSpeed);
+  obj["currentSpeedRPM"] = stepsPerSecondToRPM(s.speed);
+  obj["acceleration"] = s.acceleration;
+  obj["stepsPerRev"] = stepsPerRev;
+  obj["revolutions"] = (float)s.position / (float)stepsPerRev;
+  obj["stepMode"] = coilModeName(coilMode);
+  obj["coils"] = coilStateName(static_cast<CoilState>(s.coilState));
+  obj["idleReleaseMs"] = idleReleaseMs;
+  obj["holdDuty"] = holdDuty;
   obj["pins"] = serialized(String("[") + pins[0] + "," + pins[1] + "," + pins[2] + "," + pins[3] + "]");
 }
 
+void Stepper28BYJ48::startMove() {
+  if (position == target) return;
+
+  ramp.n = 0;
+  int8_t startDir = direction;
+  if (!MotionPlanner::next(ramp, target - position, direction, startDir)) return;
+
+  // Full current on the phase the rotor is in; first step on the next
+  // update, then one interval apart
+  if (coilState != CoilState::ENERGIZED) energizeCoils();
+  direction = startDir;
+  lastStepUs = micros() - (ramp.cnQ8 >> 8);
+  running = true;
+}
+
+void Stepper28BYJ48::halt() {
+  running = false;
+  ramp.n = 0;
+  target = position;
+}
+
+void Stepper28BYJ48::setCoilMode(CoilStepMode mode) {
+  coilMode = mode <= CoilStepMode::WAVE ? mode : CoilStepMode::HALF;
+  stepsPerRev = coilMode == CoilStepMode::HALF ? ULN2003_STEPS_PER_REV : ULN2003_STEPS_PER_REV / 2;
+  buildPhaseTable();
+  setSpeed(maxSpeedRPM);
+}
+
+void Stepper28BYJ48::setIdleRelease(uint16_t releaseMs, uint8_t holdDutyPercent) {
+  idleReleaseMs = releaseMs;
+  holdDuty = min(holdDutyPercent, (uint8_t)100);
+}
+
+// Coil pin levels of each phase as GPIO bank masks, so a step is one
+// masked write per bank (one bank unless the coils straddle GPIO 32)
+void Stepper28BYJ48::buildPhaseTable() {
+  const uint8_t* sequence = COIL_SEQUENCES[static_cast<uint8_t>(coilMode)];
+
+  coilMask[0] = coilMask[1] = 0;
+  for (uint8_t phase = 0; phase < 8; phase++) {
+    phaseLevels[phase][0] = phaseLevels[phase][1] = 0;
+  }
+
+  for (int i = 0; i < 4; i++) {
+    if (pins[i] >= GPIO_BATCH_PIN_COUNT) continue;
+    uint8_t bank = pins[i] >> 5;
+    uint32_t bit = 1UL << (pins[i] & 31);
+    coilMask[bank] |= bit;
+    for (uint8_t phase = 0; phase < 8; phase++) {
+      if ((sequence[phase] >> i) & 1) phaseLevels[phase][bank] |= bit;
+    }
+  }
+}
+
+void Stepper28BYJ48::writeCoils(uint8_t phase) {
+  const uint32_t* levels = phaseLevels[phase & 7];
+  for (uint8_t bank = 0; bank < 2; bank++) {
+    if (coilMask[bank]) GpioBatch::writeBank(bank, coilMask[bank], levels[bank]);
+  }
+}
+
+void Stepper28BYJ48::energizeCoils() {
+  if (holdPins) endHold(true);
+  writeCoils(position & 7);
+  coilState = CoilState::ENERGIZED;
+}
+
+// Reduced current: PWM on the coils the present phase energizes
+void Stepper28BYJ48::holdCoils() {
+  uint8_t pattern = COIL_SEQUENCES[static_cast<uint8_t>(coilMode)][position & 7];
+  uint32_t duty = LedcAllocator::maxDuty(ULN2003_HOLD_PWM_RESOLUTION) * holdDuty / 100;
+
+  for (int i = 0; i < 4; i++) {
+    if (!((pattern >> i) & 1)) continue;
+    if (LedcAllocator::attach(pins[i], ULN2003_HOLD_PWM_FREQUENCY, ULN2003_HOLD_PWM_RESOLUTION, slotId) < 0) {
+      endHold(true);
+      Serial.printf("[MOTOR] 28BYJ-48 slot %d has no PWM channel for hold current, holding at full\n", slotId);
+      return;
+    }
+    holdPins |= 1 << i;
+    GpioBatch::writeDuty(pins[i], duty);
+  }
+  coilState = CoilState::HOLDING;
+}
+
+// Hands the hold PWM pins back to GPIO, on or off
+void Stepper28BYJ48::endHold(bool energized) {
+  for (int i = 0; i < 4; i++) {
+    if (!((holdPins >> i) & 1)) continue;
+    LedcAllocator::detach(pins[i]);
+    GpioBatch::configureOutput(pins[i], energized);
+  }
+  holdPins = 0;
+}
+
+void Stepper28BYJ48::releaseCoils() {
+  if (holdPins) endHold(false);
+  for (uint8_t bank = 0; bank < 2; bank++) {
+    if (coilMask[bank]) GpioBatch::writeBank(bank, coilMask[bank], 0);
+  }
+  coilState = CoilState::RELEASED;
+}
+
+// A move ended: drop to the hold current and start the idle timer
+void Stepper28BYJ48::enterIdle() {
+  idleSinceMs = millis();
+  if (coilState != CoilState::ENERGIZED || holdDuty >= 100) return;
+
+  if (holdDuty == 0) {
+    releaseCoils();
+  } else {
+    holdCoils();
+  }
+}
+
 float Stepper28BYJ48::rpmToStepsPerSecond(float rpm) const {
   // RPM to steps/second: (rpm * steps_per_rev) / 60
-  return (rpm * STEPS_PER_REV) / 60.0f;
+  return (rpm * stepsPerRev) / 60.0f;
 }
 
 float Stepper28BYJ48::stepsPerSecondToRPM(float sps) const {
   // Steps/second to RPM: (sps * 60) / steps_per_rev
-  return (sps * 60.0f) / STEPS_PER_REV;
+  return (sps * 60.0f) / stepsPerRev;
 }
@@ -1,15 +1,30 @@
 #pragma once
 
 #include "motor_base.h"
-#include <AccelStepper.h>
+#include "../core/motion_planner.h"
 
 // ============================================================================
 // 28BYJ-48 Stepper Driver - ULN2003 4-Wire Interface
 // ============================================================================
 // The 28BYJ-48 is a small unipolar stepper with 64:1 gear reduction.
-// With half-stepping, it has 2048 steps per revolution of the output shaft.
+// With half-stepping, it has 2048 steps per revolution of the output shaft;
+// full and wave stepping have half as many.
+// Coil steps are polled from update(); MotionPlanner supplies the ramp with
+// microsecond intervals.
+//
+// The coil levels of every phase are worked out once, as GPIO bank masks,
+// so a step is a single masked write (see GpioBatch::writeBank). The coils
+// drop to holdDuty percent (LEDC PWM on the energized coils) when a move
+// ends, and are switched off after idleReleaseMs without a move; the next
+// move re-energizes the phase the rotor was left in.
 
-class Stepper28BYJ48 : public MotorBase {
+enum class CoilState : uint8_t {
+  RELEASED,   // All coils off
+  ENERGIZED,  // Full current on the present phase
+  HOLDING     // Reduced current on the present phase
+};
+
+class Stepper28BYJ48 final : public MotorBase {
 public:
   Stepper28BYJ48(uint8_t slot, uint8_t in1, uint8_t in2, uint8_t in3, uint8_t in4);
   ~Stepper28BYJ48() override;
@@ -29,6 +44,10 @@ public:
   void setAcceleration(float stepsPerSecondSquared);
   void setCurrentPosition(int32_t position);
 
+  // === Coils (before init()) ===
+  void setCoilMode(CoilStepMode mode);
+  void setIdleRelease(uint16_t releaseMs, uint8_t holdDutyPercent);
+
   // === Status ===
   bool isMoving() const override;
   int32_t getPosition() const override;
@@ -37,24 +56,51 @@ public:
   int32_t distanceToGo() const;
   int32_t getTargetPosition() const;
   float getRevolutions() const;
+  int32_t getStepsPerRev() const { return stepsPerRev; }
+  CoilState getCoilState() const { return coilState; }
 
   // === Type Info ===
   MotorType getType() const override { return MotorType::STEPPER_ULN2003; }
   const char* getTypeName() const override { return "Stepper (28BYJ-48)"; }
 
   // === JSON ===
-  void toJson(JsonObject& obj) const override;
-
-  // === Constants ===
-  static constexpr int32_t STEPS_PER_REV = ULN2003_STEPS_PER_REV;  // 2048 with 64:1 gearbox
+  void captureStatus(MotorStatus& s) const override;
+  void toJson(JsonObject& obj, const MotorStatus& s) const override;
 
 private:
-  mutable AccelStepper stepper;
   uint8_t pins[4];
 
+  // Coil sequencer
+  CoilStepMode coilMode = CoilStepMode::HALF;
+  int32_t stepsPerRev = ULN2003_STEPS_PER_REV;
+  uint32_t coilMask[2] = {0, 0};        // Coil pins per GPIO bank
+  uint32_t phaseLevels[8][2] = {};      // Coil pin levels per phase and bank
+  CoilState coilState = CoilState::RELEASED;
+  uint8_t holdPins = 0;                 // Coils on hold PWM, bit i = IN(i+1)
+  uint16_t idleReleaseMs = ULN2003_IDLE_RELEASE_MS;
+  uint8_t holdDuty = ULN2003_HOLD_DUTY;
+  uint32_t idleSinceMs = 0;
+
+  MotionRamp ramp;           // Intervals in microseconds
+  int32_t position = 0;
+  int32_t target = 0;
+  int8_t direction = 1;
+  bool running = false;
+  uint32_t lastStepUs = 0;   // Due time of the last step
+
   float maxSpeedRPM = DEFAULT_28BYJ_SPEED;
   float acceleration = 500;  // steps/sec^2
 
+  void startMove();
+  void halt();
+  void buildPhaseTable();
+  void writeCoils(uint8_t phase);
+  void energizeCoils();
+  void holdCoils();
+  void endHold(bool energized);
+  void releaseCoils();
+  void enterIdle();
+
   float rpmToStepsPerSecond(float rpm) const;
   float stepsPerSecondToRPM(float sps) const;
 };
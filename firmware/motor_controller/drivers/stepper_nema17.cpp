@@ -1,9 +1,640 @@
 #include "stepper_nema17.h"
+#include <driver/rmt_tx.h>
+#include <driver/pulse_cnt.h>
+#include <driver/gpio.h>
+#include "../core/gpio_batch.h"
+#include "../core/ledc_allocator.h"
+
+// ============================================================================
+// RMT Pulse Train Output
+// ============================================================================
+// The ramp generator runs ahead of the hardware in task context and encodes
+// steps as RMT symbols, one transaction per block. Acceleration and
+// deceleration are encoded step by step; cruise reuses one precomputed block,
+// so the RMT peripheral clocks out every edge without per-step CPU work.
+// Position is reported from completed transactions.
+
+static constexpr uint32_t RMT_MAX_HALF_TICKS = 32767;   // 15-bit symbol duration
+static constexpr uint8_t RMT_MAX_SYMBOLS_PER_STEP = 4;  // Caps the slowest step
+
+struct RmtStepOutput {
+  bool inUse;
+  rmt_channel_handle_t channel;
+  rmt_encoder_handle_t encoder;
+  uint8_t dirPin;
+
+  StepChannel gen;        // Generator state, runs ahead of the hardware
+  int8_t hwDir;           // Direction currently on the DIR pin
+  uint32_t carryQ8;       // Fractional RMT ticks carried between steps
+  bool limitHit;
+  bool positionLost;      // A halt aborted a transaction; its steps are unknown
+  bool txFailed;          // rmt_transmit refused a block; the move was stopped
+  volatile bool haltPending;  // Set from any task, applied by the mutex holder
+
+  rmt_symbol_word_t blocks[RMT_STEP_QUEUE_DEPTH][RMT_STEP_BLOCK_SYMBOLS];
+  rmt_symbol_word_t cruise[RMT_STEP_BLOCK_SYMBOLS];
+  uint32_t cruiseIntervalQ8;  // Interval the cruise block was built for
+
+  // Queued transactions; counters are single-writer (task / done ISR)
+  // except for the reset in halt(), which the lock orders against the ISR
+  portMUX_TYPE lock;
+  int32_t txSteps[RMT_STEP_QUEUE_DEPTH];
+  bool txCruise[RMT_STEP_QUEUE_DEPTH];
+  uint32_t txQueued;
+  volatile uint32_t txDone;
+  uint32_t cruiseQueued;
+  volatile uint32_t cruiseDone;
+  volatile int32_t donePosition;
+
+  static RmtStepOutput* claim(uint8_t stepPin, uint8_t dirPin);
+  void release();
+
+  void moveTo(int32_t target);
+  bool queueMove(int32_t target);
+  void runSpeed(float stepsPerSecond);
+  void stop();
+  void halt();
+  void setMaxSpeed(float stepsPerSecond);
+  void setAcceleration(float stepsPerSecondSquared);
+  void setPosition(int32_t position);
+  void service();
+
+  bool busy() const { return txQueued != txDone; }
+  bool running() const { return gen.running || busy(); }
+  float speed() const;
+
+private:
+  uint16_t encodeStep(rmt_symbol_word_t* out, uint32_t ticks);
+  uint32_t toRmtTicks(uint32_t intervalQ8);
+  void abortMove(int32_t unsentSteps);
+  bool transmit(rmt_symbol_word_t* symbols, uint16_t count, int32_t steps, bool isCruise);
+  static bool IRAM_ATTR onTxDone(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t* edata, void* ctx);
+};
+
+static RmtStepOutput rmtPool[RMT_STEP_MAX_OUTPUTS];
+
+RmtStepOutput* RmtStepOutput::claim(uint8_t stepPin, uint8_t dirPin) {
+  for (uint8_t i = 0; i < RMT_STEP_MAX_OUTPUTS; i++) {
+    RmtStepOutput* r = &rmtPool[i];
+    if (r->inUse) continue;
+
+    rmt_tx_channel_config_t config = {};
+    config.gpio_num = (gpio_num_t)stepPin;
+    config.clk_src = RMT_CLK_SRC_DEFAULT;
+    config.resolution_hz = RMT_STEP_RESOLUTION_HZ;
+    config.mem_block_symbols = 64;
+    config.trans_queue_depth = RMT_STEP_QUEUE_DEPTH;
+
+    if (rmt_new_tx_channel(&config, &r->channel) != ESP_OK) return nullptr;
+
+    rmt_copy_encoder_config_t encoderConfig = {};
+    if (rmt_new_copy_encoder(&encoderConfig, &r->encoder) != ESP_OK) {
+      rmt_del_channel(r->channel);
+      return nullptr;
+    }
+
+    rmt_tx_event_callbacks_t callbacks = {};
+    callbacks.on_trans_done = onTxDone;
+    rmt_tx_register_event_callbacks(r->channel, &callbacks, r);
+    rmt_enable(r->channel);
+
+    memset(&r->gen, 0, sizeof(StepChannel));
+    r->gen.direction = 1;
+    r->gen.pendingDir = 1;
+    r->gen.posMin = INT32_MIN;
+    r->gen.posMax = INT32_MAX;
+    r->gen.group = -1;
+    MotionPlanner::init(r->gen.ramp, STEP_ENGINE_TIMER_HZ, DEFAULT_STEPPER_SPEED, DEFAULT_STEPPER_ACCEL);
+
+    r->dirPin = dirPin;
+    r->hwDir = 1;
+    r->carryQ8 = 0;
+    r->limitHit = false;
+    r->positionLost = false;
+    r->txFailed = false;
+    r->haltPending = false;
+    portMUX_INITIALIZE(&r->lock);
+    r->cruiseIntervalQ8 = 0;
+    r->txQueued = r->txDone = 0;
+    r->cruiseQueued = r->cruiseDone = 0;
+    r->donePosition = 0;
+    r->inUse = true;
+
+    if (dirPin != 255) {
+      pinMode(dirPin, OUTPUT);
+      digitalWrite(dirPin, HIGH);
+    }
+    return r;
+  }
+  return nullptr;
+}
+
+void RmtStepOutput::release() {
+  halt();
+  rmt_disable(channel);
+  rmt_del_encoder(encoder);
+  rmt_del_channel(channel);
+  inUse = false;
+}
+
+void RmtStepOutput::moveTo(int32_t target) {
+  StepEngine::clearSegments(gen);
+  gen.target = target;
+  if (gen.continuous) {
+    gen.continuous = false;
+    gen.ramp.n = MotionPlanner::stepsToStop(gen.ramp);
+  }
+
+  if (!gen.running && gen.position != target) {
+    gen.ramp.n = 0;
+    gen.running = true;
+    StepEngine::advanceRamp(gen);
+  }
+  service();
+}
+
+bool RmtStepOutput::queueMove(int32_t target) {
+  if (!gen.running || gen.continuous) {
+    moveTo(target);
+    return true;
+  }
+  return StepEngine::appendSegment(gen, target);
+}
+
+void RmtStepOutput::runSpeed(float stepsPerSecond) {
+  if (stepsPerSecond == 0.0f) {
+    halt();
+    return;
+  }
+
+  StepEngine::clearSegments(gen);
+  uint32_t intervalQ8 = MotionPlanner::intervalQ8(gen.ramp, fabsf(stepsPerSecond));
+  gen.ramp.cnQ8 = intervalQ8 < gen.ramp.cminQ8 ? gen.ramp.cminQ8 : intervalQ8;
+  gen.continuous = true;
+  gen.running = true;
+  gen.ramp.n = 0;
+  gen.pendingDir = stepsPerSecond > 0 ? 1 : -1;
+  service();
+}
+
+void RmtStepOutput::stop() {
+  StepEngine::clearSegments(gen);
+  if (!gen.running) return;
+
+  // Queued blocks still play out; the generator decelerates from its frontier
+  if (gen.continuous) {
+    gen.continuous = false;
+    gen.ramp.n = MotionPlanner::stepsToStop(gen.ramp);
+    gen.target = gen.position + gen.direction * (gen.ramp.n + 1);
+  } else {
+    int32_t stepsToStop = gen.ramp.n >= 0 ? gen.ramp.n : -gen.ramp.n;
+    gen.target = gen.position + gen.direction * stepsToStop;
+  }
+}
+
+void RmtStepOutput::halt() {
+  // Disabling the channel aborts the transaction in progress and flushes
+  // the queue. How much of the aborted block went out is unknown, so the
+  // position is flagged as lost until it is set again. Mutex holder only:
+  // rmt_transmit() and this must not interleave.
+  haltPending = false;
+  if (busy()) positionLost = true;
+  rmt_disable(channel);
+  portENTER_CRITICAL(&lock);
+  txDone = txQueued;
+  cruiseDone = cruiseQueued;
+  portEXIT_CRITICAL(&lock);
+  rmt_enable(channel);
+
+  StepEngine::clearSegments(gen);
+  gen.running = false;
+  gen.continuous = false;
+  gen.ramp.n = 0;
+  gen.position = donePosition;
+  gen.target = donePosition;
+}
+
+void RmtStepOutput::setMaxSpeed(float stepsPerSecond) {
+  MotionPlanner::setMaxSpeed(gen.ramp, constrain(stepsPerSecond, 1.0f, STEP_ENGINE_MAX_RATE));
+}
+
+void RmtStepOutput::setAcceleration(float stepsPerSecondSquared) {
+  MotionPlanner::setAcceleration(gen.ramp, stepsPerSecondSquared);
+}
+
+void RmtStepOutput::setPosition(int32_t position) {
+  halt();
+  positionLost = false;
+  portENTER_CRITICAL(&lock);
+  donePosition = position;
+  portEXIT_CRITICAL(&lock);
+  gen.position = position;
+  gen.target = position;
+}
+
+float RmtStepOutput::speed() const {
+  if (!running()) return 0.0f;
+  return gen.direction * MotionPlanner::speed(gen.ramp);
+}
+
+// Keep the transaction queue full. Called from update() and after commands.
+void RmtStepOutput::service() {
+  StepChannel& c = gen;
+
+  while (c.running && txQueued - txDone < RMT_STEP_QUEUE_DEPTH) {
+    // DIR may only change once everything queued has been clocked out
+    if (c.pendingDir != hwDir) {
+      if (busy()) return;
+      hwDir = c.pendingDir;
+      if (dirPin != 255) digitalWrite(dirPin, hwDir > 0 ? HIGH : LOW);
+    }
+    c.direction = hwDir;
+
+    // Cruise: a block of identical steps at max speed with room left to
+    // decelerate, as long as one step fits in a single symbol
+    uint32_t stepTicks = (uint64_t)c.ramp.cnQ8 * RMT_STEP_RESOLUTION_HZ / STEP_ENGINE_TIMER_HZ >> 8;
+    uint32_t cruiseSteps = RMT_STEP_BLOCK_US * (RMT_STEP_RESOLUTION_HZ / 1000000) / (stepTicks + 1) + 1;
+    if (cruiseSteps > RMT_STEP_BLOCK_SYMBOLS) cruiseSteps = RMT_STEP_BLOCK_SYMBOLS;
+
+    // A cruise block must not cross a look-ahead junction, but may use the
+    // runway past it when deciding whether there is room to decelerate
+    int32_t toTarget = (c.target - c.position) * c.direction;
+    int32_t remaining = c.continuous ? INT32_MAX : toTarget + c.runway;
+    int32_t blockEnd = c.position + c.direction * (int32_t)cruiseSteps;
+    bool cruising = stepTicks < RMT_MAX_HALF_TICKS &&
+                    (c.continuous ||
+                     (c.ramp.n > 0 && c.ramp.cnQ8 == c.ramp.cminQ8 &&
+                      toTarget > (int32_t)cruiseSteps &&
+                      remaining > c.ramp.n + (int32_t)cruiseSteps + 1));
+    bool inLimits = !c.limitsEnabled || (blockEnd >= c.posMin && blockEnd <= c.posMax);
+
+    if (cruising && inLimits) {
+      if (cruiseIntervalQ8 != c.ramp.cnQ8 && cruiseQueued == cruiseDone) {
+        // Rebuild the shared cruise block for the new interval; the carry
+        // spreads the fractional tick over the block
+        for (uint16_t i = 0; i < RMT_STEP_BLOCK_SYMBOLS; i++) {
+          encodeStep(&cruise[i], toRmtTicks(c.ramp.cnQ8));
+        }
+        cruiseIntervalQ8 = c.ramp.cnQ8;
+      }
+      if (cruiseIntervalQ8 == c.ramp.cnQ8) {
+        c.position = blockEnd;
+        if (!transmit(cruise, cruiseSteps, c.direction * (int32_t)cruiseSteps, true)) {
+          abortMove(c.direction * (int32_t)cruiseSteps);
+          return;
+        }
+        continue;
+      }
+    }
+
+    // Ramp: encode step by step until the block is full or long enough,
+    // the move ends or the direction is about to change
+    rmt_symbol_word_t* block = blocks[txQueued % RMT_STEP_QUEUE_DEPTH];
+    const uint32_t blockTicks = RMT_STEP_BLOCK_US * (RMT_STEP_RESOLUTION_HZ / 1000000);
+    uint32_t elapsed = 0;
+    uint16_t used = 0;
+    int32_t steps = 0;
+
+    while (c.running && elapsed < blockTicks && used + RMT_MAX_SYMBOLS_PER_STEP <= RMT_STEP_BLOCK_SYMBOLS) {
+      int32_t nextPos = c.position + c.direction;
+      if (c.limitsEnabled && (nextPos < c.posMin || nextPos > c.posMax)) {
+        c.running = false;
+        c.continuous = false;
+        c.target = c.position;
+        c.ramp.n = 0;
+        StepEngine::clearSegments(c);
+        limitHit = true;
+        break;
+      }
+
+      c.position = nextPos;
+      steps++;
+      if (!c.continuous) StepEngine::advanceRamp(c);
+
+      // The last step of a move only needs a minimal low time
+      uint32_t ticks = c.running ? toRmtTicks(c.ramp.cnQ8) : 2 * RMT_STEP_PULSE_TICKS;
+      used += encodeStep(&block[used], ticks);
+      elapsed += ticks;
+
+      if (c.pendingDir != c.direction) break;
+    }
+
+    if (steps == 0) break;
+    if (!transmit(block, used, c.direction * steps, false)) {
+      abortMove(c.direction * steps);
+      return;
+    }
+  }
+}
+
+// A block was not queued: take its steps back off the generator and end
+// the move where the queued blocks end
+void RmtStepOutput::abortMove(int32_t unsentSteps) {
+  StepChannel& c = gen;
+  StepEngine::clearSegments(c);
+  c.position -= unsentSteps;
+  c.target = c.position;
+  c.running = false;
+  c.continuous = false;
+  c.ramp.n = 0;
+  txFailed = true;
+}
+
+uint32_t RmtStepOutput::toRmtTicks(uint32_t intervalQ8) {
+  uint64_t scaled = (uint64_t)intervalQ8 * RMT_STEP_RESOLUTION_HZ / STEP_ENGINE_TIMER_HZ + carryQ8;
+  carryQ8 = scaled & 0xFF;
+  uint64_t ticks = scaled >> 8;
+  return ticks > UINT32_MAX ? UINT32_MAX : (uint32_t)ticks;
+}
+
+// One step = a STEP pulse then the low time up to the next step. Long low
+// times spill into extra all-low symbols. Returns the symbols written.
+uint16_t RmtStepOutput::encodeStep(rmt_symbol_word_t* out, uint32_t ticks) {
+  const uint32_t maxLow = RMT_MAX_HALF_TICKS + (RMT_MAX_SYMBOLS_PER_STEP - 1) * 2 * RMT_MAX_HALF_TICKS;
+  if (ticks < 2 * RMT_STEP_PULSE_TICKS) ticks = 2 * RMT_STEP_PULSE_TICKS;
+
+  uint32_t low = ticks - RMT_STEP_PULSE_TICKS;
+  if (low > maxLow) low = maxLow;
+
+  uint32_t first = low < RMT_MAX_HALF_TICKS ? low : RMT_MAX_HALF_TICKS;
+  uint32_t rest = low - first;
+  if (rest == 1) { first--; rest++; }  // A zero-length half would end the transaction
+
+  out[0].level0 = 1;
+  out[0].duration0 = RMT_STEP_PULSE_TICKS;
+  out[0].level1 = 0;
+  out[0].duration1 = first;
+
+  uint16_t count = 1;
+  while (rest > 0) {
+    uint32_t chunk = rest < 2 * RMT_MAX_HALF_TICKS ? rest : 2 * RMT_MAX_HALF_TICKS;
+    if (rest - chunk == 1) chunk--;
+    out[count].level0 = 0;
+    out[count].duration0 = chunk / 2;
+    out[count].level1 = 0;
+    out[count].duration1 = chunk - chunk / 2;
+    rest -= chunk;
+    count++;
+  }
+  return count;
+}
+
+bool RmtStepOutput::transmit(rmt_symbol_word_t* symbols, uint16_t count, int32_t steps, bool isCruise) {
+  uint8_t slot = txQueued % RMT_STEP_QUEUE_DEPTH;
+  txSteps[slot] = steps;
+  txCruise[slot] = isCruise;
+  if (isCruise) cruiseQueued++;
+  txQueued++;
+
+  rmt_transmit_config_t config = {};
+  config.loop_count = 0;
+  config.flags.eot_level = 0;
+  if (rmt_transmit(channel, encoder, symbols, count * sizeof(rmt_symbol_word_t), &config) == ESP_OK) {
+    return true;
+  }
+
+  // Never queued, so no done callback will account for it
+  txQueued--;
+  if (isCruise) cruiseQueued--;
+  return false;
+}
+
+bool IRAM_ATTR RmtStepOutput::onTxDone(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t* edata, void* ctx) {
+  RmtStepOutput* r = static_cast<RmtStepOutput*>(ctx);
+  portENTER_CRITICAL_ISR(&r->lock);
+  uint8_t slot = r->txDone % RMT_STEP_QUEUE_DEPTH;
+  r->donePosition = r->donePosition + r->txSteps[slot];
+  if (r->txCruise[slot]) r->cruiseDone = r->cruiseDone + 1;
+  r->txDone = r->txDone + 1;
+  portEXIT_CRITICAL_ISR(&r->lock);
+  return false;
+}
+
+// ============================================================================
+// LEDC Frequency Output
+// ============================================================================
+// For constant speed runs STEP is a 50% duty LEDC output; the motor task only
+// retunes its frequency as the speed ramps and the hardware clocks out every
+// pulse in between. A PCNT unit counts the pulses back off the same pin for
+// position. The output rests (duty 0) below STEP_RUN_MIN_SPEED, and DIR only
+// changes once the last pulse before the rest has ended.
+
+struct FrequencyStepOutput {
+  bool inUse;
+  bool active;           // Holds the STEP pin, between begin() and end()
+  bool pulsing;          // Duty at 50%
+  uint8_t stepPin;
+  uint8_t dirPin;
+  uint8_t owner;
+  pcnt_unit_handle_t unit;
+  pcnt_channel_handle_t channel;
+
+  int8_t direction;
+  int32_t basePosition;  // Position at the last direction change
+  uint32_t pulses;       // Counted since then
+  int lastCount;
+  uint32_t frequency;    // Hz, while pulsing
+  uint8_t resolution;
+  uint32_t quietAtUs;    // The last pulse has ended by then once resting
+
+  static FrequencyStepOutput* claim(uint8_t stepPin, uint8_t dirPin, uint8_t owner);
+  void release();
+
+  bool begin(int32_t position, int8_t dir);
+  void setSpeed(float stepsPerSecond);  // Signed, called every tick
+  int32_t end();                        // Stops at once, returns the position
+
+  int32_t position() const { return basePosition + direction * (int32_t)counted(); }
+  float speed() const { return pulsing ? direction * (float)frequency : 0.0f; }
+  bool resting() const { return !pulsing && (int32_t)(micros() - quietAtUs) >= 0; }
+
+private:
+  uint32_t counted() const;
+  void count();
+  void rest();
+  void retune(uint32_t hz);
+};
+
+static FrequencyStepOutput frequencyPool[STEP_FREQUENCY_MAX_OUTPUTS];
+
+// Counter width that keeps the LEDC divider in [256, 512), where its 8
+// fractional bits resolve the frequency to better than 1/65536
+static uint8_t frequencyResolution(uint32_t hz) {
+  uint32_t ratio = LEDC_SOURCE_CLOCK_HZ / (256 * hz);
+  uint8_t bits = ratio > 1 ? 31 - __builtin_clz(ratio) : 1;
+  return bits < LEDC_MAX_RESOLUTION ? bits : LEDC_MAX_RESOLUTION;
+}
+
+// Sets up the counter at configuration time; the pin stays the step
+// engine's until begin()
+FrequencyStepOutput* FrequencyStepOutput::claim(uint8_t stepPin, uint8_t dirPin, uint8_t owner) {
+  for (uint8_t i = 0; i < STEP_FREQUENCY_MAX_OUTPUTS; i++) {
+    FrequencyStepOutput* f = &frequencyPool[i];
+    if (f->inUse) continue;
+
+    pcnt_unit_config_t unitConfig = {};
+    unitConfig.low_limit = -1;
+    unitConfig.high_limit = STEP_FREQUENCY_PCNT_LIMIT;
+    if (pcnt_new_unit(&unitConfig, &f->unit) != ESP_OK) return nullptr;
+
+    pcnt_chan_config_t chanConfig = {};
+    chanConfig.edge_gpio_num = stepPin;
+    chanConfig.level_gpio_num = -1;
+    if (pcnt_new_channel(f->unit, &chanConfig, &f->channel) != ESP_OK) {
+      pcnt_del_unit(f->unit);
+      return nullptr;
+    }
+
+    pcnt_glitch_filter_config_t filter = {};
+    filter.max_glitch_ns = STEP_FREQUENCY_GLITCH_NS;
+    pcnt_unit_set_glitch_filter(f->unit, &filter);
+    pcnt_channel_set_edge_action(f->channel, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                 PCNT_CHANNEL_EDGE_ACTION_HOLD);
+    pcnt_unit_enable(f->unit);
+    pcnt_unit_start(f->unit);
+
+    f->stepPin = stepPin;
+    f->dirPin = dirPin;
+    f->owner = owner;
+    f->active = false;
+    f->pulsing = false;
+    f->inUse = true;
+    return f;
+  }
+  return nullptr;
+}
+
+void FrequencyStepOutput::release() {
+  if (active) end();
+  pcnt_unit_stop(unit);
+  pcnt_unit_disable(unit);
+  pcnt_del_channel(channel);
+  pcnt_del_unit(unit);
+  inUse = false;
+}
+
+// Takes the STEP pin over from the (idle) step engine, resting
+bool FrequencyStepOutput::begin(int32_t position, int8_t dir) {
+  resolution = frequencyResolution(1000);
+  if (LedcAllocator::attachExclusive(stepPin, 1000, resolution, owner) < 0) return false;
+
+  // The LEDC drives the pin; keep its input path for the counter
+  gpio_input_enable((gpio_num_t)stepPin);
+  pcnt_unit_clear_count(unit);
+  lastCount = 0;
+  pulses = 0;
+  basePosition = position;
+  direction = dir;
+  if (dirPin != 255) digitalWrite(dirPin, direction > 0 ? HIGH : LOW);
+
+  frequency = 1000;
+  pulsing = false;
+  quietAtUs = micros();
+  active = true;
+  return true;
+}
+
+void FrequencyStepOutput::setSpeed(float stepsPerSecond) {
+  count();
+
+  float hz = fabsf(stepsPerSecond);
+  int8_t dir = stepsPerSecond > 0 ? 1 : stepsPerSecond < 0 ? -1 : direction;
+
+  if (hz < STEP_RUN_MIN_SPEED || dir != direction) {
+    rest();
+    if (dir != direction && resting()) {
+      count();
+      basePosition = position();
+      pulses = 0;
+      direction = dir;
+      if (dirPin != 255) digitalWrite(dirPin, direction > 0 ? HIGH : LOW);
+    }
+    return;
+  }
+
+  uint32_t target = (uint32_t)(hz + 0.5f);
+  if (!pulsing) {
+    retune(target);
+    ledcWrite(stepPin, 1UL << (resolution - 1));
+    pulsing = true;
+  } else if (target != frequency) {
+    retune(target);
+  }
+}
+
+int32_t FrequencyStepOutput::end() {
+  // A pulse cut short here is below the glitch filter or already counted
+  LedcAllocator::detach(stepPin);
+  pinMode(stepPin, OUTPUT);
+  digitalWrite(stepPin, LOW);
+
+  count();
+  pulsing = false;
+  active = false;
+  return position();
+}
+
+uint32_t FrequencyStepOutput::counted() const {
+  int raw = 0;
+  pcnt_unit_get_count(unit, &raw);
+  int delta = raw - lastCount;
+  if (delta < 0) delta += STEP_FREQUENCY_PCNT_LIMIT;  // Wrapped at the high limit
+  return pulses + delta;
+}
+
+void FrequencyStepOutput::count() {
+  int raw = 0;
+  pcnt_unit_get_count(unit, &raw);
+  int delta = raw - lastCount;
+  if (delta < 0) delta += STEP_FREQUENCY_PCNT_LIMIT;
+  pulses += delta;
+  lastCount = raw;
+}
+
+// Duty 0 takes effect at the end of the current period
+void FrequencyStepOutput::rest() {
+  if (!pulsing) return;
+  ledcWrite(stepPin, 0);
+  pulsing = false;
+  quietAtUs = micros() + 2000000UL / frequency + 1;
+}
+
+// Keeps the duty at 50% across a change of counter width: a wider counter
+// gets its new frequency first, a narrower one its new duty first, so the
+// duty in between is 25% rather than 0 or 100%
+void FrequencyStepOutput::retune(uint32_t hz) {
+  uint8_t bits = frequencyResolution(hz);
+  bool narrower = bits < resolution && pulsing;
+  if (narrower) ledcWrite(stepPin, 1UL << (bits - 1));
+  if (!LedcAllocator::changeFrequency(stepPin, hz, bits)) {
+    if (narrower) ledcWrite(stepPin, 1UL << (resolution - 1));
+    return;
+  }
+  if (bits > resolution && pulsing) ledcWrite(stepPin, 1UL << (bits - 1));
+  frequency = hz;
+  resolution = bits;
+}
+
+// ============================================================================
+// StepperNema17
+// ============================================================================
+
+// MS1-MS3 levels (bits 0-2) selecting 1/microsteps. The drivers agree up to
+// 1/8; 111 is 1/16 on the A4988 but 1/32 on the DRV8825, whose 1/16 is 001.
+static uint8_t microstepPattern(StepperDriver driver, uint8_t microsteps) {
+  switch (microsteps) {
+    case 1:  return 0b000;
+    case 2:  return 0b001;
+    case 4:  return 0b010;
+    case 8:  return 0b011;
+    case 16: return driver == StepperDriver::A4988 ? 0b111 : 0b100;
+    default: return 0b101;  // 1/32, DRV8825 only
+  }
+}
 
 StepperNema17::StepperNema17(uint8_t slot, StepperDriver driver, uint8_t step, uint8_t dir,
                              uint8_t en, uint8_t m1, uint8_t m2, uint8_t m3)
   : MotorBase(slot),
-    stepper(AccelStepper::DRIVER, step, dir),
     driverType(driver),
     stepPin(step), dirPin(dir), enablePin(en),
     ms1Pin(m1), ms2Pin(m2), ms3Pin(m3) {
@@ -12,69 +643,138 @@ StepperNema17::StepperNema17(uint8_t slot, StepperDriver driver, uint8_t step, u
 StepperNema17::~StepperNema17() {
   emergencyStop();
   disable();
+  if (rmt != nullptr) rmt->release();
+  if (freq != nullptr) freq->release();
+  StepEngine::detach(stepChannel);
 }
 
 void StepperNema17::init() {
   // Configure enable pin
   if (enablePin != 255) {
-    pinMode(enablePin, OUTPUT);
-    digitalWrite(enablePin, HIGH);  // Active LOW - disabled
+    GpioBatch::configureOutput(enablePin, true);  // Active LOW - disabled
     driverEnabled = false;
   } else {
     driverEnabled = true;  // No enable pin = always enabled
   }
 
   // Configure microstep pins
-  if (ms1Pin != 255) pinMode(ms1Pin, OUTPUT);
-  if (ms2Pin != 255) pinMode(ms2Pin, OUTPUT);
-  if (ms3Pin != 255) pinMode(ms3Pin, OUTPUT);
+  if (ms1Pin != 255) GpioBatch::configureOutput(ms1Pin, false);
+  if (ms2Pin != 255) GpioBatch::configureOutput(ms2Pin, false);
+  if (ms3Pin != 255) GpioBatch::configureOutput(ms3Pin, false);
 
   // Set default microstepping
   applyMicrosteps();
 
-  // Configure AccelStepper
-  stepper.setMaxSpeed(maxSpeed);
-  stepper.setAcceleration(acceleration);
-  stepper.setCurrentPosition(0);
+  // Claim the step output: RMT if requested and available, else the engine
+  if (output == StepOutput::RMT) {
+    rmt = RmtStepOutput::claim(stepPin, dirPin);
+    if (rmt == nullptr) {
+      Serial.printf("[MOTOR] Stepper slot %d: no RMT channel, using step engine\n", slotId);
+    }
+  }
+
+  // The counter is set up before the engine makes the STEP pin an output
+  if (runOnLedc) {
+    if (rmt != nullptr) {
+      Serial.printf("[MOTOR] Stepper slot %d: LEDC runs need the timer output\n", slotId);
+    } else {
+      freq = FrequencyStepOutput::claim(stepPin, dirPin, slotId);
+      if (freq == nullptr) {
+        Serial.printf("[MOTOR] Stepper slot %d: no PCNT unit, runs use the step engine\n", slotId);
+      }
+    }
+  }
+
+  if (rmt == nullptr) {
+    stepChannel = StepEngine::attach(stepPin, dirPin);
+    if (stepChannel < 0) {
+      setError("No free step channel");
+      return;
+    }
+  }
+
+  configureMicrostepSwitching();
+  setSpeed(maxSpeed);
+  setAcceleration(acceleration);
+  setCurrentPosition(0);
 
   enabled = true;
 
-  Serial.printf("[MOTOR] Stepper NEMA17 slot %d initialized (%s)\n",
-                slotId, driverType == StepperDriver::A4988 ? "A4988" : "DRV8825");
+  Serial.printf("[MOTOR] Stepper NEMA17 slot %d initialized (%s, %s output%s)\n",
+                slotId, driverType == StepperDriver::A4988 ? "A4988" : "DRV8825",
+                rmt != nullptr ? "RMT" : "timer", freq != nullptr ? ", LEDC runs" : "");
 }
 
 void StepperNema17::update() {
+  applyPendingHalt();
   if (!enabled) return;
 
-  // Check position limits before stepping
-  if (limitsEnabled && stepper.distanceToGo() != 0) {
-    int32_t nextPos = stepper.currentPosition();
-    if (stepper.distanceToGo() > 0) nextPos++;
-    else if (stepper.distanceToGo() < 0) nextPos--;
+  // Steps are produced by hardware; keep its limits in sync and report a
+  // refused step as an error
+  syncLimits();
 
-    if (!isWithinLimits(nextPos)) {
-      stepper.stop();
-      setError("Position limit reached");
-      return;
-    }
+  bool limitHit = false;
+  if (rmt != nullptr) {
+    rmt->service();
+    limitHit = rmt->limitHit;
+    rmt->limitHit = false;
+    takeRmtFaults();
+  } else {
+    limitHit = StepEngine::takeLimitHit(stepChannel);
   }
 
-  if (constantSpeedMode) {
-    stepper.runSpeed();
-  } else {
-    stepper.run();
+  if (limitHit) {
+    constantSpeedMode = false;
+    setError("Position limit reached");
   }
+
+  if (constantSpeedMode) serviceRun();
 }
 
 void StepperNema17::stop() {
-  constantSpeedMode = false;
-  stepper.stop();  // Decelerates to stop
+  // A run ramps down at its acceleration and ends in update()
+  if (constantSpeedMode) {
+    runTarget = 0.0f;
+    return;
+  }
+  if (rmt != nullptr) rmt->stop();
+  else StepEngine::stop(stepChannel);  // Decelerates to stop
 }
 
 void StepperNema17::emergencyStop() {
   constantSpeedMode = false;
-  stepper.setCurrentPosition(stepper.currentPosition());  // Immediate stop
-  stepper.stop();
+  if (isFrequencyRun()) endFrequencyRun(false);
+  if (rmt != nullptr) {
+    rmt->halt();
+    takeRmtFaults();
+  } else {
+    StepEngine::halt(stepChannel);  // Immediate stop
+  }
+}
+
+void StepperNema17::requestEmergencyStop() {
+  if (rmt == nullptr) {
+    emergencyStop();
+    return;
+  }
+  rmt->haltPending = true;
+}
+
+void StepperNema17::applyPendingHalt() {
+  if (rmt != nullptr && rmt->haltPending) emergencyStop();
+}
+
+// Reports RMT output faults once each
+void StepperNema17::takeRmtFaults() {
+  if (rmt->txFailed) {
+    rmt->txFailed = false;
+    constantSpeedMode = false;
+    setError("RMT transmit failed, move stopped");
+  }
+  if (rmt->positionLost) {
+    rmt->positionLost = false;
+    setError("Position lost on halt, re-home");
+  }
 }
 
 void StepperNema17::moveTo(int32_t position) {
@@ -83,45 +783,163 @@ void StepperNema17::moveTo(int32_t position) {
     position = clampToLimits(position);
   }
 
+  // The engine carries on from the run's speed
+  if (isFrequencyRun()) endFrequencyRun(true);
+  constantSpeedMode = false;
+  if (rmt != nullptr) rmt->moveTo(position);
+  else StepEngine::moveTo(stepChannel, position);
+}
+
+bool StepperNema17::queueMove(int32_t position) {
+  if (limitsEnabled) {
+    position = clampToLimits(position);
+  }
+
+  if (isFrequencyRun()) endFrequencyRun(true);
   constantSpeedMode = false;
-  stepper.moveTo(position);
+  if (rmt != nullptr) return rmt->queueMove(position);
+  return StepEngine::queueMove(stepChannel, position);
+}
+
+int32_t StepperNema17::stepsInFlight() const {
+  if (rmt == nullptr || !rmt->busy()) return 0;
+  return rmt->txSteps[rmt->txDone % RMT_STEP_QUEUE_DEPTH];
+}
+
+uint8_t StepperNema17::queuedMoves() const {
+  if (rmt != nullptr) return rmt->gen.segCount;
+  return StepEngine::queuedMoves(stepChannel);
 }
 
 void StepperNema17::moveRelative(int32_t steps) {
-  int32_t target = stepper.currentPosition() + steps;
+  int32_t target = getPosition() + steps;
 
   // Check limits
   if (limitsEnabled) {
     target = clampToLimits(target);
   }
 
+  if (isFrequencyRun()) endFrequencyRun(true);
   constantSpeedMode = false;
-  stepper.moveTo(target);
+  if (rmt != nullptr) rmt->moveTo(target);
+  else StepEngine::moveTo(stepChannel, target);
 }
 
 void StepperNema17::setSpeed(float stepsPerSecond) {
-  maxSpeed = constrain(stepsPerSecond, 0.0f, MAX_STEPPER_SPEED);
-  stepper.setMaxSpeed(maxSpeed);
-  stepper.setSpeed(maxSpeed);  // For runSpeed mode
+  // Coarser microsteps cover more positions per pulse
+  maxSpeed = constrain(stepsPerSecond, 0.0f, MAX_STEPPER_SPEED * (1 << switchShift));
+  if (rmt != nullptr) rmt->setMaxSpeed(maxSpeed);
+  else StepEngine::setMaxSpeed(stepChannel, maxSpeed);
+
+  if (constantSpeedMode) runSpeed(runTarget);
 }
 
 void StepperNema17::setAcceleration(float stepsPerSecondSquared) {
   acceleration = stepsPerSecondSquared;
-  stepper.setAcceleration(acceleration);
+  if (rmt != nullptr) rmt->setAcceleration(acceleration);
+  else StepEngine::setAcceleration(stepChannel, acceleration);
 }
 
-void StepperNema17::runSpeed() {
-  // Constant speed mode (no acceleration)
+void StepperNema17::runSpeed(float stepsPerSecond) {
+  // Pulses are at the configured microsteps whatever the switching level
+  float limit = maxSpeed < MAX_STEPPER_SPEED ? maxSpeed : MAX_STEPPER_SPEED;
+  runTarget = constrain(stepsPerSecond, -limit, limit);
+  if (runTarget != 0.0f && fabsf(runTarget) < STEP_RUN_MIN_SPEED) {
+    runTarget = runTarget > 0 ? STEP_RUN_MIN_SPEED : -STEP_RUN_MIN_SPEED;
+  }
+  if (constantSpeedMode) return;
+
+  // Ramp from whatever the output is doing now; from a standstill the run
+  // can go to the LEDC output
+  float speed = getSpeed();
+  if (freq != nullptr && !isMoving() && runTarget != 0.0f) {
+    if (!freq->begin(getPosition(), runTarget > 0 ? 1 : -1)) {
+      Serial.printf("[MOTOR] Stepper slot %d: no LEDC pair free, run uses the step engine\n", slotId);
+    }
+  }
+
+  SlewRateLimiter::reset(runRamp, speed);
+  runApplied = speed;
+  runLastUs = micros();
   constantSpeedMode = true;
 }
 
+// Motor task: one step of the run's speed ramp, sent to the output in use
+void StepperNema17::serviceRun() {
+  uint32_t now = micros();
+  uint32_t elapsed = now - runLastUs;
+  runLastUs = now;
+  if (elapsed > STEP_RUN_MAX_GAP_US) elapsed = STEP_RUN_MAX_GAP_US;
+  float dt = elapsed * 1e-6f;
+
+  runRamp.acceleration = acceleration;
+  runRamp.deceleration = acceleration;
+  runRamp.jerk = 0.0f;
+
+  // Brake in time for a soft limit ahead
+  float v = runRamp.value;
+  if (limitsEnabled && acceleration > 0.0f && v * runTarget > 0.0f) {
+    int32_t position = getPosition();
+    float room = v > 0 ? (float)posMax - position : (float)position - posMin;
+    if (room <= v * v / (2.0f * acceleration) + fabsf(v) * dt) runTarget = 0.0f;
+  }
+
+  v = SlewRateLimiter::step(runRamp, runTarget, dt);
+
+  if (isFrequencyRun()) {
+    freq->setSpeed(v);
+    int32_t position = freq->position();
+    if (limitsEnabled && (position < posMin || position > posMax)) {
+      endFrequencyRun(false);
+      constantSpeedMode = false;
+      setError("Position limit reached");
+    } else if (v == 0.0f && runTarget == 0.0f && freq->resting()) {
+      endFrequencyRun(false);
+      constantSpeedMode = false;
+    }
+    return;
+  }
+
+  // Step output: the interval follows the speed from the next step on;
+  // below the minimum the output stops, and starts again on the way up
+  bool wasStepping = fabsf(runApplied) >= STEP_RUN_MIN_SPEED;
+  bool stepping = fabsf(v) >= STEP_RUN_MIN_SPEED;
+  if (stepping && v != runApplied) {
+    if (rmt != nullptr) rmt->runSpeed(v);
+    else StepEngine::runSpeed(stepChannel, v);
+  } else if (!stepping && wasStepping) {
+    if (rmt != nullptr) rmt->stop();
+    else StepEngine::stop(stepChannel);
+  }
+  runApplied = v;
+
+  if (v == 0.0f && runTarget == 0.0f && !(rmt != nullptr ? rmt->running() : StepEngine::isRunning(stepChannel))) {
+    constantSpeedMode = false;
+  }
+}
+
+// Hands the STEP pin back to the step engine at the counted position,
+// optionally carrying on at the run's speed
+void StepperNema17::endFrequencyRun(bool keepSpeed) {
+  float speed = freq->speed();
+  StepEngine::setPosition(stepChannel, freq->end());
+  if (keepSpeed && speed != 0.0f) StepEngine::runSpeed(stepChannel, speed);
+}
+
+bool StepperNema17::isFrequencyRun() const {
+  return freq != nullptr && freq->active;
+}
+
 void StepperNema17::setCurrentPosition(int32_t position) {
-  stepper.setCurrentPosition(position);
+  if (isFrequencyRun()) endFrequencyRun(false);
+  constantSpeedMode = false;
+  if (rmt != nullptr) rmt->setPosition(position);
+  else StepEngine::setPosition(stepChannel, position);
 }
 
 void StepperNema17::enable() {
   if (enablePin != 255) {
-    digitalWrite(enablePin, LOW);  // Active LOW
+    GpioBatch::write(enablePin, false);  // Active LOW
     driverEnabled = true;
     Serial.printf("[MOTOR] Stepper slot %d enabled\n", slotId);
   }
@@ -129,7 +947,7 @@ void StepperNema17::enable() {
 
 void StepperNema17::disable() {
   if (enablePin != 255) {
-    digitalWrite(enablePin, HIGH);  // Active LOW - disabled
+    GpioBatch::write(enablePin, true);  // Active LOW - disabled
     driverEnabled = false;
     Serial.printf("[MOTOR] Stepper slot %d disabled\n", slotId);
   }
@@ -140,9 +958,22 @@ void StepperNema17::setMicrosteps(MicrostepMode mode) {
   if (driverType == StepperDriver::A4988 && mode == MicrostepMode::THIRTYSECOND) {
     mode = MicrostepMode::SIXTEENTH;  // A4988 max is 1/16
   }
+  if (mode == microstepMode) return;
+
+  if (enabled && isMoving()) {
+    Serial.printf("[MOTOR] Stepper slot %d: microsteps cannot change while moving\n", slotId);
+    return;
+  }
 
   microstepMode = mode;
-  applyMicrosteps();
+  Serial.printf("[MOTOR] Stepper slot %d microstep set to 1/%d\n",
+                slotId, static_cast<uint8_t>(microstepMode));
+
+  // Before init() the pins are set up there
+  if (enabled) {
+    applyMicrosteps();
+    configureMicrostepSwitching();
+  }
 }
 
 uint16_t StepperNema17::getStepsPerRevolution() const {
@@ -150,23 +981,33 @@ uint16_t StepperNema17::getStepsPerRevolution() const {
 }
 
 bool StepperNema17::isMoving() const {
-  return stepper.isRunning();
+  if (constantSpeedMode) return true;  // Including a run ramping up from rest
+  if (rmt != nullptr) return rmt->running();
+  return StepEngine::isRunning(stepChannel);
 }
 
 int32_t StepperNema17::getPosition() const {
-  return stepper.currentPosition();
+  if (isFrequencyRun()) return freq->position();
+  if (rmt != nullptr) return rmt->donePosition;
+  return StepEngine::getPosition(stepChannel);
 }
 
 float StepperNema17::getSpeed() const {
-  return stepper.speed();
+  if (isFrequencyRun()) return freq->speed();
+  if (rmt != nullptr) return rmt->speed();
+  return StepEngine::getSpeed(stepChannel);
 }
 
 int32_t StepperNema17::distanceToGo() const {
-  return stepper.distanceToGo();
+  if (isFrequencyRun()) return 0;
+  if (rmt != nullptr) return rmt->gen.continuous ? 0 : rmt->gen.target - rmt->donePosition;
+  return StepEngine::distanceToGo(stepChannel);
 }
 
 int32_t StepperNema17::getTargetPosition() const {
-  return stepper.targetPosition();
+  if (isFrequencyRun()) return freq->position();
+  if (rmt != nullptr) return rmt->gen.target;
+  return StepEngine::getTarget(stepChannel);
 }
 
 MotorType StepperNema17::getType() const {
@@ -177,55 +1018,112 @@ const char* StepperNema17::getTypeName() const {
   return driverType == StepperDriver::A4988 ? "Stepper (A4988)" : "Stepper (DRV8825)";
 }
 
-void StepperNema17::toJson(JsonObject& obj) const {
-  MotorBase::toJson(obj);
+void StepperNema17::captureStatus(MotorStatus& s) const {
+  MotorBase::captureStatus(s);
+  s.target = getTargetPosition();
+  s.maxSpeed = maxSpeed;
+  s.acceleration = acceleration;
+  s.constantSpeed = constantSpeedMode;
+  s.frequencyRun = isFrequencyRun();
+  s.driverEnabled = driverEnabled;
+  s.queuedMoves = queuedMoves();
+  s.microstepShift = rmt != nullptr ? 0 : StepEngine::getMicrostepShift(stepChannel);
+}
+
+void StepperNema17::toJson(JsonObject& obj, const MotorStatus& s) const {
+  MotorBase::toJson(obj, s);
   obj["driverType"] = driverType == StepperDriver::A4988 ? "A4988" : "DRV8825";
-  obj["targetPosition"] = stepper.targetPosition();
-  obj["distanceToGo"] = stepper.distanceToGo();
-  obj["maxSpeed"] = maxSpeed;
-  obj["acceleration"] = acceleration;
+  obj["targetPosition"] = s.target;
+  obj["distanceToGo"] = s.target - s.position;
+  obj["maxSpeed"] = s.maxSpeed;
+  obj["acceleration"] = s.acceleration;
   obj["microsteps"] = static_cast<uint8_t>(microstepMode);
+  obj["activeMicrosteps"] = static_cast<uint8_t>(microstepMode) >> s.microstepShift;
+  obj["microstepSwitchRate"] = switchShift > 0 ? microstepSwitchRate : 0;
   obj["stepsPerRev"] = getStepsPerRevolution();
-  obj["driverEnabled"] = driverEnabled;
-  obj["constantSpeedMode"] = constantSpeedMode;
+  obj["driverEnabled"] = s.driverEnabled;
+  obj["constantSpeedMode"] = s.constantSpeed;
+  obj["frequencyRun"] = s.frequencyRun;
+  obj["queuedMoves"] = s.queuedMoves;
   obj["stepPin"] = stepPin;
   obj["dirPin"] = dirPin;
   obj["enablePin"] = enablePin;
+  obj["stepChannel"] = stepChannel;
+  obj["output"] = rmt != nullptr ? "rmt" : "timer";
+  obj["runOutput"] = freq != nullptr ? "ledc" : "step";
+}
+
+void StepperNema17::syncLimits() {
+  if (limitsEnabled == engineLimitsEnabled && posMin == engineMin && posMax == engineMax) return;
+
+  if (rmt != nullptr) {
+    rmt->gen.limitsEnabled = limitsEnabled;
+    rmt->gen.posMin = posMin;
+    rmt->gen.posMax = posMax;
+  } else {
+    StepEngine::setLimits(stepChannel, limitsEnabled, posMin, posMax);
+  }
+  engineLimitsEnabled = limitsEnabled;
+  engineMin = posMin;
+  engineMax = posMax;
 }
 
 void StepperNema17::applyMicrosteps() {
   // Skip if no microstep pins configured
   if (ms1Pin == 255 && ms2Pin == 255 && ms3Pin == 255) return;
 
-  bool m1 = false, m2 = false, m3 = false;
-
-  // A4988 and DRV8825 share same truth table for MS1-MS3
-  switch (microstepMode) {
-    case MicrostepMode::FULL:       // 000
-      m1 = false; m2 = false; m3 = false;
-      break;
-    case MicrostepMode::HALF:       // 100
-      m1 = true;  m2 = false; m3 = false;
-      break;
-    case MicrostepMode::QUARTER:    // 010
-      m1 = false; m2 = true;  m3 = false;
-      break;
-    case MicrostepMode::EIGHTH:     // 110
-      m1 = true;  m2 = true;  m3 = false;
-      break;
-    case MicrostepMode::SIXTEENTH:  // 111
-      m1 = true;  m2 = true;  m3 = true;
-      break;
-    case MicrostepMode::THIRTYSECOND: // DRV8825 only: different pattern
-      // DRV8825: MS3=HIGH for 1/32 (with MS1=MS2=LOW typically)
-      m1 = false; m2 = false; m3 = true;
-      break;
-  }
-
-  if (ms1Pin != 255) digitalWrite(ms1Pin, m1);
-  if (ms2Pin != 255) digitalWrite(ms2Pin, m2);
-  if (ms3Pin != 255) digitalWrite(ms3Pin, m3);
+  // The step engine may have moved the pins while switching
+  const uint8_t pins[3] = {ms1Pin, ms2Pin, ms3Pin};
+  uint8_t pattern = microstepPattern(driverType, static_cast<uint8_t>(microstepMode));
+  for (uint8_t k = 0; k < 3; k++) {
+    if (pins[k] == 255) continue;
+    GpioBatch::forget(pins[k]);
+    GpioBatch::write(pins[k], pattern & (1 << k));
+  }
+}
 
-  Serial.printf("[MOTOR] Stepper slot %d microstep set to 1/%d\n",
-                slotId, static_cast<uint8_t>(microstepMode));
+// Hands the MS pins to the step engine with the pattern for each level
+// from the configured microsteps up to full steps
+void StepperNema17::configureMicrostepSwitching() {
+  switchShift = 0;
+  if (microstepSwitchRate == 0) return;
+
+  if (rmt != nullptr || stepChannel < 0) {
+    Serial.printf("[MOTOR] Stepper slot %d: microstep switching needs the timer output\n", slotId);
+    return;
+  }
+  if (ms1Pin == 255 || ms2Pin == 255 || ms3Pin == 255) {
+    Serial.printf("[MOTOR] Stepper slot %d: microstep switching needs MS1-MS3 pins\n", slotId);
+    return;
+  }
+
+  uint8_t microsteps = static_cast<uint8_t>(microstepMode);
+  uint8_t maxShift = 0;
+  while ((microsteps >> maxShift) > 1 && maxShift < STEP_MICROSTEP_MAX_SHIFT) maxShift++;
+
+  const uint8_t pins[3] = {ms1Pin, ms2Pin, ms3Pin};
+  uint32_t mask[2] = {0, 0};
+  uint32_t levels[STEP_MICROSTEP_MAX_SHIFT + 1][2] = {};
+  for (uint8_t k = 0; k < 3; k++) {
+    mask[pins[k] >> 5] |= 1UL << (pins[k] & 31);
+  }
+  for (uint8_t s = 0; s <= maxShift; s++) {
+    uint8_t pattern = microstepPattern(driverType, microsteps >> s);
+    for (uint8_t k = 0; k < 3; k++) {
+      if (pattern & (1 << k)) levels[s][pins[k] >> 5] |= 1UL << (pins[k] & 31);
+    }
+  }
+
+  if (!StepEngine::setMicrostepSwitching(stepChannel, maxShift, microstepSwitchRate, mask, levels)) {
+    return;
+  }
+  if (maxShift == 0) return;  // Already at full steps
+
+  // The engine writes the MS pins from now on
+  for (uint8_t k = 0; k < 3; k++) {
+    GpioBatch::forget(pins[k]);
+  }
+  switchShift = maxShift;
+  Serial.printf("[MOTOR] Stepper slot %d switches 1/%d up to full steps above %lu steps/s\n",
+                slotId, microsteps, (unsigned long)microstepSwitchRate);
 }
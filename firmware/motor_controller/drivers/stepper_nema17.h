@@ -1,18 +1,33 @@
 #pragma once
 
 #include "motor_base.h"
-#include <AccelStepper.h>
+#include "../core/step_engine.h"
+#include "../core/slew_limiter.h"
 
 // ============================================================================
 // NEMA17 Stepper Driver - A4988/DRV8825 Step/Dir Interface
 // ============================================================================
+// Step pulses are generated by the StepEngine timer ISR by default, or
+// queued as RMT pulse trains. Either way step rate is not tied to the motor
+// task tick; update() only mirrors limits, faults and keeps RMT fed.
+//
+// Constant speed runs ramp their speed in update(). They can be moved to an
+// LEDC frequency output, so a long run costs no CPU per step at all.
 
 enum class StepperDriver : uint8_t {
   A4988,    // Up to 1/16 microstepping
   DRV8825   // Up to 1/32 microstepping
 };
 
-class StepperNema17 : public MotorBase {
+enum class StepOutput : uint8_t {
+  TIMER = 0,  // gptimer ISR step engine
+  RMT = 1     // Queued RMT symbol blocks, no CPU work per step
+};
+
+struct RmtStepOutput;  // RMT pulse train state, pooled in stepper_nema17.cpp
+struct FrequencyStepOutput;  // LEDC/PCNT run output, pooled in stepper_nema17.cpp
+
+class StepperNema17 final : public MotorBase {
 public:
   StepperNema17(uint8_t slot, StepperDriver driver, uint8_t stepPin, uint8_t dirPin,
                 uint8_t enablePin = 255, uint8_t ms1 = 255, uint8_t ms2 = 255, uint8_t ms3 = 255);
@@ -23,21 +38,31 @@ public:
   void update() override;
   void stop() override;
   void emergencyStop() override;
+  // emergencyStop() from a task that does not hold the MotorManager mutex.
+  // The timer output stops at once. An RMT output only touches its driver
+  // from the mutex holder, so it stops at the next update() or
+  // applyPendingHalt().
+  void requestEmergencyStop();
+  void applyPendingHalt();  // Mutex held
 
   // === Stepper Specific Control ===
   void moveTo(int32_t position);        // Absolute position
-  void moveRelative(int32_t steps);     // Relative move
+  void moveRelative(int32_t steps);
+  bool queueMove(int32_t position);     // After the queued moves, blending through; false if full     // Relative move
   void setSpeed(float stepsPerSecond);  // Maximum speed
   void setAcceleration(float stepsPerSecondSquared);
-  void runSpeed();                       // Constant speed mode
+  void runSpeed(float stepsPerSecond);   // Constant signed speed, ramped; 0 ramps to a stop
   void setCurrentPosition(int32_t position);
   void enable();
   void disable();
 
   // === Microstepping ===
-  void setMicrosteps(MicrostepMode mode);
+  void setMicrosteps(MicrostepMode mode);  // Finest level when switching
   MicrostepMode getMicrosteps() const { return microstepMode; }
   uint16_t getStepsPerRevolution() const;
+  // Coarser microsteps above this many STEP pulses/s, 0 = fixed. Needs the
+  // timer output and all three MS pins. Before init().
+  void setMicrostepSwitching(uint32_t stepsPerSecond) { microstepSwitchRate = stepsPerSecond; }
 
   // === Status ===
   bool isMoving() const override;
@@ -47,31 +72,65 @@ public:
   float getTargetSpeed() const override { return maxSpeed; }
   int32_t distanceToGo() const;
   int32_t getTargetPosition() const;
+  uint8_t queuedMoves() const;
+  // RMT output: signed steps of the block being clocked out, which
+  // getPosition() only counts once it completes. 0 on the timer output.
+  int32_t stepsInFlight() const;
 
   // === Type Info ===
   MotorType getType() const override;
   const char* getTypeName() const override;
 
   // === JSON ===
-  void toJson(JsonObject& obj) const override;
+  void captureStatus(MotorStatus& s) const override;
+  void toJson(JsonObject& obj, const MotorStatus& s) const override;
 
   // === Configuration ===
+  void setOutput(StepOutput mode) { output = mode; }  // Before init()
+  StepOutput getOutput() const { return rmt != nullptr ? StepOutput::RMT : StepOutput::TIMER; }
   StepperDriver getDriverType() const { return driverType; }
   void setStepsPerRevolution(uint16_t steps) { stepsPerRev = steps; }
+  int8_t getStepChannel() const { return rmt != nullptr ? -1 : stepChannel; }  // -1 on RMT output
+  // Constant speed runs on an LEDC frequency output instead of the step
+  // output. Timer output only. Before init().
+  void setRunOutput(bool ledc) { runOnLedc = ledc; }
+  bool isFrequencyRun() const;
 
 private:
-  mutable AccelStepper stepper;
+  StepOutput output = StepOutput::TIMER;
+  int8_t stepChannel = -1;        // StepEngine channel, -1 = not attached
+  RmtStepOutput* rmt = nullptr;   // Set when using the RMT output
+  bool runOnLedc = false;
+  FrequencyStepOutput* freq = nullptr;  // Set when runs use the LEDC output
   StepperDriver driverType;
 
   uint8_t stepPin, dirPin, enablePin;
   uint8_t ms1Pin, ms2Pin, ms3Pin;
 
   MicrostepMode microstepMode = MicrostepMode::FULL;
+  uint32_t microstepSwitchRate = 0;
+  uint8_t switchShift = 0;        // Coarsest switching level in use, 0 = fixed
   uint16_t stepsPerRev = NEMA17_STEPS_PER_REV;
   float maxSpeed = DEFAULT_STEPPER_SPEED;
   float acceleration = DEFAULT_STEPPER_ACCEL;
   bool driverEnabled = false;
   bool constantSpeedMode = false;
 
+  // Constant speed run
+  SlewLimiter runRamp = {};
+  float runTarget = 0.0f;
+  float runApplied = 0.0f;        // Last speed sent to the step output
+  uint32_t runLastUs = 0;
+
+  // Limits last pushed to the step engine
+  bool engineLimitsEnabled = false;
+  int32_t engineMin = INT32_MIN;
+  int32_t engineMax = INT32_MAX;
+
   void applyMicrosteps();
+  void configureMicrostepSwitching();
+  void syncLimits();
+  void takeRmtFaults();
+  void serviceRun();
+  void endFrequencyRun(bool keepSpeed);
 };
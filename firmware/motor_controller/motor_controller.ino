@@ -30,13 +30,19 @@
 #include "core/safety_manager.h"
 #include "core/encoder_manager.h"
 #include "core/preset_manager.h"
+#include "core/cam_manager.h"
 #include "core/ota_manager.h"
+#include "core/loop_timing.h"
+#include "core/gcode_interpreter.h"
 
 // API handlers
 #include "api/api_server.h"
 #include "api/api_motors.h"
 #include "api/api_presets.h"
+#include "api/api_cams.h"
 #include "api/api_system.h"
+#include "api/api_diag.h"
+#include "api/api_gcode.h"
 
 // Web pages
 #include "web/web_pages.h"
@@ -46,15 +52,29 @@
 #include "drivers/servo_motor.cpp"
 #include "drivers/stepper_nema17.cpp"
 #include "drivers/stepper_28byj48.cpp"
+#include "core/step_engine.cpp"
+#include "core/gpio_batch.cpp"
+#include "core/ledc_allocator.cpp"
+#include "core/command_queue.cpp"
+#include "core/step_monitor.cpp"
+#include "core/axis_follower.cpp"
+#include "core/waveform_generator.cpp"
 #include "core/motor_manager.cpp"
 #include "core/safety_manager.cpp"
 #include "core/encoder_manager.cpp"
+#include "core/encoder_capture.cpp"
 #include "core/preset_manager.cpp"
+#include "core/cam_manager.cpp"
 #include "core/ota_manager.cpp"
+#include "core/loop_timing.cpp"
+#include "core/gcode_interpreter.cpp"
 #include "api/api_server.cpp"
 #include "api/api_motors.cpp"
 #include "api/api_presets.cpp"
+#include "api/api_cams.cpp"
 #include "api/api_system.cpp"
+#include "api/api_diag.cpp"
+#include "api/api_gcode.cpp"
 
 // ============================================================================
 // Global Objects
@@ -65,7 +85,6 @@ Preferences preferences;
 
 // Task handles
 TaskHandle_t motorTaskHandle = NULL;
-TaskHandle_t encoderTaskHandle = NULL;
 
 // ============================================================================
 // FreeRTOS Tasks
@@ -75,20 +94,22 @@ void motorTaskFunc(void* param) {
   TickType_t lastWakeTime = xTaskGetTickCount();
   const TickType_t interval = pdMS_TO_TICKS(1);  // 1ms = 1kHz
 
-  while (true) {
-    if (!SafetyManager::isEstopActive()) {
-      MotorManager::updateAll();
-    }
-    vTaskDelayUntil(&lastWakeTime, interval);
-  }
-}
-
-void encoderTaskFunc(void* param) {
-  TickType_t lastWakeTime = xTaskGetTickCount();
-  const TickType_t interval = pdMS_TO_TICKS(10);  // 10ms = 100Hz
+  LoopTiming::init(MOTOR_TASK_INTERVAL_MS * 1000);
 
   while (true) {
+    LoopTiming::beginTick();
+    // Encoder speed is estimated every tick, e-stopped or not
     EncoderManager::update();
+    bool updated = true;
+    if (!SafetyManager::isEstopActive()) {
+      updated = MotorManager::updateAll();  // Also starts G-code blocks
+    } else {
+      // Commands queued before the e-stop must not run after the reset
+      CommandQueue::discardAll();
+      GcodeInterpreter::discardAll();
+      MotorManager::applyPendingHalts();
+    }
+    LoopTiming::endTick(updated);
     vTaskDelayUntil(&lastWakeTime, interval);
   }
 }
@@ -163,9 +184,12 @@ void setupWebRoutes() {
   ApiServer::init();
   ApiMotors::registerRoutes(server);
   ApiPresets::registerRoutes(server);
+  ApiCams::registerRoutes(server);
   ApiSystem::registerRoutes(server);
+  ApiDiag::registerRoutes(server);
+  ApiGcode::registerRoutes(server);
 
-  // Handle preset dynamic routes (GET/DELETE/PLAY)
+  // Handle preset and cam dynamic routes (GET/DELETE/PLAY)
   server.onNotFound([]() {
     String uri = server.uri();
 
@@ -192,6 +216,17 @@ void setupWebRoutes() {
       }
     }
 
+    // Handle GET/DELETE /api/cams/{name}
+    if (uri.startsWith("/api/cams/") && uri.length() > 10 && uri.indexOf('/', 10) < 0) {
+      if (server.method() == HTTP_GET) {
+        ApiCams::handleGetCam();
+        return;
+      } else if (server.method() == HTTP_DELETE) {
+        ApiCams::handleDeleteCam();
+        return;
+      }
+    }
+
     // Default 404
     server.send(404, "application/json", "{\"error\":\"Not found\"}");
   });
@@ -215,7 +250,7 @@ void setup() {
   Serial.println("========================================");
   Serial.println();
 
-  // Initialize LittleFS for presets
+  // Initialize LittleFS for presets and cam tables
   if (!LittleFS.begin(true)) {
     Serial.println("[FS] LittleFS mount failed!");
   } else {
@@ -235,6 +270,9 @@ void setup() {
   Serial.println("[Init] Initializing preset manager...");
   PresetManager::init();
 
+  Serial.println("[Init] Initializing cam manager...");
+  CamManager::init();
+
   Serial.println("[Init] Initializing OTA manager...");
   OTAManager::init();
 
@@ -250,17 +288,6 @@ void setup() {
     0  // Core 0
   );
 
-  Serial.println("[Init] Starting encoder task...");
-  xTaskCreatePinnedToCore(
-    encoderTaskFunc,
-    "EncoderTask",
-    2048,
-    NULL,
-    configMAX_PRIORITIES - 2,
-    &encoderTaskHandle,
-    1  // Core 1
-  );
-
   // Setup WiFi
   setupWiFi();
 
@@ -287,6 +314,9 @@ void loop() {
   // Update preset playback
   PresetManager::tick();
 
+  // Stream G-code lines from Serial
+  GcodeInterpreter::pollSerial();
+
   // Small delay to prevent WDT issues
   delay(1);
 }
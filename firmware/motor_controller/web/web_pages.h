@@ -8,7 +8,7 @@
 #include <Arduino.h>
 
 const char PAGE_INDEX[] PROGMEM = R"rawliteral(
-<!DOCTYPE html><html lang="en"><head><meta charset="UTF-8"><meta name="viewport" content="width=device-width, initial-scale=1.0"><title>Motor Controller</title><style> * { box-sizing: border-box; margin: 0; padding: 0; } :root { --bg: #1a1a2e; --card: #16213e; --accent: #0f3460; --highlight: #e94560; --text: #eee; --muted: #888; --success: #4ade80; --warning: #fbbf24; --danger: #ef4444; } body { font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif; background: var(--bg); color: var(--text); min-height: 100vh; padding: 1rem; } header { display: flex; justify-content: space-between; align-items: center; padding: 1rem; background: var(--card); border-radius: 8px; margin-bottom: 1rem; } header h1 { font-size: 1.5rem; } .status-bar { display: flex; gap: 1rem; align-items: center; } .status-indicator { display: flex; align-items: center; gap: 0.5rem; font-size: 0.875rem; } .dot { width: 10px; height: 10px; border-radius: 50%; background: var(--success); } .dot.warning { background: var(--warning); } .dot.danger { background: var(--danger); } nav { display: flex; gap: 0.5rem; margin-bottom: 1rem; } nav a { padding: 0.75rem 1.5rem; background: var(--card); color: var(--text); text-decoration: none; border-radius: 8px; transition: background 0.2s; } nav a:hover, nav a.active { background: var(--accent); } .estop-btn { background: var(--danger); color: white; border: none; padding: 0.75rem 2rem; font-size: 1rem; font-weight: bold; border-radius: 8px; cursor: pointer; text-transform: uppercase; transition: transform 0.1s, box-shadow 0.1s; } .estop-btn:hover { transform: scale(1.05); box-shadow: 0 0 20px rgba(239,68,68,0.5); } .estop-btn:active { transform: scale(0.98); } .estop-btn.active { animation: pulse 1s infinite; } @keyframes pulse { 0%, 100% { box-shadow: 0 0 10px rgba(239,68,68,0.5); } 50% { box-shadow: 0 0 30px rgba(239,68,68,0.8); } } .motor-grid { display: grid; grid-template-columns: repeat(auto-fit, minmax(320px, 1fr)); gap: 1rem; } .motor-card { background: var(--card); border-radius: 12px; padding: 1.25rem; border: 2px solid transparent; transition: border-color 0.2s; } .motor-card.active { border-color: var(--highlight); } .motor-card.estop { border-color: var(--danger); opacity: 0.7; } .card-header { display: flex; justify-content: space-between; align-items: center; margin-bottom: 1rem; } .card-header h3 { font-size: 1.1rem; } .motor-type-badge { padding: 0.25rem 0.75rem; background: var(--accent); border-radius: 20px; font-size: 0.75rem; text-transform: uppercase; } .motor-type-badge.none { background: var(--muted); } .config-form, .control-form { display: flex; flex-direction: column; gap: 0.75rem; } label { font-size: 0.875rem; color: var(--muted); margin-bottom: 0.25rem; display: block; } select, input[type="number"], input[type="text"] { width: 100%; padding: 0.625rem; background: var(--bg); border: 1px solid var(--accent); border-radius: 6px; color: var(--text); font-size: 0.9rem; } select:focus, input:focus { outline: none; border-color: var(--highlight); } .pin-grid { display: grid; grid-template-columns: repeat(2, 1fr); gap: 0.5rem; } .pin-input { display: flex; flex-direction: column; } .btn-row { display: flex; gap: 0.5rem; margin-top: 0.5rem; } button { padding: 0.625rem 1rem; border: none; border-radius: 6px; cursor: pointer; font-size: 0.875rem; transition: background 0.2s, transform 0.1s; } button:active { transform: scale(0.97); } .btn-primary { background: var(--highlight); color: white; } .btn-primary:hover { background: #d63d56; } .btn-secondary { background: var(--accent); color: var(--text); } .btn-secondary:hover { background: #1a4980; } .btn-danger { background: var(--danger); color: white; } .btn-stop { background: var(--warning); color: #000; font-weight: bold; } .slider-group { margin: 0.75rem 0; } .slider-header { display: flex; justify-content: space-between; margin-bottom: 0.5rem; } input[type="range"] { width: 100%; height: 8px; -webkit-appearance: none; background: var(--bg); border-radius: 4px; outline: none; } input[type="range"]::-webkit-slider-thumb { -webkit-appearance: none; width: 20px; height: 20px; background: var(--highlight); border-radius: 50%; cursor: pointer; } .motor-status { margin-top: 1rem; padding-top: 1rem; border-top: 1px solid var(--accent); display: grid; grid-template-columns: repeat(2, 1fr); gap: 0.5rem; font-size: 0.8rem; } .status-item { display: flex; justify-content: space-between; } .status-label { color: var(--muted); } .status-value { font-family: monospace; } .quick-controls { display: flex; gap: 0.5rem; flex-wrap: wrap; margin-top: 0.75rem; } .quick-btn { flex: 1; min-width: 60px; padding: 0.5rem; font-size: 0.8rem; } .system-info { background: var(--card); border-radius: 8px; padding: 1rem; margin-top: 1rem; display: flex; justify-content: space-around; flex-wrap: wrap; gap: 1rem; } .info-item { text-align: center; } .info-value { font-size: 1.5rem; font-weight: bold; color: var(--highlight); } .info-label { font-size: 0.75rem; color: var(--muted); text-transform: uppercase; } .hidden { display: none !important; } .toast { position: fixed; bottom: 2rem; left: 50%; transform: translateX(-50%); background: var(--card); padding: 1rem 2rem; border-radius: 8px; border-left: 4px solid var(--success); animation: slideUp 0.3s; } .toast.error { border-color: var(--danger); } @keyframes slideUp { from { opacity: 0; transform: translate(-50%, 20px); } to { opacity: 1; transform: translate(-50%, 0); } } </style></head><body><header><h1>Motor Controller</h1><div class="status-bar"><div class="status-indicator"><span class="dot" id="connDot"></span><span id="connStatus">Connected</span></div><button class="estop-btn" id="estopBtn" onclick="toggleEstop()">E-STOP</button></div></header><nav><a href="/" class="active">Dashboard</a><a href="/presets">Presets</a><a href="/settings">Settings</a></nav><div class="motor-grid" id="motorGrid"></div><div class="system-info"><div class="info-item"><div class="info-value" id="heapFree">--</div><div class="info-label">Heap Free</div></div><div class="info-item"><div class="info-value" id="uptime">--</div><div class="info-label">Uptime</div></div><div class="info-item"><div class="info-value" id="version">--</div><div class="info-label">Version</div></div></div><div id="toast" class="toast hidden"></div><script> const MOTOR_TYPES = { 0: { name: 'None', pins: [] }, 1: { name: 'DC L298N', pins: ['in1', 'in2', 'ena'] }, 2: { name: 'DC L9110S', pins: ['ia', 'ib'] }, 3: { name: 'Servo', pins: ['signal'] }, 4: { name: 'Stepper A4988', pins: ['step', 'dir', 'enable'] }, 5: { name: 'Stepper DRV8825', pins: ['step', 'dir', 'enable'] }, 6: { name: 'Stepper ULN2003', pins: ['in1', 'in2', 'in3', 'in4'] } }; const DEFAULT_PINS = [ { in1: 13, in2: 12, ena: 14, ia: 13, ib: 12, signal: 13, step: 13, dir: 12, enable: 14 }, { in1: 27, in2: 26, ena: 25, ia: 27, ib: 26, signal: 27, step: 27, dir: 26, enable: 25 }, { in1: 33, in2: 32, ena: 35, ia: 33, ib: 32, signal: 33, step: 33, dir: 32, enable: 35 }, { in1: 19, in2: 18, ena: 5, ia: 19, ib: 18, signal: 19, step: 19, dir: 18, enable: 5 } ]; let motorState = [{}, {}, {}, {}]; let estopActive = false; let pollInterval; function init() { renderMotorCards(); startPolling(); } function renderMotorCards() { const grid = document.getElementById('motorGrid'); grid.innerHTML = ''; for (let i = 0; i < 4; i++) { grid.appendChild(createMotorCard(i)); } } function createMotorCard(slot) { const card = document.createElement('div'); card.className = 'motor-card'; card.id = `motor-${slot}`; card.innerHTML = ` <div class="card-header"><h3>Motor Slot ${slot}</h3><span class="motor-type-badge none" id="badge-${slot}">Unconfigured</span></div><div class="config-form" id="config-${slot}"><div><label>Motor Type</label><select id="type-${slot}" onchange="onTypeChange(${slot})"> ${Object.entries(MOTOR_TYPES).map(([k,v]) => `<option value="${k}">${v.name}</option>`).join('')} </select></div><div class="pin-grid" id="pins-${slot}"></div><div class="btn-row"><button class="btn-primary" onclick="configureMotor(${slot})">Configure</button><button class="btn-danger" onclick="removeMotor(${slot})">Remove</button></div></div><div class="control-form hidden" id="control-${slot}"><div id="controls-${slot}"></div><div class="quick-controls"><button class="quick-btn btn-stop" onclick="stopMotor(${slot})">STOP</button><button class="quick-btn btn-secondary" onclick="brakeMotor(${slot})">Brake</button><button class="quick-btn btn-secondary" onclick="coastMotor(${slot})">Coast</button></div><div class="motor-status" id="status-${slot}"></div></div> `; return card; } function onTypeChange(slot) { const type = parseInt(document.getElementById(`type-${slot}`).value); const pinsDiv = document.getElementById(`pins-${slot}`); const pins = MOTOR_TYPES[type].pins; if (pins.length === 0) { pinsDiv.innerHTML = ''; return; } pinsDiv.innerHTML = pins.map(pin => ` <div class="pin-input"><label>${pin.toUpperCase()}</label><input type="number" id="pin-${slot}-${pin}" value="${DEFAULT_PINS[slot][pin] || 0}" min="0" max="39"></div> `).join(''); } function renderControls(slot, type) { const div = document.getElementById(`controls-${slot}`); switch(type) { case 1: case 2: // DC motors div.innerHTML = ` <div class="slider-group"><div class="slider-header"><span>Speed</span><span id="speed-val-${slot}">0%</span></div><input type="range" id="speed-${slot}" min="-100" max="100" value="0" oninput="updateSpeedLabel(${slot})" onchange="setSpeed(${slot})"></div> `; break; case 3: // Servo div.innerHTML = ` <div class="slider-group"><div class="slider-header"><span>Angle</span><span id="angle-val-${slot}">90&deg;</span></div><input type="range" id="angle-${slot}" min="0" max="180" value="90" oninput="updateAngleLabel(${slot})" onchange="setAngle(${slot})"></div><div class="btn-row"><button class="btn-secondary" onclick="setAngle(${slot}, 0)">0&deg;</button><button class="btn-secondary" onclick="setAngle(${slot}, 90)">90&deg;</button><button class="btn-secondary" onclick="setAngle(${slot}, 180)">180&deg;</button></div> `; break; case 4: case 5: case 6: // Steppers div.innerHTML = ` <div class="slider-group"><div class="slider-header"><span>Speed (steps/s)</span><span id="stepper-speed-val-${slot}">500</span></div><input type="range" id="stepper-speed-${slot}" min="10" max="2000" value="500" oninput="updateStepperSpeedLabel(${slot})"></div><div style="margin-bottom: 0.5rem;"><label>Target Position</label><input type="number" id="pos-${slot}" value="0"></div><div class="btn-row"><button class="btn-primary" onclick="moveToPosition(${slot})">Go To</button><button class="btn-secondary" onclick="moveRelative(${slot}, -100)">-100</button><button class="btn-secondary" onclick="moveRelative(${slot}, 100)">+100</button><button class="btn-secondary" onclick="homeMotor(${slot})">Home</button></div> `; break; } } function updateSpeedLabel(slot) { const val = document.getElementById(`speed-${slot}`).value; document.getElementById(`speed-val-${slot}`).textContent = `${val}%`; } function updateAngleLabel(slot) { const val = document.getElementById(`angle-${slot}`).value; document.getElementById(`angle-val-${slot}`).innerHTML = `${val}&deg;`; } function updateStepperSpeedLabel(slot) { const val = document.getElementById(`stepper-speed-${slot}`).value; document.getElementById(`stepper-speed-val-${slot}`).textContent = val; } async function configureMotor(slot) { const type = parseInt(document.getElementById(`type-${slot}`).value); if (type === 0) return toast('Select a motor type', true); const pins = {}; MOTOR_TYPES[type].pins.forEach(pin => { pins[pin] = parseInt(document.getElementById(`pin-${slot}-${pin}`).value); }); try { const res = await fetch(`/api/motors/${slot}/configure`, { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: JSON.stringify({ type, pins }) }); const data = await res.json(); if (data.success) { toast(`Motor ${slot} configured as ${MOTOR_TYPES[type].name}`); updateMotorCard(slot, type); } else { toast(data.error || 'Configuration failed', true); } } catch (e) { toast('Connection error', true); } } function updateMotorCard(slot, type) { const card = document.getElementById(`motor-${slot}`); const badge = document.getElementById(`badge-${slot}`); const configForm = document.getElementById(`config-${slot}`); const controlForm = document.getElementById(`control-${slot}`); if (type > 0) { card.classList.add('active'); badge.className = 'motor-type-badge'; badge.textContent = MOTOR_TYPES[type].name; configForm.classList.add('hidden'); controlForm.classList.remove('hidden'); renderControls(slot, type); } else { card.classList.remove('active'); badge.className = 'motor-type-badge none'; badge.textContent = 'Unconfigured'; configForm.classList.remove('hidden'); controlForm.classList.add('hidden'); } } async function removeMotor(slot) { try { await fetch(`/api/motors/${slot}/remove`, { method: 'POST' }); updateMotorCard(slot, 0); toast(`Motor ${slot} removed`); } catch (e) { toast('Error removing motor', true); } } async function sendCommand(slot, command, value = 0, duration = 0) { if (estopActive && command !== 'stop') { return toast('E-Stop active!', true); } try { const res = await fetch(`/api/motors/${slot}/control`, { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: JSON.stringify({ command, value, duration }) }); const data = await res.json(); if (!data.success) toast(data.error || 'Command failed', true); } catch (e) { toast('Connection error', true); } } function setSpeed(slot) { const speed = parseInt(document.getElementById(`speed-${slot}`).value); sendCommand(slot, 'speed', speed * 2.55); // Scale to 0-255 } function setAngle(slot, angle) { if (angle === undefined) { angle = parseInt(document.getElementById(`angle-${slot}`).value); } else { document.getElementById(`angle-${slot}`).value = angle; updateAngleLabel(slot); } sendCommand(slot, 'angle', angle); } function moveToPosition(slot) { const pos = parseInt(document.getElementById(`pos-${slot}`).value); sendCommand(slot, 'position', pos); } function moveRelative(slot, steps) { sendCommand(slot, 'relative', steps); } function stopMotor(slot) { sendCommand(slot, 'stop'); } function brakeMotor(slot) { sendCommand(slot, 'brake'); } function coastMotor(slot) { sendCommand(slot, 'coast'); } function homeMotor(slot) { sendCommand(slot, 'home'); } async function toggleEstop() { const btn = document.getElementById('estopBtn'); try { if (estopActive) { await fetch('/api/system/estop/reset', { method: 'POST' }); } else { await fetch('/api/system/estop', { method: 'POST' }); } } catch (e) { toast('Connection error', true); } } function updateEstopState(active) { estopActive = active; const btn = document.getElementById('estopBtn'); btn.classList.toggle('active', active); btn.textContent = active ? 'RESET E-STOP' : 'E-STOP'; document.querySelectorAll('.motor-card').forEach(card => { card.classList.toggle('estop', active); }); } async function pollStatus() { try { const res = await fetch('/api/status'); const data = await res.json(); // Update connection status document.getElementById('connDot').className = 'dot'; document.getElementById('connStatus').textContent = 'Connected'; // Update system info document.getElementById('heapFree').textContent = Math.round(data.system.heap / 1024) + ' KB'; document.getElementById('uptime').textContent = formatUptime(data.system.uptime); document.getElementById('version').textContent = data.system.version; // Update E-stop state if (data.safety) { updateEstopState(data.safety.estopActive); } // Update motor states if (data.motors && data.motors.slots) { data.motors.slots.forEach((slot, i) => { motorState[i] = slot; if (slot.configured) { updateMotorCard(i, slot.type); updateMotorStatus(i, slot); } }); } } catch (e) { document.getElementById('connDot').className = 'dot danger'; document.getElementById('connStatus').textContent = 'Disconnected'; } } function updateMotorStatus(slot, data) { const statusDiv = document.getElementById(`status-${slot}`); if (!statusDiv) return; statusDiv.innerHTML = ` <div class="status-item"><span class="status-label">Position</span><span class="status-value">${data.position || 0}</span></div><div class="status-item"><span class="status-label">Speed</span><span class="status-value">${data.speed || 0}</span></div><div class="status-item"><span class="status-label">Moving</span><span class="status-value">${data.moving ? 'Yes' : 'No'}</span></div><div class="status-item"><span class="status-label">Enabled</span><span class="status-value">${data.enabled ? 'Yes' : 'No'}</span></div> `; } function formatUptime(seconds) { const h = Math.floor(seconds / 3600); const m = Math.floor((seconds % 3600) / 60); const s = seconds % 60; return `${h}h ${m}m ${s}s`; } function startPolling() { pollStatus(); pollInterval = setInterval(pollStatus, 500); } function toast(msg, isError = false) { const t = document.getElementById('toast'); t.textContent = msg; t.className = 'toast' + (isError ? ' error' : ''); setTimeout(() => t.classList.add('hidden'), 3000); } // Initialize on load document.addEventListener('DOMContentLoaded', init); </script></body></html>
+<!DOCTYPE html><html lang="en"><head><meta charset="UTF-8"><meta name="viewport" content="width=device-width, initial-scale=1.0"><title>Motor Controller</title><style> * { box-sizing: border-box; margin: 0; padding: 0; } :root { --bg: #1a1a2e; --card: #16213e; --accent: #0f3460; --highlight: #e94560; --text: #eee; --muted: #888; --success: #4ade80; --warning: #fbbf24; --danger: #ef4444; } body { font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif; background: var(--bg); color: var(--text); min-height: 100vh; padding: 1rem; } header { display: flex; justify-content: space-between; align-items: center; padding: 1rem; background: var(--card); border-radius: 8px; margin-bottom: 1rem; } header h1 { font-size: 1.5rem; } .status-bar { display: flex; gap: 1rem; align-items: center; } .status-indicator { display: flex; align-items: center; gap: 0.5rem; font-size: 0.875rem; } .dot { width: 10px; height: 10px; border-radius: 50%; background: var(--success); } .dot.warning { background: var(--warning); } .dot.danger { background: var(--danger); } nav { display: flex; gap: 0.5rem; margin-bottom: 1rem; } nav a { padding: 0.75rem 1.5rem; background: var(--card); color: var(--text); text-decoration: none; border-radius: 8px; transition: background 0.2s; } nav a:hover, nav a.active { background: var(--accent); } .estop-btn { background: var(--danger); color: white; border: none; padding: 0.75rem 2rem; font-size: 1rem; font-weight: bold; border-radius: 8px; cursor: pointer; text-transform: uppercase; transition: transform 0.1s, box-shadow 0.1s; } .estop-btn:hover { transform: scale(1.05); box-shadow: 0 0 20px rgba(239,68,68,0.5); } .estop-btn:active { transform: scale(0.98); } .estop-btn.active { animation: pulse 1s infinite; } @keyframes pulse { 0%, 100% { box-shadow: 0 0 10px rgba(239,68,68,0.5); } 50% { box-shadow: 0 0 30px rgba(239,68,68,0.8); } } .motor-grid { display: grid; grid-template-columns: repeat(auto-fit, minmax(320px, 1fr)); gap: 1rem; } .motor-card { background: var(--card); border-radius: 12px; padding: 1.25rem; border: 2px solid transparent; transition: border-color 0.2s; } .motor-card.active { border-color: var(--highlight); } .motor-card.estop { border-color: var(--danger); opacity: 0.7; } .card-header { display: flex; justify-content: space-between; align-items: center; margin-bottom: 1rem; } .card-header h3 { font-size: 1.1rem; } .motor-type-badge { padding: 0.25rem 0.75rem; background: var(--accent); border-radius: 20px; font-size: 0.75rem; text-transform: uppercase; } .motor-type-badge.none { background: var(--muted); } .config-form, .control-form { display: flex; flex-direction: column; gap: 0.75rem; } label { font-size: 0.875rem; color: var(--muted); margin-bottom: 0.25rem; display: block; } select, input[type="number"], input[type="text"] { width: 100%; padding: 0.625rem; background: var(--bg); border: 1px solid var(--accent); border-radius: 6px; color: var(--text); font-size: 0.9rem; } select:focus, input:focus { outline: none; border-color: var(--highlight); } .pin-grid { display: grid; grid-template-columns: repeat(2, 1fr); gap: 0.5rem; } .pin-input { display: flex; flex-direction: column; } .btn-row { display: flex; gap: 0.5rem; margin-top: 0.5rem; } button { padding: 0.625rem 1rem; border: none; border-radius: 6px; cursor: pointer; font-size: 0.875rem; transition: background 0.2s, transform 0.1s; } button:active { transform: scale(0.97); } .btn-primary { background: var(--highlight); color: white; } .btn-primary:hover { background: #d63d56; } .btn-secondary { background: var(--accent); color: var(--text); } .btn-secondary:hover { background: #1a4980; } .btn-danger { background: var(--danger); color: white; } .btn-stop { background: var(--warning); color: #000; font-weight: bold; } .slider-group { margin: 0.75rem 0; } .slider-header { display: flex; justify-content: space-between; margin-bottom: 0.5rem; } input[type="range"] { width: 100%; height: 8px; -webkit-appearance: none; background: var(--bg); border-radius: 4px; outline: none; } input[type="range"]::-webkit-slider-thumb { -webkit-appearance: none; width: 20px; height: 20px; background: var(--highlight); border-radius: 50%; cursor: pointer; } .motor-status { margin-top: 1rem; padding-top: 1rem; border-top: 1px solid var(--accent); display: grid; grid-template-columns: repeat(2, 1fr); gap: 0.5rem; font-size: 0.8rem; } .status-item { display: flex; justify-content: space-between; } .status-label { color: var(--muted); } .status-value { font-family: monospace; } .quick-controls { display: flex; gap: 0.5rem; flex-wrap: wrap; margin-top: 0.75rem; } .quick-btn { flex: 1; min-width: 60px; padding: 0.5rem; font-size: 0.8rem; } .system-info { background: var(--card); border-radius: 8px; padding: 1rem; margin-top: 1rem; display: flex; justify-content: space-around; flex-wrap: wrap; gap: 1rem; } .info-item { text-align: center; } .info-value { font-size: 1.5rem; font-weight: bold; color: var(--highlight); } .info-label { font-size: 0.75rem; color: var(--muted); text-transform: uppercase; } .hidden { display: none !important; } .toast { position: fixed; bottom: 2rem; left: 50%; transform: translateX(-50%); background: var(--card); padding: 1rem 2rem; border-radius: 8px; border-left: 4px solid var(--success); animation: slideUp 0.3s; } .toast.error { border-color: var(--danger); } @keyframes slideUp { from { opacity: 0; transform: translate(-50%, 20px); } to { opacity: 1; transform: translate(-50%, 0); } } </style></head><body><header><h1>Motor Controller</h1><div class="status-bar"><div class="status-indicator"><span class="dot" id="connDot"></span><span id="connStatus">Connected</span></div><button class="estop-btn" id="estopBtn" onclick="toggleEstop()">E-STOP</button></div></header><nav><a href="/" class="active">Dashboard</a><a href="/presets">Presets</a><a href="/settings">Settings</a></nav><div class="motor-grid" id="motorGrid"></div><div class="system-info"><div class="info-item"><div class="info-value" id="heapFree">--</div><div class="info-label">Heap Free</div></div><div class="info-item"><div class="info-value" id="uptime">--</div><div class="info-label">Uptime</div></div><div class="info-item"><div class="info-value" id="version">--</div><div class="info-label">Version</div></div></div><div id="toast" class="toast hidden"></div><script> const MOTOR_TYPES = { 0: { name: 'None', pins: [] }, 1: { name: 'DC L298N', pins: ['in1', 'in2', 'ena'] }, 2: { name: 'DC L9110S', pins: ['ia', 'ib'] }, 3: { name: 'Servo', pins: ['signal'] }, 4: { name: 'Stepper A4988', pins: ['step', 'dir', 'enable'] }, 5: { name: 'Stepper DRV8825', pins: ['step', 'dir', 'enable'] }, 6: { name: 'Stepper ULN2003', pins: ['in1', 'in2', 'in3', 'in4'] } }; const DEFAULT_PINS = [ { in1: 13, in2: 12, ena: 14, ia: 13, ib: 12, signal: 13, step: 13, dir: 12, enable: 14 }, { in1: 27, in2: 26, ena: 25, ia: 27, ib: 26, signal: 27, step: 27, dir: 26, enable: 25 }, { in1: 33, in2: 32, ena: 35, ia: 33, ib: 32, signal: 33, step: 33, dir: 32, enable: 35 }, { in1: 19, in2: 18, ena: 5, ia: 19, ib: 18, signal: 19, step: 19, dir: 18, enable: 5 } ]; let motorState = [{}, {}, {}, {}]; let estopActive = false; let pollInterval; function init() { renderMotorCards(); startPolling(); } function renderMotorCards() { const grid = document.getElementById('motorGrid'); grid.innerHTML = ''; for (let i = 0; i < 4; i++) { grid.appendChild(createMotorCard(i)); } } function createMotorCard(slot) { const card = document.createElement('div'); card.className = 'motor-card'; card.id = `motor-${slot}`; card.innerHTML = ` <div class="card-header"><h3>Motor Slot ${slot}</h3><span class="motor-type-badge none" id="badge-${slot}">Unconfigured</span></div><div class="config-form" id="config-${slot}"><div><label>Motor Type</label><select id="type-${slot}" onchange="onTypeChange(${slot})"> ${Object.entries(MOTOR_TYPES).map(([k,v]) => `<option value="${k}">${v.name}</option>`).join('')} </select></div><div class="pin-grid" id="pins-${slot}"></div><div class="btn-row"><button class="btn-primary" onclick="configureMotor(${slot})">Configure</button><button class="btn-danger" onclick="removeMotor(${slot})">Remove</button></div></div><div class="control-form hidden" id="control-${slot}"><div id="controls-${slot}"></div><div class="quick-controls"><button class="quick-btn btn-stop" onclick="stopMotor(${slot})">STOP</button><button class="quick-btn btn-secondary" onclick="brakeMotor(${slot})">Brake</button><button class="quick-btn btn-secondary" onclick="coastMotor(${slot})">Coast</button></div><div class="motor-status" id="status-${slot}"></div></div> `; return card; } function onTypeChange(slot) { const type = parseInt(document.getElementById(`type-${slot}`).value); const pinsDiv = document.getElementById(`pins-${slot}`); const pins = MOTOR_TYPES[type].pins; if (pins.length === 0) { pinsDiv.innerHTML = ''; return; } pinsDiv.innerHTML = pins.map(pin => ` <div class="pin-input"><label>${pin.toUpperCase()}</label><input type="number" id="pin-${slot}-${pin}" value="${DEFAULT_PINS[slot][pin] || 0}" min="0" max="39"></div> `).join(''); } function renderControls(slot, type) { const div = document.getElementById(`controls-${slot}`); switch(type) { case 1: case 2: // DC motors div.innerHTML = ` <div class="slider-group"><div class="slider-header"><span>Speed</span><span id="speed-val-${slot}">0%</span></div><input type="range" id="speed-${slot}" min="-100" max="100" value="0" oninput="updateSpeedLabel(${slot})" onchange="setSpeed(${slot})"></div> `; break; case 3: // Servo div.innerHTML = ` <div class="slider-group"><div class="slider-header"><span>Angle</span><span id="angle-val-${slot}">90&deg;</span></div><input type="range" id="angle-${slot}" min="0" max="180" value="90" oninput="updateAngleLabel(${slot})" onchange="setAngle(${slot})"></div><div class="btn-row"><button class="btn-secondary" onclick="setAngle(${slot}, 0)">0&deg;</button><button class="btn-secondary" onclick="setAngle(${slot}, 90)">90&deg;</button><button class="btn-secondary" onclick="setAngle(${slot}, 180)">180&deg;</button></div> `; break; case 4: case 5: case 6: // Steppers div.innerHTML = ` <div class="slider-group"><div class="slider-header"><span>Speed (steps/s)</span><span id="stepper-speed-val-${slot}">500</span></div><input type="range" id="stepper-speed-${slot}" min="10" max="2000" value="500" oninput="updateStepperSpeedLabel(${slot})"></div><div style="margin-bottom: 0.5rem;"><label>Target Position</label><input type="number" id="pos-${slot}" value="0"></div><div class="btn-row"><button class="btn-primary" onclick="moveToPosition(${slot})">Go To</button><button class="btn-secondary" onclick="moveRelative(${slot}, -100)">-100</button><button class="btn-secondary" onclick="moveRelative(${slot}, 100)">+100</button><button class="btn-secondary" onclick="homeMotor(${slot})">Home</button></div> `; break; } } function updateSpeedLabel(slot) { const val = document.getElementById(`speed-${slot}`).value; document.getElementById(`speed-val-${slot}`).textContent = `${val}%`; } function updateAngleLabel(slot) { const val = document.getElementById(`angle-${slot}`).value; document.getElementById(`angle-val-${slot}`).innerHTML = `${val}&deg;`; } function updateStepperSpeedLabel(slot) { const val = document.getElementById(`stepper-speed-${slot}`).value; document.getElementById(`stepper-speed-val-${slot}`).textContent = val; } async function configureMotor(slot) { const type = parseInt(document.getElementById(`type-${slot}`).value); if (type === 0) return toast('Select a motor type', true); const pins = {}; MOTOR_TYPES[type].pins.forEach(pin => { pins[pin] = parseInt(document.getElementById(`pin-${slot}-${pin}`).value); }); try { const res = await fetch(`/api/motors/${slot}/configure`, { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: JSON.stringify({ type, pins }) }); const data = await res.json(); if (data.success) { toast(`Motor ${slot} configured as ${MOTOR_TYPES[type].name}`); updateMotorCard(slot, type); } else { toast(data.error || 'Configuration failed', true); } } catch (e) { toast('Connection error', true); } } function updateMotorCard(slot, type) { const card = document.getElementById(`motor-${slot}`); const badge = document.getElementById(`badge-${slot}`); const configForm = document.getElementById(`config-${slot}`); const controlForm = document.getElementById(`control-${slot}`); if (type > 0) { card.classList.add('active'); badge.className = 'motor-type-badge'; badge.textContent = MOTOR_TYPES[type].name; configForm.classList.add('hidden'); controlForm.classList.remove('hidden'); renderControls(slot, type); } else { card.classList.remove('active'); badge.className = 'motor-type-badge none'; badge.textContent = 'Unconfigured'; configForm.classList.remove('hidden'); controlForm.classList.add('hidden'); } } async function removeMotor(slot) { try { await fetch(`/api/motors/${slot}/remove`, { method: 'POST' }); updateMotorCard(slot, 0); toast(`Motor ${slot} removed`); } catch (e) { toast('Error removing motor', true); } } async function sendCommand(slot, command, value = 0, duration = 0) { if (estopActive && command !== 'stop') { return toast('E-Stop active!', true); } try { const res = await fetch(`/api/motors/${slot}/control`, { method: 'POST', headers: { 'Content-Type': 'application/json' }, body: JSON.stringify({ command, value, duration }) }); const data = await res.json(); if (!data.success) toast(data.error || 'Command failed', true); } catch (e) { toast('Connection error', true); } } function setSpeed(slot) { const speed = parseInt(document.getElementById(`speed-${slot}`).value); sendCommand(slot, 'speed', Math.round(speed * (motorState[slot].maxDuty || 255) / 100)); // Scale to the slot's PWM range } function setAngle(slot, angle) { if (angle === undefined) { angle = parseInt(document.getElementById(`angle-${slot}`).value); } else { document.getElementById(`angle-${slot}`).value = angle; updateAngleLabel(slot); } sendCommand(slot, 'angle', angle); } function moveToPosition(slot) { const pos = parseInt(document.getElementById(`pos-${slot}`).value); sendCommand(slot, 'position', pos); } function moveRelative(slot, steps) { sendCommand(slot, 'relative', steps); } function stopMotor(slot) { sendCommand(slot, 'stop'); } function brakeMotor(slot) { sendCommand(slot, 'brake'); } function coastMotor(slot) { sendCommand(slot, 'coast'); } function homeMotor(slot) { sendCommand(slot, 'home'); } async function toggleEstop() { const btn = document.getElementById('estopBtn'); try { if (estopActive) { await fetch('/api/system/estop/reset', { method: 'POST' }); } else { await fetch('/api/system/estop', { method: 'POST' }); } } catch (e) { toast('Connection error', true); } } function updateEstopState(active) { estopActive = active; const btn = document.getElementById('estopBtn'); btn.classList.toggle('active', active); btn.textContent = active ? 'RESET E-STOP' : 'E-STOP'; document.querySelectorAll('.motor-card').forEach(card => { card.classList.toggle('estop', active); }); } async function pollStatus() { try { const res = await fetch('/api/status'); const data = await res.json(); // Update connection status document.getElementById('connDot').className = 'dot'; document.getElementById('connStatus').textContent = 'Connected'; // Update system info document.getElementById('heapFree').textContent = Math.round(data.system.heap / 1024) + ' KB'; document.getElementById('uptime').textContent = formatUptime(data.system.uptime); document.getElementById('version').textContent = data.system.version; // Update E-stop state if (data.safety) { updateEstopState(data.safety.estopActive); } // Update motor states if (data.motors && data.motors.slots) { data.motors.slots.forEach((slot, i) => { motorState[i] = slot; if (slot.configured) { updateMotorCard(i, slot.type); updateMotorStatus(i, slot); } }); } } catch (e) { document.getElementById('connDot').className = 'dot danger'; document.getElementById('connStatus').textContent = 'Disconnected'; } } function updateMotorStatus(slot, data) { const statusDiv = document.getElementById(`status-${slot}`); if (!statusDiv) return; statusDiv.innerHTML = ` <div class="status-item"><span class="status-label">Position</span><span class="status-value">${data.position || 0}</span></div><div class="status-item"><span class="status-label">Speed</span><span class="status-value">${data.speed || 0}</span></div><div class="status-item"><span class="status-label">Moving</span><span class="status-value">${data.moving ? 'Yes' : 'No'}</span></div><div class="status-item"><span class="status-label">Enabled</span><span class="status-value">${data.enabled ? 'Yes' : 'No'}</span></div> `; } function formatUptime(seconds) { const h = Math.floor(seconds / 3600); const m = Math.floor((seconds % 3600) / 60); const s = seconds % 60; return `${h}h ${m}m ${s}s`; } function startPolling() { pollStatus(); pollInterval = setInterval(pollStatus, 500); } function toast(msg, isError = false) { const t = document.getElementById('toast'); t.textContent = msg; t.className = 'toast' + (isError ? ' error' : ''); setTimeout(() => t.classList.add('hidden'), 3000); } // Initialize on load document.addEventListener('DOMContentLoaded', init); </script></body></html>
 )rawliteral";
 
 const char PAGE_SETTINGS[] PROGMEM = R"rawliteral(
@@ -35,7 +35,7 @@ if ! arduino-cli core list | grep -q "esp32:esp32"; then
 fi
 
 # Check/install required libraries
-LIBS=("ArduinoJson" "ESP32Servo" "AccelStepper" "ESP32Encoder")
+LIBS=("ArduinoJson" "ESP32Encoder")
 for lib in "${LIBS[@]}"; do
     if ! arduino-cli lib list | grep -q "$lib"; then
         echo -e "${YELLOW}Installing $lib library...${NC}"
@@ -0,0 +1,36 @@
+#!/bin/bash
+# Build and run the control kernel checks on the host
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
+BENCH_DIR="$PROJECT_ROOT/firmware/bench"
+BUILD_DIR="${BUILD_DIR:-/tmp/motor_bench}"
+CXX="${CXX:-g++}"
+
+# Colors
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+echo -e "${GREEN}================================${NC}"
+echo -e "${GREEN}  Control Kernel Checks${NC}"
+echo -e "${GREEN}================================${NC}"
+echo ""
+
+if ! command -v "$CXX" &> /dev/null; then
+    echo -e "${RED}Error: $CXX not found${NC}"
+    exit 1
+fi
+
+mkdir -p "$BUILD_DIR"
+
+echo -e "${YELLOW}Compiling with $CXX...${NC}"
+"$CXX" -std=c++17 -O2 -Wall -Wextra \
+    "$BENCH_DIR/kernel_check.cpp" \
+    -o "$BUILD_DIR/kernel_check" -lm
+
+echo ""
+"$BUILD_DIR/kernel_check" "$@"